@@ -0,0 +1,87 @@
+// Cycles per output sample of the capture rate to olaf rate decimator, src/audio_decimator.c
+// built without CMSIS-DSP. host/check_decimator.cpp checks its results.
+//
+// Usage: bench_decimator [seconds]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "audio_decimator.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_CYCLE_COUNTER 1
+static std::uint64_t cycles() { return __rdtsc(); }
+#else
+#define HAS_CYCLE_COUNTER 0
+static std::uint64_t cycles() { return 0; }
+#endif
+
+namespace
+{
+
+constexpr int olaf_rate = 16000;
+constexpr int step_size = 128;
+
+void run(int factor, double seconds)
+{
+  const int rate = olaf_rate * factor;
+  const std::size_t block = static_cast<std::size_t>(step_size) * factor;
+
+  std::mt19937 generator(factor);
+  std::uniform_int_distribution<int> distribution(-20000, 20000);
+  std::vector<std::int16_t> in(static_cast<std::size_t>(seconds * rate) / block * block);
+  for (auto & sample : in) {
+    sample = static_cast<std::int16_t>(distribution(generator));
+  }
+
+  std::vector<std::int16_t> state(AUDIO_DECIMATOR_STATE_LENGTH(block));
+  audio_decimator decimator;
+  audio_decimator_init(&decimator, factor, state.data(), block);
+  std::vector<std::int16_t> out(in.size() / factor);
+
+  const auto start = std::chrono::steady_clock::now();
+  const std::uint64_t start_cycles = cycles();
+  for (std::size_t i = 0; i < in.size(); i += block) {
+    audio_decimator_process(&decimator, in.data() + i, out.data() + i / factor);
+  }
+  const std::uint64_t stop_cycles = cycles();
+  const auto stop = std::chrono::steady_clock::now();
+
+  const std::size_t produced = out.size();
+  const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+  std::printf(
+    "%5d Hz -> %d Hz: %d taps, %zu outputs, %.2f ns/output", rate, olaf_rate,
+    factor * AUDIO_DECIMATOR_TAPS_PER_PHASE, produced, ns / produced);
+  if (HAS_CYCLE_COUNTER) {
+    std::printf(
+      ", %.2f TSC cycles/output", static_cast<double>(stop_cycles - start_cycles) / produced);
+  }
+  std::printf(", %.0fx real time\n", seconds * 1e9 / ns);
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const double seconds = argc > 1 ? std::atof(argv[1]) : 60.0;
+
+#if defined(__AVX2__)
+  std::printf("SIMD: AVX2\n");
+#elif defined(__SSE2__)
+  std::printf("SIMD: SSE2\n");
+#elif defined(__ARM_NEON)
+  std::printf("SIMD: NEON\n");
+#else
+  std::printf("SIMD: scalar\n");
+#endif
+
+  for (int factor = 2; factor <= AUDIO_DECIMATOR_MAX_FACTOR; ++factor) {
+    run(factor, seconds);
+  }
+  return 0;
+}
@@ -0,0 +1,116 @@
+// Per stage timing of the fingerprinting pipeline, built with OLAF_PROFILE.
+//
+// Indexes synthetic songs into a DB, then plays noisy excerpts of them and of
+// songs that are not in the DB through one olaf::FingerprintStream. Prints
+// count/min/avg/max/p99 per stage and the average time a stage takes per
+// analysis step, next to the time one step may take in real time.
+//
+// Usage: bench_stages [--config default|esp32|mem|mem-tracking] [songs] [seconds per excerpt]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "host_audio.hpp"
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+#include "olaf_profile.h"
+#include "olaf_stop_list.hpp"
+#include "olaf_stream_pool.hpp"
+
+int main(int argc, char ** argv)
+{
+  std::string profile = "mem";
+  std::vector<const char *> positional;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+      profile = argv[++i];
+    } else {
+      positional.push_back(argv[i]);
+    }
+  }
+  const int songs = positional.size() > 0 ? std::atoi(positional[0]) : 20;
+  const int seconds = positional.size() > 1 ? std::atoi(positional[1]) : 20;
+
+  olaf::Config config;
+  if (profile == "default") {
+    config = olaf::Config::create_default();
+  } else if (profile == "esp32") {
+    config = olaf::Config::create_esp_32();
+  } else if (profile == "mem") {
+    config = olaf::Config::create_mem();
+  } else if (profile == "mem-tracking") {
+    config = olaf::Config::create_mem_tracking();
+  } else {
+    std::fprintf(stderr, "Unknown config profile %s\n", profile.c_str());
+    return 1;
+  }
+  config.printResultEvery = 0;
+  config.verbose = false;
+  // the stop-list threshold of index_store
+  config.maxHashOccurrences = 50;
+
+  std::vector<std::vector<std::uint64_t>> fingerprints;
+  olaf::StopListBuilder stop_list_builder;
+  for (int i = 0; i < songs; ++i) {
+    const auto song =
+      host::synthetic_song(static_cast<std::uint32_t>(i + 1), 60, config.audioSampleRate);
+    fingerprints.push_back(host::index_audio(config, song));
+    stop_list_builder.add_song(fingerprints.back());
+  }
+  // the DB keeps a view of the stop-list
+  const std::vector<std::uint64_t> stop_list = stop_list_builder.build(config);
+  olaf::DB db;
+  for (int i = 0; i < songs; ++i) {
+    db.register_audio(
+      static_cast<std::uint32_t>(i + 1), fingerprints[i].data(), fingerprints[i].size());
+  }
+  db.set_stop_list(stop_list);
+
+  // indexing ran through the same extractors, only the queries are measured
+  olaf_profile_init();
+  olaf::FingerprintStream stream(config, db, [](int, float, float, std::uint32_t, float, float) {});
+  const std::size_t length = static_cast<std::size_t>(seconds) * config.audioSampleRate;
+  for (int i = 0; i < songs + songs / 4; ++i) {
+    // a quarter of the excerpts come from songs that are not in the DB
+    auto excerpt = host::synthetic_song(
+      static_cast<std::uint32_t>(i < songs ? i + 1 : 1000 + i), seconds + 10,
+      config.audioSampleRate);
+    excerpt.erase(excerpt.begin(), excerpt.begin() + (excerpt.size() - length));
+    host::add_noise(excerpt, 20, static_cast<std::uint32_t>(i));
+    stream.reset();
+    for (std::size_t s = 0; s < excerpt.size(); s += config.audioStepSize) {
+      stream.process(
+        excerpt.data() + s, std::min<std::size_t>(config.audioStepSize, excerpt.size() - s));
+    }
+  }
+
+  olaf_profile_stats block;
+  if (!olaf_profile_get(OLAF_STAGE_BLOCK, &block)) {
+    std::fprintf(stderr, "No measurements, build with OLAF_PROFILE defined\n");
+    return 1;
+  }
+
+  const double step_budget = 1e9 * config.audioStepSize / config.audioSampleRate;
+  std::printf(
+    "Profile %s, %d songs, %u steps, times in " OLAF_PROFILE_TICK_UNIT
+    ", real time budget %.0f ns per step\n",
+    profile.c_str(), songs, block.count, step_budget);
+  std::printf(
+    "%-11s %9s %8s %8s %8s %8s %10s %7s\n", "stage", "count", "min", "avg", "max", "p99", "per step",
+    "share");
+  for (int stage = 0; stage < OLAF_STAGE_COUNT; ++stage) {
+    olaf_profile_stats stats;
+    if (!olaf_profile_get(static_cast<olaf_profile_stage>(stage), &stats)) continue;
+    const double per_step = static_cast<double>(stats.total) / block.count;
+    std::printf(
+      "%-11s %9u %8u %8u %8u %8u %10.0f %6.1f%%\n",
+      olaf_profile_stage_name(static_cast<olaf_profile_stage>(stage)), stats.count, stats.min,
+      stats.avg, stats.max, stats.p99, per_step, 100.0 * stats.total / block.total);
+  }
+  return 0;
+}
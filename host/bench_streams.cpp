@@ -0,0 +1,143 @@
+// Streams sustained per core when fingerprinting many streams against one shared DB.
+//
+// Builds a DB from synthetic songs, then plays excerpts of them on an
+// increasing number of streams, as fast as the pool processes them. A stream
+// needs one second of processing per second of audio, so the real time factor
+// of all streams together divided by the threads is the number of streams one
+// core sustains.
+//
+// With an arena size every stream allocates from its own olaf::Arena instead
+// of the heap, and the bytes used are reported.
+//
+// Usage: bench_streams [songs] [seconds per stream] [max streams] [arena KiB per stream]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "host_audio.hpp"
+#include "olaf_db.hpp"
+#include "olaf_stream_pool.hpp"
+
+namespace
+{
+
+constexpr int sample_rate = 16000;
+
+struct Result
+{
+  double real_time_factor;
+  std::size_t identified;
+  std::size_t max_arena_used;
+};
+
+Result run(
+  const olaf::Config & config, const olaf::DB & db,
+  const std::vector<std::vector<std::int16_t>> & songs, std::size_t streams, std::size_t threads,
+  int seconds, std::size_t arena_bytes)
+{
+  olaf::StreamPool pool(config, db, threads, arena_bytes);
+
+  // each stream plays a different excerpt with some noise, prepared up front
+  std::vector<std::vector<std::int16_t>> excerpts(streams);
+  std::mt19937 generator(static_cast<std::uint32_t>(streams));
+  std::normal_distribution<float> noise(0, 50);
+  for (std::size_t s = 0; s < streams; ++s) {
+    const auto & song = songs[s % songs.size()];
+    const std::size_t length = static_cast<std::size_t>(seconds) * sample_rate;
+    const std::size_t offset =
+      (s * 7919 * sample_rate / 10) % (song.size() - length) / config.audioStepSize *
+      config.audioStepSize;
+    excerpts[s].resize(length);
+    for (std::size_t i = 0; i < length; ++i) {
+      excerpts[s][i] = static_cast<std::int16_t>(
+        std::clamp(song[offset + i] + noise(generator), -32768.0f, 32767.0f));
+    }
+    pool.add_stream([](int, float, float, std::uint32_t, float, float) {});
+  }
+
+  // audio arrives in capture sized chunks, interleaved over the streams
+  constexpr std::size_t chunk = 1024;
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < excerpts[0].size(); i += chunk) {
+    const std::size_t n = std::min(chunk, excerpts[0].size() - i);
+    for (std::size_t s = 0; s < streams; ++s) {
+      pool.push(s, excerpts[s].data() + i, n);
+    }
+  }
+  pool.wait_idle();
+  const double elapsed =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  Result result = {streams * static_cast<double>(seconds) / elapsed, 0, 0};
+  for (std::size_t s = 0; s < streams; ++s) {
+    result.max_arena_used = std::max(result.max_arena_used, pool.get_arena_used(s));
+    olaf::FPMatcher & matcher = pool.get_stream(s).matcher();
+    if (
+      matcher.is_decided() &&
+      matcher.get_decided_result().match_identifier == s % songs.size() + 1) {
+      result.identified++;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const std::size_t song_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50;
+  const int seconds = argc > 2 ? std::atoi(argv[2]) : 20;
+  const std::size_t max_streams = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 64;
+  const std::size_t arena_bytes = argc > 4 ? std::strtoul(argv[4], nullptr, 10) * 1024 : 0;
+  const std::size_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  olaf::Config config = olaf::Config::create_default();
+  config.printResultEvery = 0;
+  // decide like the live profile so identification can be checked
+  config.minMatchConfidence = 4;
+
+  std::vector<std::vector<std::int16_t>> songs;
+  std::vector<std::vector<std::uint64_t>> fingerprints;
+  olaf::DB db;
+  for (std::size_t i = 0; i < song_count; ++i) {
+    songs.push_back(host::synthetic_song(static_cast<std::uint32_t>(i + 1), 120, sample_rate));
+    fingerprints.push_back(host::index_audio(config, songs.back()));
+  }
+  for (std::size_t i = 0; i < song_count; ++i) {
+    db.register_audio(
+      static_cast<std::uint32_t>(i + 1), fingerprints[i].data(), fingerprints[i].size());
+  }
+  std::printf(
+    "%zu songs, %zu fingerprints, %d s per stream, %zu hardware threads\n", song_count,
+    db.get_total_fingerprints(), seconds, hardware_threads);
+
+  std::vector<std::size_t> thread_counts = {1};
+  for (std::size_t t = 2; t < hardware_threads; t *= 2) {
+    thread_counts.push_back(t);
+  }
+  if (hardware_threads > 1) {
+    thread_counts.push_back(hardware_threads);
+  }
+
+  for (std::size_t threads : thread_counts) {
+    for (std::size_t streams = threads; streams <= max_streams; streams *= 2) {
+      const Result result = run(config, db, songs, streams, threads, seconds, arena_bytes);
+      std::printf(
+        "%2zu threads %3zu streams: %7.1fx real time, %6.1f streams/core, %zu/%zu identified",
+        threads, streams, result.real_time_factor, result.real_time_factor / threads,
+        result.identified, streams);
+      if (arena_bytes > 0) {
+        std::printf(", arena %zu KiB", result.max_arena_used / 1024);
+      }
+      std::printf("\n");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,292 @@
+// Compares the two voting backends of the matcher.
+//
+// Indexes setlists of synthetic songs and looks up the fingerprints of noisy
+// excerpts once. The database hits are then counted again and again by
+// olaf::MapVotes (hash map of offset candidates) and olaf::HistogramVotes
+// (dense offset histogram per song). Prints votes counted per second, the
+// peak memory of the votes and the largest number of candidates, and how many
+// excerpts olaf::FPMatcher and olaf::HistogramFPMatcher identify.
+//
+// Usage: bench_voting [--config default|esp32|mem|mem-tracking] [excerpts per setlist]
+//                     [seconds per excerpt]
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "host_audio.hpp"
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+#include "olaf_ep_extractor.hpp"
+#include "olaf_fixed_point.hpp"
+#include "olaf_fp_extractor.hpp"
+#include "olaf_fp_matcher.hpp"
+
+namespace
+{
+
+// Forwards to the heap and keeps track of the bytes in use
+class CountingResource : public std::pmr::memory_resource
+{
+private:
+  std::size_t in_use_ = 0;
+  std::size_t peak_ = 0;
+
+  void * do_allocate(std::size_t bytes, std::size_t alignment) override
+  {
+    in_use_ += bytes;
+    peak_ = std::max(peak_, in_use_);
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void * pointer, std::size_t bytes, std::size_t alignment) override
+  {
+    in_use_ -= bytes;
+    std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override
+  {
+    return this == &other;
+  }
+
+public:
+  std::size_t peak() const { return peak_; }
+};
+
+struct Vote
+{
+  int query_t1;
+  int reference_t1;
+  std::uint32_t audio_id;
+};
+
+// An excerpt as the matcher sees it: the fingerprints of every block, and the
+// database hits those fingerprints vote with
+struct Query
+{
+  std::vector<std::vector<olaf::Fingerprint>> fingerprints;
+  std::vector<std::vector<Vote>> votes;
+  std::vector<int> query_times;
+  std::size_t vote_count = 0;
+};
+
+Query extract_query(
+  const olaf::Config & config, const olaf::DB & db, const std::vector<std::int16_t> & audio)
+{
+  const std::vector<std::int16_t> window = host::window_q15(config.audioBlockSize);
+  olaf::FixedPointRFFT<std::int32_t> fft(config.audioBlockSize);
+  olaf::EPExtractorQ31 ep_extractor(config, fft.fraction_bits());
+  olaf::FPExtractor fp_extractor(config);
+  std::vector<std::int32_t> fft_in(config.audioBlockSize), fft_out(2 * config.audioBlockSize);
+  olaf::FingerprintBatch batch;
+  std::vector<std::uint64_t> results;
+
+  Query query;
+  int block_index = 0;
+  for (std::size_t start = 0; start + config.audioBlockSize <= audio.size();
+       start += config.audioStepSize, ++block_index) {
+    olaf::apply_window(audio.data() + start, window.data(), fft_in.data(), fft_in.size());
+    fft.transform(fft_in.data(), fft_out.data());
+    ep_extractor.extract(fft_out.data(), block_index);
+    fp_extractor.extract(ep_extractor.event_points(), block_index);
+
+    auto & fingerprints = fp_extractor.get_fingerprints();
+    auto first = fingerprints.fingerprints.begin();
+    auto last = first + fingerprints.fingerprint_index;
+    query.fingerprints.emplace_back(first, last);
+    query.query_times.push_back(first != last ? (last - 1)->time_index3 : -1);
+
+    batch.assign(fingerprints);
+    batch.hash(config.hashLayout);
+    std::vector<Vote> & votes = query.votes.emplace_back();
+    for (std::size_t i = 0; i < batch.size; ++i) {
+      db.find(
+        batch.hashes[i] - config.searchRange, batch.hashes[i] + config.searchRange, results,
+        config.maxDBCollisions);
+      for (const std::uint64_t result : results) {
+        votes.push_back(
+          {batch.t1[i], static_cast<int>(result >> 32), static_cast<std::uint32_t>(result)});
+      }
+    }
+    query.vote_count += votes.size();
+    fingerprints.fingerprint_index = 0;
+  }
+  return query;
+}
+
+// The counting part of the matcher's tally, without confidence or tracking
+template <typename Votes>
+void cast_votes(Votes & votes, const Query & query, int max_age)
+{
+  votes.clear();
+  for (std::size_t block = 0; block < query.votes.size(); ++block) {
+    for (const Vote & vote : query.votes[block]) {
+      const int time_diff = (vote.query_t1 - vote.reference_t1) >> 2;
+      const std::uint64_t key = (static_cast<std::uint64_t>(time_diff) << 32) + vote.audio_id;
+      olaf::MatchResult * match = votes.find(key);
+      if (match != nullptr) {
+        match->reference_fingerprint_t1 = vote.reference_t1;
+        match->query_fingerprint_t1 = vote.query_t1;
+        match->match_count++;
+        match->first_reference_fingerprint_t1 =
+          std::min(vote.reference_t1, match->first_reference_fingerprint_t1);
+        match->last_reference_fingerprint_t1 =
+          std::max(vote.reference_t1, match->last_reference_fingerprint_t1);
+      } else {
+        olaf::MatchResult inserted;
+        inserted.reference_fingerprint_t1 = vote.reference_t1;
+        inserted.first_reference_fingerprint_t1 = vote.reference_t1;
+        inserted.last_reference_fingerprint_t1 = vote.reference_t1;
+        inserted.query_fingerprint_t1 = vote.query_t1;
+        inserted.match_count = 1;
+        inserted.match_identifier = vote.audio_id;
+        inserted.result_hash_table_key = key;
+        votes.insert(inserted);
+        votes.take_evicted();
+      }
+    }
+    if (max_age > 0 && query.query_times[block] >= 0) {
+      votes.expire(query.query_times[block], max_age);
+    }
+  }
+}
+
+struct Result
+{
+  double votes_per_second = 0;
+  std::size_t peak_bytes = 0;
+  std::size_t peak_candidates = 0;
+  int identified = 0;
+};
+
+template <typename Votes>
+Result run(
+  const olaf::Config & config, const olaf::DB & db, const std::vector<Query> & queries,
+  const std::vector<std::uint32_t> & expected)
+{
+  constexpr int repetitions = 20;
+  const int max_age = config.keepMatchesFor != 0
+    ? static_cast<int>(config.keepMatchesFor * config.audioSampleRate / config.audioStepSize)
+    : 0;
+
+  Result result;
+  CountingResource resource;
+  {
+    std::pmr::unsynchronized_pool_resource pool(&resource);
+    Votes votes(config, db, &resource, &pool);
+
+    std::size_t vote_count = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; ++r) {
+      for (const Query & query : queries) {
+        cast_votes(votes, query, max_age);
+        vote_count += query.vote_count;
+        result.peak_candidates = std::max(result.peak_candidates, votes.size());
+      }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.votes_per_second = vote_count / elapsed.count();
+  }
+  result.peak_bytes = resource.peak();
+
+  // the whole matcher, to check both backends decide the same
+  olaf::BasicFPMatcher<Votes> matcher(
+    config, db, [](int, float, float, std::uint32_t, float, float) {});
+  olaf::ExtractedFingerprints fingerprints;
+  fingerprints.fingerprints.resize(config.maxFingerprints);
+  for (std::size_t q = 0; q < queries.size(); ++q) {
+    matcher.reset();
+    for (const auto & block : queries[q].fingerprints) {
+      std::copy(block.begin(), block.end(), fingerprints.fingerprints.begin());
+      fingerprints.fingerprint_index = block.size();
+      matcher.match(fingerprints);
+    }
+    if (matcher.get_best_match_count() > 0 && matcher.get_best_audio_id() == expected[q]) {
+      result.identified++;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  std::string profile = "mem";
+  std::vector<const char *> positional;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+      profile = argv[++i];
+    } else {
+      positional.push_back(argv[i]);
+    }
+  }
+  const int excerpts = positional.size() > 0 ? std::atoi(positional[0]) : 16;
+  const int seconds = positional.size() > 1 ? std::atoi(positional[1]) : 20;
+
+  olaf::Config config;
+  if (profile == "default") {
+    config = olaf::Config::create_default();
+  } else if (profile == "esp32") {
+    config = olaf::Config::create_esp_32();
+  } else if (profile == "mem") {
+    config = olaf::Config::create_mem();
+  } else if (profile == "mem-tracking") {
+    config = olaf::Config::create_mem_tracking();
+  } else {
+    std::fprintf(stderr, "Unknown config profile %s\n", profile.c_str());
+    return 1;
+  }
+  config.printResultEvery = 0;
+  config.verbose = false;
+
+  std::printf(
+    "Profile %s, %d excerpts of %d s per setlist\n", profile.c_str(), excerpts, seconds);
+  std::printf(
+    "%5s %-9s %12s %11s %10s %10s\n", "songs", "votes", "votes/s", "peak bytes", "peak cand",
+    "identified");
+
+  std::vector<std::vector<std::uint64_t>> fingerprints;
+  for (const int songs : {16, 32, 64}) {
+    while (fingerprints.size() < static_cast<std::size_t>(songs)) {
+      const auto song = host::synthetic_song(
+        static_cast<std::uint32_t>(fingerprints.size() + 1), 180, config.audioSampleRate);
+      fingerprints.push_back(host::index_audio(config, song));
+    }
+    olaf::DB db;
+    for (int i = 0; i < songs; ++i) {
+      db.register_audio(
+        static_cast<std::uint32_t>(i + 1), fingerprints[i].data(), fingerprints[i].size());
+    }
+
+    std::vector<Query> queries;
+    std::vector<std::uint32_t> expected;
+    const std::size_t length = static_cast<std::size_t>(seconds) * config.audioSampleRate;
+    for (int i = 0; i < excerpts; ++i) {
+      const std::uint32_t id = static_cast<std::uint32_t>(i * songs / excerpts + 1);
+      auto excerpt = host::synthetic_song(id, 180, config.audioSampleRate);
+      const std::size_t start = (static_cast<std::size_t>(i) * 37 % 150) * config.audioSampleRate;
+      excerpt.assign(excerpt.begin() + start, excerpt.begin() + start + length);
+      host::add_noise(excerpt, 20, static_cast<std::uint32_t>(i));
+      queries.push_back(extract_query(config, db, excerpt));
+      expected.push_back(id);
+    }
+
+    const Result map = run<olaf::MapVotes>(config, db, queries, expected);
+    const Result histogram = run<olaf::HistogramVotes>(config, db, queries, expected);
+    for (const auto & [name, result] : {std::pair{"map", map}, std::pair{"histogram", histogram}}) {
+      std::printf(
+        "%5d %-9s %12.0f %11zu %10zu %7d/%d\n", songs, name, result.votes_per_second,
+        result.peak_bytes, result.peak_candidates, result.identified, excerpts);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,149 @@
+// Checks the cue clock of the firmware, src/cue_clock.c, on simulated match streams.
+//
+// The matched reference time arrives once per analysis step, quantized to
+// whole blocks as olaf's time offsets are, while the song drifts against the
+// local clock by a crystal error or a different tempo and the analysis thread
+// runs a little late now and then. From a few seconds after the lock, the
+// predicted reference time and every cue scheduled with cue_clock_wait_us()
+// have to stay within one effect frame of the truth, also through a gap
+// without matches and after a skip in the song. Prints the worst errors.
+//
+// Usage: check_cue_clock
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "cue_clock.h"
+
+namespace
+{
+
+// one analysis step of the mem profile, 256 samples at 16 kHz, and an olaf time offset unit
+constexpr std::int64_t step_us = 16000;
+// the fastest effect frame, MIN_INTERVAL_MS of src/effect_engine.c
+constexpr std::int64_t frame_us = 10000;
+// the defaults of APP_CUE_RESYNC_MS and APP_CUE_HOLD_MS
+constexpr std::int64_t resync_us = 250000;
+constexpr std::int64_t hold_us = 5000000;
+// errors count from this long after a lock, when the rate estimate has started
+constexpr std::int64_t settle_us = 3000000;
+// a cue every half second, 120 BPM
+constexpr std::int64_t cue_period_us = 500000;
+
+struct Scenario
+{
+  const char * name;
+  // song time against local time
+  double drift_ppm;
+  // local time of a skip in the song by skip_us, 0 for none
+  std::int64_t skip_at_us;
+  std::int64_t skip_us;
+};
+
+struct Errors
+{
+  std::int64_t worst_prediction_us = 0;
+  std::int64_t worst_cue_us = 0;
+  int cues = 0;
+  int resyncs = 0;
+};
+
+Errors run(const Scenario & scenario)
+{
+  std::mt19937 random(7);
+  std::uniform_int_distribution<int> late_us(0, 2000);
+  // the mean lateness, which APP_CUE_LATENCY_MS adds to the matched time in the firmware
+  const std::int64_t latency_us = 1000;
+
+  const double rate = 1.0 + scenario.drift_ppm / 1e6;
+  // not a whole number of blocks
+  const std::int64_t song_start_us = 42003000;
+  // the song position at local time t
+  const auto truth = [&](std::int64_t t) {
+    const std::int64_t skipped =
+      scenario.skip_at_us > 0 && t >= scenario.skip_at_us ? scenario.skip_us : 0;
+    return song_start_us + static_cast<std::int64_t>(std::llround(t * rate)) + skipped;
+  };
+  // olaf's reference time: the query time minus a whole number of blocks
+  const auto matched = [&](std::int64_t t) {
+    const std::int64_t offset = t - truth(t);
+    const std::int64_t blocks = static_cast<std::int64_t>(
+      std::llround(static_cast<double>(offset) / static_cast<double>(step_us)));
+    return t - blocks * step_us;
+  };
+
+  Errors errors;
+  cue_clock clock{};
+  bool locked = false;
+  std::int64_t locked_at = 0;
+  const std::int64_t end_us = 60000000;
+  // no matches between 30 and 33.5 s, less than the hold time
+  const std::int64_t gap_start_us = 30000000, gap_end_us = gap_start_us + hold_us * 7 / 10;
+
+  for (std::int64_t step = 0; step * step_us < end_us; ++step) {
+    // the step is captured at q, and the analysis thread gets it up to 2 ms late
+    const std::int64_t q = step * step_us;
+    const std::int64_t t = q + late_us(random);
+    const bool in_gap = t >= gap_start_us && t < gap_end_us;
+
+    if (!in_gap) {
+      const std::int64_t ref_us = matched(q) + latency_us;
+      if (!locked) {
+        cue_clock_lock(&clock, t, ref_us, false);
+        locked = true;
+        locked_at = t;
+      } else if (cue_clock_update(&clock, t, ref_us, resync_us)) {
+        errors.resyncs++;
+        locked_at = t;
+      }
+    }
+    if (t - locked_at < settle_us) continue;
+
+    errors.worst_prediction_us = std::max(
+      errors.worst_prediction_us, std::abs(cue_clock_predict(&clock, t) - truth(t)));
+
+    // the cue work would run at t + wait when the next cue comes before the next step
+    const std::int64_t predicted = cue_clock_predict(&clock, t);
+    const std::int64_t next_cue = (predicted / cue_period_us + 1) * cue_period_us;
+    const std::int64_t wait = cue_clock_wait_us(&clock, t, next_cue);
+    if (wait > 0 && wait <= step_us) {
+      const std::int64_t cue_error_us = std::abs(truth(t + wait) - next_cue);
+      errors.worst_cue_us = std::max(errors.worst_cue_us, cue_error_us);
+      errors.cues++;
+    }
+  }
+  return errors;
+}
+
+}  // namespace
+
+int main()
+{
+  const Scenario scenarios[] = {
+    {"steady", 0, 0, 0},
+    {"crystal +200 ppm", 200, 0, 0},
+    {"tempo -1%", -10000, 0, 0},
+    {"tempo +1.5%", 15000, 0, 0},
+    {"skip 10 s ahead", 300, 45000000, 10000000},
+    {"skip 2 s back", -10000, 45000000, -2000000},
+  };
+
+  bool ok = true;
+  for (const Scenario & scenario : scenarios) {
+    const Errors errors = run(scenario);
+    const bool expected_resyncs = errors.resyncs == (scenario.skip_at_us > 0 ? 1 : 0);
+    const bool within = errors.worst_prediction_us <= frame_us &&
+                        errors.worst_cue_us <= frame_us && errors.cues > 0;
+    std::printf(
+      "%-18s worst clock error %5.2f ms, worst of %3d cues %5.2f ms, %d resyncs: %s\n",
+      scenario.name, errors.worst_prediction_us / 1000.0, errors.cues,
+      errors.worst_cue_us / 1000.0, errors.resyncs,
+      within && expected_resyncs ? "ok" : "FAILED");
+    ok = within && expected_resyncs && ok;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+// Checks the capture rate decimator of the firmware, src/audio_decimator.c, built without
+// CMSIS-DSP as on the host.
+//
+// The block filter has to give exactly the full rate FIR of its Q15 taps with every
+// factor-th output kept, across block boundaries and after a reset, and init has to refuse
+// factors and block sizes it cannot run. The filter itself has to pass the music band and
+// attenuate what would alias into it. Prints the passband and stopband gains.
+//
+// Usage: check_decimator
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "audio_decimator.h"
+
+namespace
+{
+
+constexpr int olaf_rate = 16000;
+// one analysis step of the default profile at the capture rate
+constexpr int step_size = 128;
+
+// full rate FIR, every factor-th output kept, with the same rounding as the block filter
+std::vector<std::int16_t> reference(
+  const std::vector<std::int16_t> & in, const audio_decimator & decimator)
+{
+  const int length = decimator.factor * AUDIO_DECIMATOR_TAPS_PER_PHASE;
+  std::vector<std::int16_t> out;
+  for (std::size_t n = decimator.factor - 1; n < in.size(); n += decimator.factor) {
+    std::int32_t sum = 0;
+    for (int k = 0; k < length && static_cast<std::size_t>(k) <= n; ++k) {
+      sum += decimator.coeffs[k] * in[n - k];
+    }
+    out.push_back(static_cast<std::int16_t>(std::clamp(sum >> 15, -32768, 32767)));
+  }
+  return out;
+}
+
+std::vector<std::int16_t> decimate(
+  audio_decimator & decimator, const std::vector<std::int16_t> & in)
+{
+  std::vector<std::int16_t> out(in.size() / decimator.factor);
+  for (std::size_t i = 0; i + decimator.block_size <= in.size(); i += decimator.block_size) {
+    audio_decimator_process(
+      &decimator, in.data() + i, out.data() + i / decimator.factor);
+  }
+  return out;
+}
+
+bool check_exact(int factor)
+{
+  const std::size_t block = static_cast<std::size_t>(step_size) * factor;
+  std::vector<std::int16_t> state(AUDIO_DECIMATOR_STATE_LENGTH(block));
+  audio_decimator decimator;
+  audio_decimator_init(&decimator, factor, state.data(), block);
+
+  std::mt19937 generator(factor);
+  std::uniform_int_distribution<int> distribution(-32768, 32767);
+  std::vector<std::int16_t> in(block * 50);
+  for (auto & sample : in) {
+    sample = static_cast<std::int16_t>(distribution(generator));
+  }
+
+  const std::vector<std::int16_t> expected = reference(in, decimator);
+  const std::vector<std::int16_t> first = decimate(decimator, in);
+  audio_decimator_reset(&decimator);
+  const std::vector<std::int16_t> again = decimate(decimator, in);
+
+  std::size_t mismatches = 0;
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    mismatches += first[i] != expected[i];
+    mismatches += again[i] != expected[i];
+  }
+  const bool ok = first.size() == expected.size() && mismatches == 0;
+  std::printf(
+    "%5d Hz: %zu outputs in blocks of %zu, %zu differ from the reference FIR: %s\n",
+    olaf_rate * factor, expected.size(), block, mismatches, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+// output level of a tone relative to its input level, in dB
+double gain_db(int factor, double frequency)
+{
+  const int rate = olaf_rate * factor;
+  const std::size_t block = static_cast<std::size_t>(step_size) * factor;
+  std::vector<std::int16_t> state(AUDIO_DECIMATOR_STATE_LENGTH(block));
+  audio_decimator decimator;
+  audio_decimator_init(&decimator, factor, state.data(), block);
+
+  std::vector<std::int16_t> in(static_cast<std::size_t>(rate) / block * block);
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    in[i] = static_cast<std::int16_t>(
+      std::lrint(16384 * std::sin(2 * 3.14159265358979323846 * frequency * i / rate)));
+  }
+  const std::vector<std::int16_t> out = decimate(decimator, in);
+  double energy = 0;
+  for (std::size_t i = out.size() / 2; i < out.size(); ++i) {
+    energy += static_cast<double>(out[i]) * out[i];
+  }
+  const double rms = std::sqrt(energy / (out.size() - out.size() / 2));
+  return 20 * std::log10(std::max(rms, 1e-3) / (16384 / std::sqrt(2.0)));
+}
+
+bool check_response(int factor)
+{
+  const double pass = std::min(gain_db(factor, 1000), gain_db(factor, 5000));
+  const double edge = gain_db(factor, 7000);
+  // the lowest tone that aliases into the band up to 6 kHz
+  const double stop = std::max(gain_db(factor, 10000), gain_db(factor, 12000));
+  const bool ok = pass > -0.5 && edge > -9 && stop < -50;
+  std::printf(
+    "%5d Hz: passband %.2f dB, 7 kHz %.1f dB, 10 and 12 kHz %.1f dB: %s\n", olaf_rate * factor,
+    pass, edge, stop, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+bool check_arguments()
+{
+  std::vector<std::int16_t> state(AUDIO_DECIMATOR_STATE_LENGTH(512));
+  audio_decimator decimator;
+  const bool ok = audio_decimator_init(&decimator, 1, state.data(), 384) == -EINVAL &&
+                  audio_decimator_init(&decimator, 4, state.data(), 512) == -EINVAL &&
+                  audio_decimator_init(&decimator, 3, state.data(), 256) == -EINVAL &&
+                  audio_decimator_init(&decimator, 3, state.data(), 384) == 0;
+  std::printf("Factors 1 and 4 and blocks that are no multiple refused: %s\n",
+              ok ? "ok" : "FAILED");
+  return ok;
+}
+
+}  // namespace
+
+int main()
+{
+  bool ok = check_arguments();
+  for (int factor = 2; factor <= AUDIO_DECIMATOR_MAX_FACTOR; ++factor) {
+    ok = check_exact(factor) && ok;
+    ok = check_response(factor) && ok;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+// Checks that an olaf::FPCatalog answers queries like a freshly indexed DB.
+//
+// Indexes synthetic songs into the main store of a catalog, then adds,
+// replaces and removes songs through the delta, reopens the catalog from disk
+// and compacts it, once in the foreground and once on a background thread while
+// the DB is being queried. After every step DB::find has to return the same
+// results as a DB with only the expected songs registered. Prints the time of
+// a change to the delta and of a compaction.
+//
+// Usage: check_fp_catalog [catalog path]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "host_audio.hpp"
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+#include "olaf_fp_catalog.hpp"
+#include "olaf_fp_store_builder.hpp"
+#include "olaf_stop_list.hpp"
+
+namespace
+{
+
+using Songs = std::map<std::uint32_t, std::vector<std::uint64_t>>;
+
+double milliseconds_since(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+    .count();
+}
+
+std::vector<std::uint64_t> sorted_results(const olaf::DB & db, std::uint64_t hash)
+{
+  std::vector<std::uint64_t> results;
+  db.find(hash - 1, hash + 1, results, 1 << 20);
+  std::sort(results.begin(), results.end());
+  return results;
+}
+
+// the catalog DB against a DB with exactly the expected songs
+bool check(
+  const char * step, const olaf::FPCatalog & catalog, const olaf::DB & db, const Songs & expected,
+  std::span<const std::uint64_t> stop_list, const std::vector<std::uint64_t> & probes)
+{
+  olaf::DB reference;
+  for (const auto & [audio_id, fingerprints] : expected) {
+    reference.register_audio(audio_id, fingerprints.data(), fingerprints.size());
+  }
+  reference.set_stop_list(stop_list);
+
+  bool ok =
+    catalog.get_song_count() == expected.size() && db.get_audio_count() == expected.size();
+  for (std::size_t i = 0; ok && i < probes.size(); ++i) {
+    ok = sorted_results(db, probes[i]) == sorted_results(reference, probes[i]);
+  }
+  std::printf(
+    "%-28s %2zu songs, %2zu delta entries: %s\n", step, catalog.get_song_count(),
+    catalog.get_delta_entry_count(), ok ? "same as a fresh DB" : "DIFFERENT");
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const std::string path = argc > 1 ? argv[1] : "check_fp_catalog.store";
+  olaf::Config config = olaf::Config::create_mem();
+  config.verbose = false;
+  // a stop-list already with a few songs
+  config.maxHashOccurrences = 3;
+
+  // songs 1 to 16, and another version of song 5
+  std::vector<std::vector<std::uint64_t>> fingerprints(17);
+  for (std::uint32_t seed = 1; seed <= 17; ++seed) {
+    const std::uint32_t audio_seed = seed == 17 ? 105 : seed;
+    fingerprints[seed - 1] =
+      host::index_audio(config, host::synthetic_song(audio_seed, 20, config.audioSampleRate));
+  }
+  const auto song = [&](std::uint32_t seed) -> const std::vector<std::uint64_t> & {
+    return fingerprints[seed - 1];
+  };
+  std::vector<std::uint64_t> probes;
+  for (const auto & fps : fingerprints) {
+    for (std::size_t i = 0; i < fps.size(); i += 5) probes.push_back(fps[i] >> 16);
+  }
+
+  // the main store: songs 1 to 12
+  std::remove(path.c_str());
+  std::remove((path + ".delta").c_str());
+  Songs expected;
+  olaf::StopListBuilder stop_list_builder;
+  {
+    olaf::FPStoreBuilder builder(config, path.c_str());
+    for (std::uint32_t id = 1; id <= 12; ++id) {
+      builder.add_song(id, song(id));
+      stop_list_builder.add_song(song(id));
+      expected[id] = song(id);
+    }
+    if (!builder.finish()) return 1;
+  }
+  const std::vector<std::uint64_t> stop_list = stop_list_builder.build(config);
+
+  olaf::FPCatalog catalog;
+  olaf::DB db;
+  if (!catalog.open(path.c_str())) return 1;
+  catalog.attach(db);
+  bool ok = check("main store", catalog, db, expected, stop_list, probes);
+
+  auto start = std::chrono::steady_clock::now();
+  for (std::uint32_t id = 13; id <= 15; ++id) {
+    ok = catalog.add_song(id, song(id)) && ok;
+    expected[id] = song(id);
+  }
+  const double add_ms = milliseconds_since(start) / 3;
+  ok = check("added 13 14 15", catalog, db, expected, stop_list, probes) && ok;
+
+  ok = catalog.add_song(5, song(17)) && ok;
+  expected[5] = song(17);
+  ok = check("replaced 5", catalog, db, expected, stop_list, probes) && ok;
+
+  ok = catalog.remove_song(3) && catalog.remove_song(13) && !catalog.remove_song(99) && ok;
+  expected.erase(3);
+  expected.erase(13);
+  ok = check("removed 3 13", catalog, db, expected, stop_list, probes) && ok;
+
+  {
+    olaf::FPCatalog reopened;
+    olaf::DB reopened_db;
+    ok = reopened.open(path.c_str()) && ok;
+    reopened.attach(reopened_db);
+    ok = check("reopened", reopened, reopened_db, expected, stop_list, probes) && ok;
+  }
+
+  start = std::chrono::steady_clock::now();
+  ok = catalog.compact() && ok;
+  const double compact_ms = milliseconds_since(start);
+  ok = check("compacted", catalog, db, expected, stop_list, probes) && ok;
+  ok = catalog.get_delta_entry_count() == 0 && ok;
+
+  // compaction in the background, queries go on meanwhile
+  ok = catalog.add_song(16, song(16)) && catalog.remove_song(1) && ok;
+  expected[16] = song(16);
+  expected.erase(1);
+  std::atomic<bool> prepared{false};
+  bool prepare_ok = false;
+  std::thread compaction([&]() {
+    prepare_ok = catalog.prepare_compaction();
+    prepared = true;
+  });
+  std::size_t queries = 0;
+  while (!prepared) {
+    sorted_results(db, probes[queries++ % probes.size()]);
+  }
+  compaction.join();
+  ok = prepare_ok && catalog.install_compaction() && ok;
+  ok = check("compacted in the background", catalog, db, expected, stop_list, probes) && ok;
+
+  {
+    olaf::FPCatalog reopened;
+    olaf::DB reopened_db;
+    ok = reopened.open(path.c_str()) && ok;
+    reopened.attach(reopened_db);
+    ok = check("reopened", reopened, reopened_db, expected, stop_list, probes) && ok;
+  }
+
+  std::printf(
+    "Change of the delta %.2f ms, compaction %.2f ms, %zu queries during background "
+    "compaction\n",
+    add_ms, compact_ms, queries);
+  std::remove(path.c_str());
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+// Randomized equivalence of the batch fingerprint hashes with Fingerprint::calculate_hash,
+// and of the wide layout with its scalar hash_fingerprint, followed by a throughput
+// comparison of the original layout. Exits with 1 on the first mismatch.
+//
+// Usage: check_fp_hash [fingerprints]
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "olaf_fp_hash.hpp"
+
+namespace
+{
+
+using HashFunction = void (*)(
+  const std::int32_t *, const std::int32_t *, const std::int32_t *, const std::int32_t *,
+  const std::int32_t *, const std::int32_t *, std::size_t, std::uint64_t *);
+
+struct Path
+{
+  const char * name;
+  int layout;
+  HashFunction function;
+};
+
+constexpr int v1 = olaf::hash_layout_v1;
+constexpr int v2 = olaf::hash_layout_v2;
+
+const Path paths[] = {
+  {"scalar", v1, olaf::hash_fingerprints_scalar<v1>},
+  {"scalar v2", v2, olaf::hash_fingerprints_scalar<v2>},
+#if defined(__SSE2__)
+  {"sse2", v1, olaf::hash_fingerprints_sse2<v1>},
+  {"sse2 v2", v2, olaf::hash_fingerprints_sse2<v2>},
+#endif
+#if defined(__AVX2__)
+  {"avx2", v1, olaf::hash_fingerprints_avx2<v1>},
+  {"avx2 v2", v2, olaf::hash_fingerprints_avx2<v2>},
+#endif
+#if defined(__AVX512F__)
+  {"avx512", v1, olaf::hash_fingerprints_avx512<v1>},
+  {"avx512 v2", v2, olaf::hash_fingerprints_avx512<v2>},
+#endif
+#if defined(__ARM_NEON)
+  {"neon", v1, olaf::hash_fingerprints_neon<v1>},
+  {"neon v2", v2, olaf::hash_fingerprints_neon<v2>},
+#endif
+};
+
+std::uint64_t reference_hash(const olaf::Fingerprint & fp, int layout)
+{
+  if (layout == v1) return fp.calculate_hash();
+  return olaf::hash_fingerprint<v2>(
+    fp.frequency_bin1, fp.frequency_bin2, fp.frequency_bin3, fp.time_index1, fp.time_index2,
+    fp.time_index3);
+}
+
+// realistic fingerprints from the extractor ranges, and wide values for the edge cases
+std::vector<olaf::Fingerprint> random_fingerprints(std::size_t count, std::uint32_t seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_int_distribution<int> bin(0, 512);
+  std::uniform_int_distribution<int> step(0, 40);
+  std::uniform_int_distribution<int> time(0, 1 << 30);
+  std::uniform_int_distribution<int> wide(-(1 << 20), 1 << 20);
+  std::uniform_int_distribution<int> kind(0, 9);
+
+  std::vector<olaf::Fingerprint> fingerprints(count);
+  for (auto & fp : fingerprints) {
+    if (kind(generator) == 0) {
+      fp.frequency_bin1 = wide(generator);
+      fp.frequency_bin2 = wide(generator);
+      fp.frequency_bin3 = wide(generator);
+      fp.time_index1 = wide(generator);
+      fp.time_index2 = wide(generator);
+      fp.time_index3 = wide(generator);
+    } else {
+      fp.frequency_bin1 = bin(generator);
+      fp.frequency_bin2 = bin(generator);
+      fp.frequency_bin3 = bin(generator);
+      fp.time_index1 = time(generator);
+      fp.time_index2 = fp.time_index1 + step(generator);
+      fp.time_index3 = fp.time_index2 + step(generator);
+    }
+  }
+  return fingerprints;
+}
+
+bool check(const Path & path, const std::vector<olaf::Fingerprint> & fingerprints)
+{
+  // every length up to a few blocks exercises the tails of each width
+  for (std::size_t count : {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 300}) {
+    for (std::size_t offset = 0; offset + count <= fingerprints.size(); offset += 997) {
+      olaf::FingerprintBatch batch;
+      for (std::size_t i = 0; i < count; ++i) {
+        batch.push_back(fingerprints[offset + i]);
+      }
+      std::vector<std::uint64_t> hashes(count + 1, 0xDEADBEEF);
+      path.function(
+        batch.f1.data(), batch.f2.data(), batch.f3.data(), batch.t1.data(), batch.t2.data(),
+        batch.t3.data(), count, hashes.data());
+
+      for (std::size_t i = 0; i < count; ++i) {
+        const std::uint64_t expected = reference_hash(fingerprints[offset + i], path.layout);
+        if (hashes[i] != expected) {
+          std::printf(
+            "%s: fingerprint %zu of %zu: %" PRIu64 " != %" PRIu64 "\n", path.name, i, count,
+            hashes[i], expected);
+          fingerprints[offset + i].print();
+          return false;
+        }
+      }
+      if (hashes[count] != 0xDEADBEEF) {
+        std::printf("%s: wrote past %zu hashes\n", path.name, count);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1 << 20;
+  const std::vector<olaf::Fingerprint> fingerprints = random_fingerprints(count, 42);
+
+  for (const Path & path : paths) {
+    if (!check(path, fingerprints)) {
+      return 1;
+    }
+  }
+
+  olaf::FingerprintBatch batch;
+  for (const auto & fp : fingerprints) {
+    batch.push_back(fp);
+  }
+
+  // calculate_hash per fingerprint, as the matcher did before
+  std::uint64_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto & fp : fingerprints) {
+    checksum += fp.calculate_hash();
+  }
+  const double reference_ns =
+    std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::printf("calculate_hash: %.2f ns/fingerprint\n", reference_ns / count);
+
+  for (const Path & path : paths) {
+    if (path.layout != v1) continue;
+    start = std::chrono::steady_clock::now();
+    path.function(
+      batch.f1.data(), batch.f2.data(), batch.f3.data(), batch.t1.data(), batch.t2.data(),
+      batch.t3.data(), batch.size, batch.hashes.data());
+    const double ns =
+      std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < batch.size; ++i) {
+      sum += batch.hashes[i];
+    }
+    std::printf(
+      "%-14s %.2f ns/fingerprint, %.1fx, %s\n", path.name, ns / count, reference_ns / ns,
+      sum == checksum ? "equal" : "DIFFERENT");
+    if (sum != checksum) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,262 @@
+// Checks the confidence, decision and tracking lock of olaf::FPMatcher on
+// synthetic fingerprints.
+//
+// The fingerprints are built directly instead of extracted from audio, every
+// one with its own hash, so each query fingerprint hits exactly the reference
+// fingerprints the check put in the DB. Checks that the confidence is the vote
+// margin over the runner-up and the decision is reported once, after the votes
+// of its block, even when the callback resets the matcher. Checks that
+// DB::find_near() stays inside the 16 bit timestamps and the setlist scope,
+// that a lock follows a drifting offset, that a hash repeating inside the
+// tracking window does not pull the lock away, and that a lost lock searches
+// the whole DB again so another song can win. Prints one line per check.
+//
+// Usage: check_fp_matcher
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+#include "olaf_fp_extractor.hpp"
+#include "olaf_fp_matcher.hpp"
+
+namespace
+{
+
+// reference fingerprints are this many blocks apart
+constexpr int spacing = 4;
+
+// a fingerprint whose hash differs from every other id by far more than searchRange
+olaf::Fingerprint synthetic_fingerprint(int id, int t1)
+{
+  olaf::Fingerprint fp;
+  fp.frequency_bin1 = 20 + 2 * (id % 200);
+  fp.frequency_bin2 = fp.frequency_bin1 + 8 + 4 * (id / 200 % 30);
+  fp.frequency_bin3 = fp.frequency_bin2 + 4;
+  fp.time_index1 = t1;
+  fp.time_index2 = t1 + 3;
+  fp.time_index3 = t1 + 7;
+  return fp;
+}
+
+// fingerprints first_id..first_id + count at reference time id * spacing + shift,
+// every step-th id only, repeated echo blocks later when echo > 0
+std::vector<std::uint64_t> synthetic_song(
+  int count, int echo = 0, int first_id = 0, int shift = 0, int step = 1)
+{
+  std::vector<std::uint64_t> fingerprints;
+  for (int i = first_id; i < first_id + count; i += step) {
+    for (int t : {i * spacing + shift, echo > 0 ? i * spacing + shift + echo : -1}) {
+      if (t < 0) continue;
+      const std::uint64_t hash = synthetic_fingerprint(i, t).calculate_hash();
+      fingerprints.push_back(hash << 16 | static_cast<std::uint64_t>(t));
+    }
+  }
+  std::sort(fingerprints.begin(), fingerprints.end());
+  return fingerprints;
+}
+
+// hands fingerprints to the matcher one block at a time, as the extractor would
+class Feeder
+{
+private:
+  olaf::ExtractedFingerprints block_;
+
+public:
+  void feed(olaf::FPMatcher & matcher, int id, int query_t1)
+  {
+    block_.fingerprints.resize(1);
+    block_.fingerprints[0] = synthetic_fingerprint(id, query_t1);
+    block_.fingerprint_index = 1;
+    matcher.match(block_);
+  }
+};
+
+olaf::Config test_config()
+{
+  olaf::Config config = olaf::Config::create_mem_tracking();
+  config.hashLayout = 1;
+  config.verbose = false;
+  config.printResultEvery = 0;
+  return config;
+}
+
+bool report(const char * check, bool ok)
+{
+  std::printf("%s: %s\n", check, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+// what the result callback saw
+struct Reports
+{
+  int count = 0;
+  std::uint32_t audio_id = 0;
+  int match_count = 0;
+};
+
+bool check_decision(bool reset_in_callback)
+{
+  const olaf::Config config = test_config();
+  // song 2 has every other fingerprint of song 1 at a different offset
+  const std::vector<std::uint64_t> song = synthetic_song(300);
+  const std::vector<std::uint64_t> half = synthetic_song(300, 0, 0, 40, 2);
+  olaf::DB db;
+  // the runner-up first, so its vote for a fingerprint counts before the best one's
+  db.register_audio(2, half.data(), half.size());
+  db.register_audio(1, song.data(), song.size());
+
+  Reports reports;
+  olaf::FPMatcher * matcher_in_callback = nullptr;
+  olaf::FPMatcher matcher(
+    config, db, [&](int match_count, float, float, std::uint32_t audio_id, float, float) {
+      reports.count++;
+      reports.audio_id = audio_id;
+      reports.match_count = match_count;
+      if (reset_in_callback) matcher_in_callback->reset();
+    });
+  matcher_in_callback = &matcher;
+  Feeder feeder;
+
+  // song 1 gets a vote per fingerprint, song 2 one for every other
+  bool ok = true;
+  int decided_at = 0;
+  for (int n = 1; n <= 16 && ok; ++n) {
+    const int reports_before = reports.count;
+    feeder.feed(matcher, n - 1, (n - 1) * spacing + 100);
+
+    if (decided_at == 0) {
+      const int margin = n - (n + 1) / 2;
+      const bool decides = margin >= config.minMatchConfidence && n >= config.minMatchCount;
+      if (decides) decided_at = n;
+      ok = reports.count == reports_before + (decides ? 1 : 0);
+      if (decides) {
+        ok = ok && reports.audio_id == 1 && reports.match_count == n;
+        ok = ok && matcher.is_decided() != reset_in_callback;
+      } else {
+        ok = ok && !matcher.is_decided() && matcher.get_confidence() == margin;
+      }
+    }
+  }
+  // after a reset in the callback the same song decides again, from fresh votes
+  ok = ok && decided_at == 8 && reports.count == (reset_in_callback ? 2 : 1);
+  return report(
+    reset_in_callback ? "Decision with a reset in the callback" : "Confidence and decision", ok);
+}
+
+bool check_find_near()
+{
+  const std::vector<std::uint64_t> song = synthetic_song(64);
+  olaf::DB db;
+  db.register_audio(1, song.data(), song.size());
+  const std::uint64_t hash = synthetic_fingerprint(3, 0).calculate_hash();
+
+  std::vector<std::uint64_t> results;
+  bool ok = db.find_near(1, hash, hash, 0, 100, results, 100) == 1;
+
+  // a window past the 16 bit timestamps must not wrap around to the start of the song
+  ok = db.find_near(1, hash, hash, 0x10000, 0x10000 + 100, results, 100) == 0 && ok;
+
+  const std::uint32_t other = 2;
+  db.set_active_audio({&other, 1});
+  ok = db.find_near(1, hash, hash, 0, 100, results, 100) == 0 && ok;
+  db.clear_active_audio();
+  ok = db.find_near(1, hash, hash, 0, 100, results, 100) == 1 && ok;
+  return report("find_near() window and scope", ok);
+}
+
+bool check_drift()
+{
+  const olaf::Config config = test_config();
+  const std::vector<std::uint64_t> song = synthetic_song(600);
+  olaf::DB db;
+  db.register_audio(1, song.data(), song.size());
+  olaf::FPMatcher matcher(config, db, [](int, float, float, std::uint32_t, float, float) {});
+  Feeder feeder;
+
+  // the query runs 2.5% fast: the offset grows by one block every ten fingerprints
+  const int start_offset = 100;
+  matcher.lock(1, start_offset, start_offset);
+  int worst = 0;
+  for (int i = 0; i < 600; ++i) {
+    const int offset = start_offset + i / 10;
+    feeder.feed(matcher, i, i * spacing + offset);
+    worst = std::max(worst, std::abs(matcher.get_tracked_offset() - offset));
+  }
+  std::printf("  worst tracked offset error %d blocks\n", worst);
+  return report("Lock follows a drifting offset", matcher.is_tracking() && worst <= 1);
+}
+
+bool check_repeated_hash()
+{
+  const olaf::Config config = test_config();
+  // every hash repeats 12 blocks later, inside the tracking window
+  const std::vector<std::uint64_t> song = synthetic_song(300, 12);
+  olaf::DB db;
+  db.register_audio(1, song.data(), song.size());
+  olaf::FPMatcher matcher(config, db, [](int, float, float, std::uint32_t, float, float) {});
+  Feeder feeder;
+
+  const int offset = 50;
+  matcher.lock(1, offset, offset);
+  bool steady = true;
+  for (int i = 0; i < 300; ++i) {
+    feeder.feed(matcher, i, i * spacing + offset);
+    steady = steady && matcher.get_tracked_offset() == offset;
+  }
+  return report("Lock ignores a hash repeating in the window", steady && matcher.is_tracking());
+}
+
+bool check_lost_lock()
+{
+  const olaf::Config config = test_config();
+  const std::vector<std::uint64_t> first = synthetic_song(100);
+  const std::vector<std::uint64_t> second = synthetic_song(100, 0, 300);
+  olaf::DB db;
+  db.register_audio(1, first.data(), first.size());
+  db.register_audio(2, second.data(), second.size());
+
+  Reports reports;
+  olaf::FPMatcher matcher(
+    config, db, [&](int match_count, float, float, std::uint32_t audio_id, float, float) {
+      reports.count++;
+      reports.audio_id = audio_id;
+      reports.match_count = match_count;
+    });
+  Feeder feeder;
+
+  int t = 0;
+  for (int i = 0; i < 50; ++i, t += spacing) feeder.feed(matcher, i, t);
+  bool ok = matcher.is_tracking() && matcher.get_tracked_audio_id() == 1 && reports.count == 1;
+
+  // audio that is not in the DB until the lock times out
+  const int timeout = static_cast<int>(
+    config.trackingTimeout * config.audioSampleRate / config.audioStepSize);
+  for (const int end = t + timeout + 2 * spacing; t < end; t += spacing) {
+    feeder.feed(matcher, 1000 + t, t);
+  }
+  ok = ok && !matcher.is_tracking() && !matcher.is_decided() && matcher.get_best_match_count() == 0;
+
+  // a full search finds, decides and locks on the other song
+  for (int i = 300; i < 350; ++i, t += spacing) feeder.feed(matcher, i, t);
+  ok = ok && reports.count == 2 && reports.audio_id == 2 && matcher.is_decided() &&
+       matcher.is_tracking() && matcher.get_tracked_audio_id() == 2;
+  return report("Lost lock searches again, another song wins", ok);
+}
+
+}  // namespace
+
+int main()
+{
+  bool ok = check_decision(false);
+  ok = check_decision(true) && ok;
+  ok = check_find_near() && ok;
+  ok = check_drift() && ok;
+  ok = check_repeated_hash() && ok;
+  ok = check_lost_lock() && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+// Checks the binary format of olaf::FPStore.
+//
+// Writes songs, a tombstone, a stop-list and a hash layout with an
+// FPStoreWriter, then reads the file back both memory mapped and attached from
+// a buffer and compares every field. Then corrupts copies of the file, among
+// them counts whose size in bytes wraps around 64 bits and a byte order mark
+// of the other byte order, and checks that each one is refused. A store
+// without the mark, as written before it existed, has to open on a little
+// endian host. Prints one line per case.
+//
+// Usage: check_fp_store [store path]
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "olaf_fp_store.hpp"
+
+namespace
+{
+
+struct Song
+{
+  std::uint32_t audio_id;
+  std::uint32_t duration_ms;
+  std::vector<std::uint64_t> fingerprints;
+};
+
+std::vector<std::uint64_t> sorted_fingerprints(std::size_t count, std::uint32_t seed)
+{
+  std::mt19937_64 random(seed);
+  std::vector<std::uint64_t> fingerprints(count);
+  for (auto & fp : fingerprints) fp = random();
+  std::sort(fingerprints.begin(), fingerprints.end());
+  return fingerprints;
+}
+
+// the store file in 8 byte aligned memory, as attach() expects
+std::vector<std::uint64_t> read_file(const char * path, std::size_t & size)
+{
+  std::vector<std::uint64_t> data;
+  std::FILE * file = std::fopen(path, "rb");
+  if (file == nullptr) return data;
+  std::fseek(file, 0, SEEK_END);
+  size = static_cast<std::size_t>(std::ftell(file));
+  std::fseek(file, 0, SEEK_SET);
+  data.resize((size + 7) / 8);
+  if (std::fread(data.data(), 1, size, file) != size) data.clear();
+  std::fclose(file);
+  return data;
+}
+
+bool same_contents(
+  const olaf::FPStore & store, const std::vector<Song> & songs, std::uint32_t tombstone,
+  const std::vector<std::uint64_t> & stop_list)
+{
+  if (store.get_song_count() != songs.size() + 1 || store.get_hash_layout() != 2) return false;
+
+  std::uint64_t total = 0;
+  for (std::size_t i = 0; i < songs.size(); ++i) {
+    const olaf::FPStoreEntry & entry = store.get_entry(i);
+    const auto fps = store.get_fingerprints(i);
+    if (
+      entry.audio_id != songs[i].audio_id || entry.duration_ms != songs[i].duration_ms ||
+      store.is_tombstone(i) || fps.size() != songs[i].fingerprints.size() ||
+      !std::equal(fps.begin(), fps.end(), songs[i].fingerprints.begin())) {
+      return false;
+    }
+    total += fps.size();
+  }
+  const std::size_t last = songs.size();
+  if (
+    store.get_entry(last).audio_id != tombstone || !store.is_tombstone(last) ||
+    !store.get_fingerprints(last).empty() || store.get_total_fingerprints() != total) {
+    return false;
+  }
+
+  const auto stored_stop_list = store.get_stop_list();
+  if (!std::equal(
+        stored_stop_list.begin(), stored_stop_list.end(), stop_list.begin(), stop_list.end())) {
+    return false;
+  }
+
+  olaf::DB db;
+  return store.register_all(db) == songs.size() && db.get_audio_count() == songs.size();
+}
+
+std::uint16_t swap_bytes(std::uint16_t value)
+{
+  return static_cast<std::uint16_t>(value << 8 | value >> 8);
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const char * path = argc > 1 ? argv[1] : "fp_store_check.store";
+
+  std::vector<Song> songs;
+  for (std::uint32_t id = 1; id <= 5; ++id) {
+    // an empty song and an odd count exercise the section padding
+    const std::size_t count = id == 3 ? 0 : 1000 * id + 13;
+    songs.push_back({id * 7, 60000 + id, sorted_fingerprints(count, id)});
+  }
+  const std::uint32_t tombstone = 99;
+  const std::vector<std::uint64_t> stop_list = sorted_fingerprints(17, 100);
+
+  olaf::FPStoreWriter writer;
+  for (const Song & song : songs) {
+    writer.add_song(song.audio_id, song.fingerprints, song.duration_ms);
+  }
+  writer.add_tombstone(tombstone);
+  writer.set_stop_list(stop_list);
+  writer.set_hash_layout(2);
+  if (!writer.write(path)) return 1;
+
+  bool ok = true;
+
+  olaf::FPStore mapped;
+  const bool mapped_ok = mapped.open(path) && same_contents(mapped, songs, tombstone, stop_list);
+  std::printf("Round trip, memory mapped: %s\n", mapped_ok ? "ok" : "FAILED");
+  ok = mapped_ok && ok;
+
+  std::size_t size = 0;
+  const std::vector<std::uint64_t> original = read_file(path, size);
+  olaf::FPStore attached;
+  const bool attached_ok = !original.empty() && attached.attach(original.data(), size) &&
+                           same_contents(attached, songs, tombstone, stop_list);
+  std::printf("Round trip, attached: %s\n", attached_ok ? "ok" : "FAILED");
+  ok = attached_ok && ok;
+
+  // stores written before the byte order mark are little endian
+  std::vector<std::uint64_t> unmarked = original;
+  reinterpret_cast<olaf::FPStoreHeader *>(unmarked.data())->byte_order = 0;
+  olaf::FPStore legacy;
+  const bool legacy_ok = legacy.attach(unmarked.data(), size) ==
+                         (std::endian::native == std::endian::little);
+  std::printf("Without a byte order mark: %s\n", legacy_ok ? "ok" : "FAILED");
+  ok = legacy_ok && ok;
+
+  using Corruption =
+    std::function<void(olaf::FPStoreHeader &, olaf::FPStoreEntry *, std::size_t &)>;
+  const struct
+  {
+    const char * name;
+    Corruption corrupt;
+  } cases[] = {
+    {"shorter than a header", [](auto &, auto *, std::size_t & n) { n = 32; }},
+    {"truncated", [](auto &, auto *, std::size_t & n) { n -= 8; }},
+    {"bad magic", [](auto & h, auto *, std::size_t &) { h.magic[0] = 'X'; }},
+    {"newer version", [](auto & h, auto *, std::size_t &) { h.version += 1; }},
+    {"other byte order",
+     [](auto & h, auto *, std::size_t &) { h.byte_order = swap_bytes(h.byte_order); }},
+    {"song count past the end", [](auto & h, auto *, std::size_t &) { h.song_count = ~0u; }},
+    {"directory offset wraps",
+     [](auto & h, auto *, std::size_t &) { h.directory_offset = ~0ull - 31; }},
+    {"misaligned directory", [](auto & h, auto *, std::size_t &) { h.directory_offset += 4; }},
+    {"fingerprint count wraps",
+     [](auto &, auto * d, std::size_t &) { d[1].fingerprint_count = 1ull << 61; }},
+    {"fingerprints past the end",
+     [](auto &, auto * d, std::size_t &) { d[4].fingerprint_count += 1000; }},
+    {"misaligned fingerprints",
+     [](auto &, auto * d, std::size_t &) { d[0].fingerprints_offset += 4; }},
+    {"fingerprint offset past the end",
+     [](auto &, auto * d, std::size_t &) { d[2].fingerprints_offset = 1ull << 40; }},
+    {"stop-list past the end", [](auto & h, auto *, std::size_t &) { h.stop_list_count += 1; }},
+    {"misaligned stop-list", [](auto & h, auto *, std::size_t &) { h.stop_list_offset += 4; }},
+  };
+
+  for (const auto & c : cases) {
+    std::vector<std::uint64_t> copy = original;
+    std::size_t copy_size = size;
+    auto * header = reinterpret_cast<olaf::FPStoreHeader *>(copy.data());
+    auto * directory = reinterpret_cast<olaf::FPStoreEntry *>(
+      reinterpret_cast<std::uint8_t *>(copy.data()) + header->directory_offset);
+    c.corrupt(*header, directory, copy_size);
+
+    olaf::FPStore store;
+    const bool refused = !store.attach(copy.data(), copy_size) && !store.is_open();
+    std::printf("Corrupt, %s: %s\n", c.name, refused ? "refused" : "ACCEPTED");
+    ok = refused && ok;
+  }
+
+  std::remove(path);
+  return ok ? 0 : 1;
+}
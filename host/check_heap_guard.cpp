@@ -0,0 +1,90 @@
+// Checks that the fingerprinting pipeline runs out of one static buffer.
+//
+// The DB and a FingerprintStream are built in an olaf::Arena over a static
+// array, then noisy excerpts of the indexed songs are processed inside an
+// olaf::HeapGuard. Built with OLAF_HEAP_GUARD, any allocation from the global
+// heap in that time aborts the program. Prints the bytes of the arena in use,
+// the size a static buffer on the MCU needs for this Config.
+//
+// Usage: check_heap_guard [--trap]
+//   --trap  allocate from the heap inside the guard, passes when that aborts
+
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "host_audio.hpp"
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+#include "olaf_memory.hpp"
+#include "olaf_stream_pool.hpp"
+
+namespace
+{
+
+alignas(std::max_align_t) std::byte arena_buffer[4 << 20];
+
+extern "C" void trapped(int) { std::_Exit(0); }
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  if (argc > 1 && std::strcmp(argv[1], "--trap") == 0) {
+    std::signal(SIGABRT, trapped);
+    olaf::HeapGuard guard;
+    std::vector<int> heap(16);
+    std::printf("Heap allocation of %zu ints was not trapped\n", heap.size());
+    return 1;
+  }
+
+  olaf::Config config = olaf::Config::create_mem();
+  config.printResultEvery = 0;
+  config.verbose = false;
+
+  // the reference fingerprints live in flash on the MCU, here on the heap
+  std::vector<std::vector<std::int16_t>> songs;
+  std::vector<std::vector<std::uint64_t>> fingerprints;
+  for (std::uint32_t id = 1; id <= 4; ++id) {
+    songs.push_back(host::synthetic_song(id, 40, config.audioSampleRate));
+    fingerprints.push_back(host::index_audio(config, songs.back()));
+  }
+
+  olaf::Arena arena(arena_buffer, sizeof(arena_buffer));
+  olaf::DB db(&arena);
+  for (std::size_t i = 0; i < fingerprints.size(); ++i) {
+    db.register_audio(
+      static_cast<std::uint32_t>(i + 1), fingerprints[i].data(), fingerprints[i].size());
+  }
+  olaf::FingerprintStream stream(
+    config, db, [](int, float, float, std::uint32_t, float, float) {}, &arena);
+  const std::size_t after_init = arena.used();
+
+  int identified = 0;
+  for (std::size_t i = 0; i < songs.size(); ++i) {
+    std::vector<std::int16_t> excerpt(
+      songs[i].begin() + 5 * config.audioSampleRate, songs[i].end());
+    host::add_noise(excerpt, 20, static_cast<std::uint32_t>(i));
+
+    olaf::HeapGuard guard;
+    stream.reset();
+    for (std::size_t s = 0; s < excerpt.size(); s += config.audioStepSize) {
+      stream.process(
+        excerpt.data() + s, std::min<std::size_t>(config.audioStepSize, excerpt.size() - s));
+    }
+    if (stream.matcher().get_best_audio_id() == i + 1) {
+      identified++;
+    }
+  }
+
+  std::printf(
+    "Arena: %zu bytes after init, %zu bytes after %zu queries (%zu allocations)\n", after_init,
+    arena.used(), songs.size(), arena.get_allocations());
+  std::printf("Identified %d/%zu without heap allocations\n", identified, songs.size());
+  // recognition itself is measured by replay, this only checks the pipeline ran
+  return identified > 0 ? 0 : 1;
+}
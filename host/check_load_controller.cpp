@@ -0,0 +1,172 @@
+// Checks olaf::LoadController and its use in olaf::FingerprintStream on synthetic block times.
+//
+// The controller is fed made up block times instead of measured ones, so the
+// checks do not depend on the build machine. Single slow blocks must not
+// change the level, a sustained overload must raise it no faster than one
+// level per settle period, a load that the limits bring under the high mark
+// must settle on one level without oscillating, and a light load must bring
+// the level back to the Config limits. A stream timed by a fake clock, that
+// wraps around during the run, must apply and report the limits and restore
+// the Config limits when load control stops. Prints one line per check.
+//
+// Usage: check_load_controller
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "host_audio.hpp"
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+#include "olaf_fingerprint_stream.hpp"
+#include "olaf_load_controller.hpp"
+
+namespace
+{
+
+bool report(const char * check, bool ok)
+{
+  std::printf("%s: %s\n", check, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+// feeds blocks, block_us gets the block index and the current level, returns the level changes
+std::vector<int> run(
+  olaf::LoadController & controller, int blocks, const std::function<float(int, int)> & block_us)
+{
+  std::vector<int> changes;
+  for (int i = 0; i < blocks; ++i) {
+    if (controller.update(block_us(i, controller.get_level()))) changes.push_back(i);
+  }
+  return changes;
+}
+
+bool check_spikes(const olaf::Config & config)
+{
+  olaf::LoadController controller(config);
+  const float budget = controller.get_telemetry().budget_us;
+  // a light load with a block at three times the budget now and then, two in a row once
+  const auto changes = run(controller, 1000, [budget](int i, int) {
+    return i % 50 == 0 || i == 501 ? 3 * budget : 0.3f * budget;
+  });
+  const olaf::LoadTelemetry & t = controller.get_telemetry();
+  std::printf(
+    "  %u of %u blocks over budget, worst %.0f us\n", t.over_budget, t.blocks, t.worst_us);
+  return report("Single slow blocks keep the level", changes.empty() && t.level == 0);
+}
+
+bool check_overload(const olaf::Config & config)
+{
+  olaf::LoadController controller(config);
+  const float budget = controller.get_telemetry().budget_us;
+  const auto changes = run(controller, 200, [budget](int, int) { return 1.5f * budget; });
+
+  bool ok = !changes.empty() && controller.get_level() == olaf::LoadController::max_level;
+  // the first raise once a settle period is measured, the next ones a settle period apart
+  int previous = -1;
+  for (const int change : changes) {
+    ok = ok && change - previous >= static_cast<int>(olaf::LoadController::settle_blocks);
+    previous = change;
+  }
+  std::printf("  level %d after %zu raises\n", controller.get_level(), changes.size());
+  return report("Sustained overload raises one level per settle period", ok);
+}
+
+bool check_settles(const olaf::Config & config)
+{
+  olaf::LoadController controller(config);
+  const float budget = controller.get_telemetry().budget_us;
+  // every level makes a block 20% faster, level 3 is the first under the high mark
+  const auto changes = run(controller, 3000, [budget](int i, int level) {
+    const float jitter = i % 7 == 0 ? 0.1f : 0.0f;
+    return budget * (1.3f * std::pow(0.8f, static_cast<float>(level)) + jitter);
+  });
+  std::printf(
+    "  level %d, %zu changes, the last at block %d\n", controller.get_level(), changes.size(),
+    changes.empty() ? -1 : changes.back());
+  return report(
+    "Load under the high mark settles",
+    controller.get_level() == 3 && changes.size() == 3 && changes.back() < 200);
+}
+
+bool check_relaxes(const olaf::Config & config)
+{
+  olaf::LoadController controller(config);
+  const float budget = controller.get_telemetry().budget_us;
+  run(controller, 200, [budget](int, int) { return 2 * budget; });
+  const int raised = controller.get_level();
+
+  const auto changes = run(controller, 2000, [budget](int, int) { return 0.2f * budget; });
+  bool ok = raised > 0 && controller.get_level() == 0 && changes.size() == std::size_t(raised);
+  // lowering waits for relax_blocks of low load after every step
+  for (std::size_t i = 1; i < changes.size(); ++i) {
+    ok = ok &&
+         changes[i] - changes[i - 1] >= static_cast<int>(olaf::LoadController::relax_blocks);
+  }
+
+  const olaf::LoadTelemetry & t = controller.get_telemetry();
+  ok = ok && t.min_event_point_magnitude == config.minEventPointMagnitude &&
+       t.max_event_points == config.maxEventPoints && t.max_fingerprints == config.maxFingerprints;
+  return report("Light load returns to the Config limits", ok);
+}
+
+// a microsecond clock that advances by fake_block_us on every read
+std::uint32_t fake_now = 0;
+float fake_block_us = 0;
+
+std::uint32_t fake_clock()
+{
+  fake_now += static_cast<std::uint32_t>(fake_block_us);
+  return fake_now;
+}
+
+bool check_stream(const olaf::Config & config)
+{
+  olaf::DB db;
+  olaf::FingerprintStream stream(config, db, [](int, float, float, std::uint32_t, float, float) {});
+  const std::vector<std::int16_t> audio = host::synthetic_song(1, 10, config.audioSampleRate);
+
+  const float budget = 5000;
+  stream.set_load_control(fake_clock, budget);
+  // wraps around after about 40 blocks
+  fake_now = 0xFFFFFFFFu - 100000;
+  fake_block_us = 2 * budget;
+  stream.process(audio.data(), audio.size());
+
+  const olaf::LoadTelemetry & t = stream.get_load_telemetry();
+  const int blocks = stream.get_audio_block_index();
+  t.print();
+  bool ok = t.level > 0 && t.blocks == static_cast<std::uint32_t>(blocks) &&
+            t.over_budget == t.blocks && t.worst_us == 2 * budget && t.budget_us == budget &&
+            t.max_event_points < config.maxEventPoints &&
+            t.min_event_point_magnitude > config.minEventPointMagnitude;
+
+  // the level outlasts a reset, the processor did not change
+  const int level = t.level;
+  stream.reset();
+  ok = ok && stream.get_load_telemetry().level == level;
+
+  stream.set_load_control(nullptr);
+  stream.process(audio.data(), audio.size());
+  ok = ok && t.level == 0 && t.blocks == 0 && t.max_fingerprints == config.maxFingerprints &&
+       t.budget_us == olaf::LoadController::step_period_us(config);
+  return report("Stream applies the limits of a fake clock", ok);
+}
+
+}  // namespace
+
+int main()
+{
+  olaf::Config config = olaf::Config::create_mem();
+  config.verbose = false;
+  config.printResultEvery = 0;
+
+  bool ok = check_spikes(config);
+  ok = check_overload(config) && ok;
+  ok = check_settles(config) && ok;
+  ok = check_relaxes(config) && ok;
+  ok = check_stream(config) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+// Checks the C interface of olaf_c.h as the firmware uses it.
+//
+// olaf_c.cpp is compiled with -fno-exceptions -fno-rtti, as for the MCU. A
+// stream is created in a static buffer with synthetic songs as references,
+// indexed with the Q31 path like olaf_fp_ref_mem.h. Noisy excerpts are then
+// windowed and transformed with the float FFT every step, as the firmware's
+// audio pipeline does, and every spectrum is pushed and polled. Every poll
+// has to report what an olaf::SpectrumStream fed the same spectra reports,
+// and a correct match has to place the query at the right position in the
+// song. Prints when each excerpt was matched and the bytes of the buffer in
+// use. Recognition itself is measured by replay.
+//
+// Usage: check_olaf_c
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "host_audio.hpp"
+#include "olaf_c.h"
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+#include "olaf_spectrum_stream.hpp"
+#include "olaf_window.hpp"
+
+namespace
+{
+
+alignas(std::max_align_t) std::byte stream_buffer[4 << 20];
+
+// the excerpts start this far into the songs
+constexpr int excerpt_start_s = 5;
+
+}  // namespace
+
+int main()
+{
+  const olaf_config_profile profile = OLAF_CONFIG_MEM_TRACKING;
+  olaf::Config config = olaf::Config::create_mem_tracking();
+  config.verbose = false;
+  const int sample_rate = olaf_config_sample_rate(profile);
+  if (
+    sample_rate != config.audioSampleRate ||
+    olaf_config_step_size(profile) != config.audioStepSize ||
+    olaf_config_block_size(profile) != config.audioBlockSize) {
+    std::printf("Profile parameters do not match olaf::Config\n");
+    return 1;
+  }
+
+  // the reference fingerprints live in flash on the MCU, here on the heap
+  std::vector<std::vector<std::int16_t>> songs;
+  std::vector<std::vector<std::uint64_t>> fingerprints;
+  std::vector<olaf_reference> references;
+  for (std::uint32_t id = 1; id <= 4; ++id) {
+    songs.push_back(host::synthetic_song(id, 40, sample_rate));
+    fingerprints.push_back(host::index_audio(config, songs.back()));
+  }
+  for (std::size_t i = 0; i < fingerprints.size(); ++i) {
+    references.push_back(
+      {static_cast<std::uint32_t>(i + 1), fingerprints[i].data(), fingerprints[i].size()});
+  }
+
+  bool ok = olaf_stream_create(static_cast<olaf_config_profile>(7), nullptr, 0, stream_buffer,
+                               sizeof(stream_buffer)) == nullptr &&
+            olaf_stream_create(profile, nullptr, 0, stream_buffer, 16) == nullptr;
+  if (!ok) {
+    std::printf("Unknown profile or tiny buffer not refused\n");
+  }
+
+  olaf_stream * stream = olaf_stream_create(
+    profile, references.data(), references.size(), stream_buffer, sizeof(stream_buffer));
+  if (stream == nullptr) {
+    std::printf("Stream not created\n");
+    return 1;
+  }
+  const std::size_t after_create = olaf_stream_memory_used(stream);
+
+  // no load control until a clock is set: the profile's limits, nothing timed
+  olaf_load_state load{};
+  olaf_stream_poll_load(stream, &load);
+  if (
+    load.level != 0 || load.blocks != 0 || load.max_event_points != config.maxEventPoints ||
+    load.max_fingerprints != config.maxFingerprints) {
+    std::printf("Load state is not the profile's limits\n");
+    ok = false;
+  }
+
+  olaf::DB db;
+  for (const olaf_reference & reference : references) {
+    db.register_audio(reference.audio_id, reference.fingerprints, reference.fingerprint_count);
+  }
+  config.printResultEvery = 0;
+  olaf::SpectrumStream expected(
+    config, db, [](int, float, float, std::uint32_t, float, float) {});
+
+  const std::size_t block_size = config.audioBlockSize;
+  const float * window = olaf::fft_window(config.audioBlockSize);
+  std::vector<float> fft_in(block_size), spectrum(block_size);
+  int positioned = 0;
+  for (std::size_t i = 0; i < songs.size(); ++i) {
+    std::vector<std::int16_t> excerpt(
+      songs[i].begin() + excerpt_start_s * sample_rate, songs[i].end());
+    host::add_noise(excerpt, 20, static_cast<std::uint32_t>(i));
+
+    olaf_stream_reset(stream);
+    expected.reset();
+    bool same = true;
+    float matched_at = -1;
+    float drift = 0;
+    for (std::size_t s = 0; s + block_size <= excerpt.size(); s += config.audioStepSize) {
+      olaf::apply_window(excerpt.data() + s, window, fft_in.data(), block_size);
+      host::float_rfft(fft_in.data(), spectrum.data(), static_cast<int>(block_size));
+      olaf_stream_push_spectrum(stream, spectrum.data());
+      expected.process(spectrum.data());
+
+      olaf_match_state state{};
+      olaf_stream_poll(stream, &state);
+      const olaf::FPMatcher & matcher = expected.matcher();
+      const bool reported = config.minMatchConfidence > 0
+                              ? matcher.is_decided()
+                              : matcher.get_best_match_count() >= config.minMatchCount;
+      same = same && state.matched == reported && state.decided == matcher.is_decided() &&
+             state.confidence == matcher.get_confidence();
+      if (state.matched) {
+        const std::uint32_t id = matcher.is_decided()
+                                   ? matcher.get_decided_result().match_identifier
+                                   : matcher.get_best_audio_id();
+        same = same && state.audio_id == id;
+      }
+      if (state.matched && state.audio_id == i + 1 && matched_at < 0) {
+        matched_at = state.query_time;
+        drift = state.reference_time - (state.query_time + excerpt_start_s);
+      }
+    }
+
+    // the matched offset is within a few blocks of the true one
+    const bool in_place = matched_at >= 0 && std::fabs(drift) < 0.1f;
+    positioned += in_place ? 1 : 0;
+    if (matched_at >= 0) {
+      std::printf(
+        "Song %zu: matched after %.2f s, %.3f s from its position, %s the C++ stream\n", i + 1,
+        matched_at, drift, same ? "same as" : "DIFFERENT from");
+    } else {
+      std::printf(
+        "Song %zu: not matched, %s the C++ stream\n", i + 1, same ? "same as" : "DIFFERENT from");
+    }
+    ok = same && ok;
+  }
+
+  std::printf(
+    "Buffer: %zu bytes after create, %zu bytes after %zu queries\n", after_create,
+    olaf_stream_memory_used(stream), songs.size());
+  return ok && positioned > 0 ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+// Checks olaf::StopListBuilder and the query side stop-list of olaf::DB.
+//
+// Songs of random fingerprints over a small hash space, with a few hashes
+// repeated like a sustained tone, are counted by a StopListBuilder. build()
+// has to list exactly the hashes above the threshold and prune() has to drop
+// exactly their fingerprints. A DB with the full arrays and the stop-list set
+// then has to answer find() and find_near() like a DB of the pruned arrays
+// without one, for ranges narrower and wider than the 64 key mask and for a
+// range of stopped keys only. Prints the stop-list statistics.
+//
+// Usage: check_stop_list [max occurrences]
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "olaf_db.hpp"
+#include "olaf_stop_list.hpp"
+
+namespace
+{
+
+constexpr std::uint64_t hash_space = 4000;
+// hashes every song repeats, as a sustained tone would
+constexpr std::uint64_t tone_hashes[] = {100, 101, 103, 2500};
+
+std::vector<std::uint64_t> song_fingerprints(std::uint32_t seed)
+{
+  std::mt19937_64 random(seed);
+  std::vector<std::uint64_t> fingerprints;
+  for (int i = 0; i < 3000; ++i) {
+    fingerprints.push_back((random() % hash_space) << 16 | (random() & 0xFFFF));
+  }
+  for (const std::uint64_t hash : tone_hashes) {
+    for (int i = 0; i < 40; ++i) fingerprints.push_back(hash << 16 | (random() & 0xFFFF));
+  }
+  std::sort(fingerprints.begin(), fingerprints.end());
+  return fingerprints;
+}
+
+std::vector<std::uint64_t> sorted(std::vector<std::uint64_t> results)
+{
+  std::sort(results.begin(), results.end());
+  return results;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const std::size_t max_occurrences = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 30;
+
+  std::vector<std::vector<std::uint64_t>> songs;
+  olaf::StopListBuilder builder;
+  std::map<std::uint64_t, std::size_t> counts;
+  for (std::uint32_t id = 1; id <= 8; ++id) {
+    songs.push_back(song_fingerprints(id));
+    builder.add_song(songs.back());
+    for (const std::uint64_t packed : songs.back()) ++counts[packed >> 16];
+  }
+
+  bool ok = builder.build(0).empty() && builder.get_unique_hashes() == counts.size();
+
+  // build(): exactly the hashes with more than max_occurrences fingerprints, sorted
+  const std::vector<std::uint64_t> stop_list = builder.build(max_occurrences);
+  std::vector<std::uint64_t> expected_stop_list;
+  for (const auto & [hash, count] : counts) {
+    if (count > max_occurrences) expected_stop_list.push_back(hash);
+  }
+  const bool built = stop_list == expected_stop_list && !stop_list.empty();
+  std::printf(
+    "build(%zu): %zu hashes, %s\n", max_occurrences, stop_list.size(), built ? "ok" : "WRONG");
+  ok = built && ok;
+
+  // prune(): the same arrays without the stopped hashes, still sorted
+  std::vector<std::vector<std::uint64_t>> pruned(songs.size());
+  std::size_t removed = 0, kept = 0;
+  bool pruned_ok = true;
+  for (std::size_t i = 0; i < songs.size(); ++i) {
+    removed += olaf::StopListBuilder::prune(songs[i], stop_list, pruned[i]);
+    kept += pruned[i].size();
+
+    std::vector<std::uint64_t> expected;
+    for (const std::uint64_t packed : songs[i]) {
+      if (!std::binary_search(stop_list.begin(), stop_list.end(), packed >> 16)) {
+        expected.push_back(packed);
+      }
+    }
+    pruned_ok = pruned_ok && pruned[i] == expected;
+  }
+  const olaf::StopListStats stats = builder.get_stats(stop_list);
+  stats.print();
+  pruned_ok = pruned_ok && stats.fingerprints_after == kept &&
+              stats.fingerprints_before == kept + removed && removed > 0;
+  std::printf("prune(): %zu fingerprints removed, %s\n", removed, pruned_ok ? "ok" : "WRONG");
+  ok = pruned_ok && ok;
+
+  // query side: the stop-list on full arrays answers like the pruned arrays
+  olaf::DB full, without;
+  for (std::uint32_t i = 0; i < songs.size(); ++i) {
+    full.register_audio(i + 1, songs[i].data(), songs[i].size());
+    without.register_audio(i + 1, pruned[i].data(), pruned[i].size());
+  }
+  full.set_stop_list(stop_list);
+
+  const struct
+  {
+    std::uint64_t start_key;
+    std::uint64_t stop_key;
+  } ranges[] = {
+    {100, 100},    // a stopped key
+    {100, 101},    // stopped keys only
+    {98, 104},     // stopped keys among others
+    {70, 133},     // 64 keys, the widest masked range
+    {70, 134},     // 65 keys, checked per key
+    {0, 600},      // wide
+    {3990, 4010},  // past the hash space
+  };
+
+  bool queries_ok = true;
+  std::vector<std::uint64_t> full_results, without_results;
+  for (const auto & range : ranges) {
+    full.find(range.start_key, range.stop_key, full_results, 1 << 20);
+    without.find(range.start_key, range.stop_key, without_results, 1 << 20);
+    bool same = sorted(full_results) == sorted(without_results);
+
+    for (std::uint32_t audio_id = 1; audio_id <= songs.size(); ++audio_id) {
+      full.find_near(audio_id, range.start_key, range.stop_key, 1000, 30000, full_results, 1 << 20);
+      without.find_near(
+        audio_id, range.start_key, range.stop_key, 1000, 30000, without_results, 1 << 20);
+      same = same && full_results == without_results;
+    }
+    std::printf(
+      "Keys %llu..%llu: %s\n", static_cast<unsigned long long>(range.start_key),
+      static_cast<unsigned long long>(range.stop_key), same ? "same as pruned" : "DIFFERENT");
+    queries_ok = same && queries_ok;
+  }
+  for (const std::uint64_t hash : stop_list) {
+    queries_ok = queries_ok && full.is_stopped(hash) && !without.is_stopped(hash);
+  }
+  ok = queries_ok && ok;
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+// Checks the compile time windows and the apply_window kernels of olaf_window.hpp.
+//
+// The constexpr hamming_window tables have to match the literal tables in
+// olaf_window.c that the C code and the firmware use, and every apply_window
+// overload has to give exactly the scalar result, for lengths that are not a
+// multiple of the vector width and for unaligned buffers. Built once for the
+// build machine and once without AVX, so the SSE2 path is checked as well.
+// Prints the largest table difference and the kernel that was compiled in.
+//
+// Usage: check_window
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "olaf_window.h"
+#include "olaf_window.hpp"
+
+namespace
+{
+
+const char * kernel_name()
+{
+#if defined(OLAF_USE_CMSIS_DSP)
+  return "CMSIS-DSP";
+#elif defined(__AVX2__)
+  return "AVX2";
+#elif defined(__SSE2__)
+  return "SSE2";
+#elif defined(__ARM_NEON)
+  return "NEON";
+#else
+  return "scalar";
+#endif
+}
+
+// largest difference between a generated and a literal table, in units in the last place
+template <std::size_t N>
+int table_ulps(const float * literal)
+{
+  int worst = 0;
+  for (std::size_t i = 0; i < N; ++i) {
+    const float generated = olaf::hamming_window<N>[i];
+    int ulps = 0;
+    for (float f = std::fmin(generated, literal[i]); f < std::fmax(generated, literal[i]);
+         f = std::nextafter(f, 2.0f)) {
+      ++ulps;
+    }
+    worst = std::max(worst, ulps);
+  }
+  return worst;
+}
+
+template <typename Sample>
+bool same_as_scalar(
+  const std::vector<Sample> & samples, float scale, const float * window, std::size_t offset,
+  std::size_t n)
+{
+  std::vector<float> out(n + 1);
+  // out + 1 is never 32 byte aligned
+  olaf::apply_window(samples.data() + offset, window + offset, out.data() + 1, n);
+  for (std::size_t i = 0; i < n; ++i) {
+    const float expected = static_cast<float>(samples[offset + i]) * scale * window[offset + i];
+    if (out[i + 1] != expected) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main()
+{
+  const int ulps_1024 = table_ulps<1024>(hamming_window_1024);
+  const int ulps_512 = table_ulps<512>(hamming_window_512);
+  bool ok = ulps_1024 <= 1 && ulps_512 <= 1 && olaf::fft_window(1024) != nullptr &&
+            olaf::fft_window(1000) == nullptr;
+  std::printf(
+    "Generated tables against olaf_window.c: 1024 within %d ulp, 512 within %d ulp, %s\n",
+    ulps_1024, ulps_512, ok ? "ok" : "FAILED");
+
+  std::mt19937 random(1);
+  std::vector<std::int16_t> pcm16(1024);
+  std::vector<std::int32_t> pcm32(1024);
+  std::vector<float> floats(1024);
+  for (std::size_t i = 0; i < 1024; ++i) {
+    pcm16[i] = static_cast<std::int16_t>(random());
+    pcm32[i] = static_cast<std::int32_t>(random());
+    floats[i] = std::uniform_real_distribution<float>(-1, 1)(random);
+  }
+  // full scale samples as well
+  pcm16[3] = -32768;
+  pcm16[4] = 32767;
+  pcm32[5] = INT32_MIN;
+
+  const float * window = olaf::hamming_window<1024>.data();
+  bool kernels = true;
+  for (const std::size_t offset : {0, 1, 3}) {
+    for (const std::size_t n : {0, 1, 7, 8, 9, 15, 16, 17, 255, 1000}) {
+      kernels = kernels && same_as_scalar(pcm16, 1.0f / 32768.0f, window, offset, n) &&
+                same_as_scalar(pcm32, 1.0f / 2147483648.0f, window, offset, n) &&
+                same_as_scalar(floats, 1.0f, window, offset, n);
+    }
+  }
+  std::printf(
+    "apply_window (%s) against scalar: %s\n", kernel_name(), kernels ? "identical" : "DIFFERENT");
+
+  return ok && kernels ? 0 : 1;
+}
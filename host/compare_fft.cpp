@@ -0,0 +1,288 @@
+// Compares the float, Q15 and Q31 FFT paths of the event point extraction.
+//
+// Synthetic songs are indexed with the float path (window, real FFT,
+// EPExtractor). Noisy excerpts at several input levels are then matched three
+// times, through the float FFT with EPExtractor, FixedPointRFFT<int16_t> with
+// EPExtractorQ15 and FixedPointRFFT<int32_t> with EPExtractorQ31, each followed
+// by the same FPExtractor and FPMatcher. Prints the match rate of every path per
+// level and its difference to the float path. The Q15 FFT keeps few fraction
+// bits, so it is expected to lose matches on quiet input; Q31 is not.
+//
+// Usage: compare_fft [options]
+//   --config PROFILE            default, esp32, mem or mem-tracking (esp32)
+//   --synthetic N               Number of synthetic songs (20)
+//   --queries N                 Excerpts per song and level (1)
+//   --duration S                Excerpt length in seconds (8)
+//   --noise DB                  SNR of the added white noise (20)
+//   --max-q31-loss N            Exit with an error when Q31 matches N fewer than float (-1: never)
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "host_audio.hpp"
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+#include "olaf_ep_extractor.hpp"
+#include "olaf_fixed_point.hpp"
+#include "olaf_fp_extractor.hpp"
+#include "olaf_fp_hash.hpp"
+#include "olaf_fp_matcher.hpp"
+#include "olaf_window.hpp"
+
+namespace
+{
+
+// peak levels of the excerpts in dBFS
+constexpr float levels_dbfs[] = {-6, -20, -36};
+
+struct Options
+{
+  std::string profile = "esp32";
+  int synthetic = 20;
+  int queries = 1;
+  float duration = 8;
+  float noise_snr = 20;
+  int max_q31_loss = -1;
+};
+
+bool parse(int argc, char ** argv, Options & options)
+{
+  for (int i = 1; i < argc; ++i) {
+    const char * arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (std::strcmp(arg, "--config") == 0 && has_value) {
+      options.profile = argv[++i];
+    } else if (std::strcmp(arg, "--synthetic") == 0 && has_value) {
+      options.synthetic = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--queries") == 0 && has_value) {
+      options.queries = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--duration") == 0 && has_value) {
+      options.duration = static_cast<float>(std::atof(argv[++i]));
+    } else if (std::strcmp(arg, "--noise") == 0 && has_value) {
+      options.noise_snr = static_cast<float>(std::atof(argv[++i]));
+    } else if (std::strcmp(arg, "--max-q31-loss") == 0 && has_value) {
+      options.max_q31_loss = std::atoi(argv[++i]);
+    } else {
+      std::fprintf(stderr, "Unknown option %s\n", arg);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool profile_config(const std::string & profile, olaf::Config & config)
+{
+  if (profile == "default") {
+    config = olaf::Config::create_default();
+  } else if (profile == "esp32") {
+    config = olaf::Config::create_esp_32();
+  } else if (profile == "mem") {
+    config = olaf::Config::create_mem();
+  } else if (profile == "mem-tracking") {
+    config = olaf::Config::create_mem_tracking();
+  } else {
+    std::fprintf(stderr, "Unknown config profile %s\n", profile.c_str());
+    return false;
+  }
+  config.printResultEvery = 0;
+  config.verbose = false;
+  return true;
+}
+
+// window, FFT and event point extraction of the float path
+class FloatPath
+{
+private:
+  const float * window_;
+  std::vector<float> in_, out_;
+  olaf::EPExtractor ep_extractor_;
+
+public:
+  explicit FloatPath(const olaf::Config & config)
+  : window_(olaf::fft_window(config.audioBlockSize)),
+    in_(config.audioBlockSize),
+    out_(config.audioBlockSize),
+    ep_extractor_(config)
+  {
+  }
+
+  olaf::ExtractedEventPoints & extract(const std::int16_t * pcm, int block_index)
+  {
+    olaf::apply_window(pcm, window_, in_.data(), in_.size());
+    host::float_rfft(in_.data(), out_.data(), static_cast<int>(in_.size()));
+    ep_extractor_.extract(out_.data(), block_index);
+    return ep_extractor_.event_points();
+  }
+};
+
+// window, FFT and event point extraction of the Q15 (int16_t) or Q31 (int32_t) path
+template <typename Sample>
+class FixedPath
+{
+private:
+  using Extractor = std::conditional_t<
+    std::is_same_v<Sample, std::int16_t>, olaf::EPExtractorQ15, olaf::EPExtractorQ31>;
+
+  std::vector<std::int16_t> window_;
+  std::vector<Sample> in_, out_;
+  olaf::FixedPointRFFT<Sample> fft_;
+  Extractor ep_extractor_;
+
+public:
+  explicit FixedPath(const olaf::Config & config)
+  : window_(host::window_q15(config.audioBlockSize)),
+    in_(config.audioBlockSize),
+    out_(2 * config.audioBlockSize),
+    fft_(config.audioBlockSize),
+    ep_extractor_(config, fft_.fraction_bits())
+  {
+  }
+
+  olaf::ExtractedEventPoints & extract(const std::int16_t * pcm, int block_index)
+  {
+    olaf::apply_window(pcm, window_.data(), in_.data(), in_.size());
+    fft_.transform(in_.data(), out_.data());
+    ep_extractor_.extract(out_.data(), block_index);
+    return ep_extractor_.event_points();
+  }
+};
+
+template <typename Path>
+std::vector<std::uint64_t> index_song(
+  const olaf::Config & config, const std::vector<std::int16_t> & audio)
+{
+  Path path(config);
+  olaf::FPExtractor fp_extractor(config);
+  olaf::FingerprintBatch batch;
+  std::vector<std::uint64_t> packed;
+  int block_index = 0;
+  for (std::size_t start = 0; start + config.audioBlockSize <= audio.size();
+       start += config.audioStepSize, ++block_index) {
+    fp_extractor.extract(path.extract(audio.data() + start, block_index), block_index);
+    auto & fingerprints = fp_extractor.get_fingerprints();
+    batch.assign(fingerprints);
+    batch.hash(config.hashLayout);
+    for (std::size_t i = 0; i < batch.size; ++i) {
+      packed.push_back((batch.hashes[i] << 16) + (batch.t1[i] & 0xFFFF));
+    }
+    fingerprints.fingerprint_index = 0;
+  }
+  std::sort(packed.begin(), packed.end());
+  return packed;
+}
+
+// whether the matcher reports the expected song at some point of the excerpt
+template <typename Path>
+bool identified(
+  const olaf::Config & config, const olaf::DB & db, const std::vector<std::int16_t> & excerpt,
+  std::uint32_t expected_id)
+{
+  Path path(config);
+  olaf::FPExtractor fp_extractor(config);
+  olaf::FPMatcher matcher(config, db, [](int, float, float, std::uint32_t, float, float) {});
+  int block_index = 0;
+  for (std::size_t start = 0; start + config.audioBlockSize <= excerpt.size();
+       start += config.audioStepSize, ++block_index) {
+    fp_extractor.extract(path.extract(excerpt.data() + start, block_index), block_index);
+    matcher.match(fp_extractor.get_fingerprints());
+
+    const std::uint32_t reported =
+      config.minMatchConfidence > 0
+        ? (matcher.is_decided() ? matcher.get_decided_result().match_identifier : 0)
+        : (matcher.get_best_match_count() >= config.minMatchCount ? matcher.get_best_audio_id()
+                                                                  : 0);
+    if (reported == expected_id) return true;
+  }
+  return false;
+}
+
+void scale_to_peak(std::vector<std::int16_t> & samples, float level_dbfs)
+{
+  int peak = 1;
+  for (const std::int16_t sample : samples) peak = std::max(peak, std::abs(int{sample}));
+  const float gain = 32767.0f * std::pow(10.0f, level_dbfs / 20) / static_cast<float>(peak);
+  for (std::int16_t & sample : samples) {
+    sample = static_cast<std::int16_t>(std::clamp(sample * gain, -32768.0f, 32767.0f));
+  }
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  Options options;
+  olaf::Config config;
+  if (!parse(argc, argv, options) || !profile_config(options.profile, config)) {
+    return 1;
+  }
+
+  std::vector<std::vector<std::int16_t>> songs;
+  std::vector<std::vector<std::uint64_t>> fingerprints;
+  olaf::DB db;
+  for (int i = 0; i < options.synthetic; ++i) {
+    songs.push_back(
+      host::synthetic_song(static_cast<std::uint32_t>(i + 1), 30, config.audioSampleRate));
+    fingerprints.push_back(index_song<FloatPath>(config, songs.back()));
+  }
+  for (std::size_t i = 0; i < songs.size(); ++i) {
+    db.register_audio(
+      static_cast<std::uint32_t>(i + 1), fingerprints[i].data(), fingerprints[i].size());
+  }
+
+  std::printf(
+    "Profile %s: %zu songs indexed with the float path, %.1f s excerpts, noise %.1f dB SNR\n",
+    options.profile.c_str(), songs.size(), options.duration, options.noise_snr);
+  std::printf("Level (dBFS)  float   Q15 (delta)   Q31 (delta)\n");
+
+  std::mt19937 generator(1);
+  int total[3] = {};
+  int queries = 0;
+  for (const float level : levels_dbfs) {
+    int matched[3] = {};
+    int level_queries = 0;
+    for (std::size_t s = 0; s < songs.size(); ++s) {
+      const std::size_t length = std::min(
+        songs[s].size(), static_cast<std::size_t>(options.duration * config.audioSampleRate));
+      std::uniform_int_distribution<std::size_t> offsets(0, songs[s].size() - length);
+      for (int q = 0; q < options.queries; ++q) {
+        const std::size_t offset = offsets(generator);
+        std::vector<std::int16_t> excerpt(
+          songs[s].begin() + offset, songs[s].begin() + offset + length);
+        host::add_noise(excerpt, options.noise_snr, generator());
+        scale_to_peak(excerpt, level);
+
+        const auto audio_id = static_cast<std::uint32_t>(s + 1);
+        matched[0] += identified<FloatPath>(config, db, excerpt, audio_id) ? 1 : 0;
+        matched[1] += identified<FixedPath<std::int16_t>>(config, db, excerpt, audio_id) ? 1 : 0;
+        matched[2] += identified<FixedPath<std::int32_t>>(config, db, excerpt, audio_id) ? 1 : 0;
+        level_queries++;
+      }
+    }
+    std::printf(
+      "%12.0f  %2d/%-2d  %2d/%-2d (%+3d)  %2d/%-2d (%+3d)\n", level, matched[0], level_queries,
+      matched[1], level_queries, matched[1] - matched[0], matched[2], level_queries,
+      matched[2] - matched[0]);
+    for (int p = 0; p < 3; ++p) total[p] += matched[p];
+    queries += level_queries;
+  }
+
+  std::printf(
+    "Match rate: float %.1f%%, Q15 %.1f%% (%+.1f), Q31 %.1f%% (%+.1f)\n",
+    100.0 * total[0] / queries, 100.0 * total[1] / queries,
+    100.0 * (total[1] - total[0]) / queries, 100.0 * total[2] / queries,
+    100.0 * (total[2] - total[0]) / queries);
+
+  if (options.max_q31_loss >= 0 && total[0] - total[2] > options.max_q31_loss) {
+    std::printf("Q31 matched %d fewer excerpts than float\n", total[0] - total[2]);
+    return 1;
+  }
+  return 0;
+}
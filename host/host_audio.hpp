@@ -0,0 +1,324 @@
+// Audio helpers shared by the host tools: WAV input, test signals, degradations
+// and indexing into the packed arrays DB::register_audio expects.
+
+#ifndef PENLIGHT_HOST_AUDIO_HPP
+#define PENLIGHT_HOST_AUDIO_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "audio_decimator.h"
+#include "olaf_config.hpp"
+#include "olaf_ep_extractor.hpp"
+#include "olaf_fixed_point.hpp"
+#include "olaf_fp_extractor.hpp"
+#include "olaf_fp_hash.hpp"
+#include "olaf_window.hpp"
+
+namespace host
+{
+
+/**
+ * @brief Read a PCM 16 bit or float 32 bit WAV file, mixed down to mono
+ * @return false with a message on stderr when the file can not be used
+ */
+inline bool read_wav(const char * path, std::vector<std::int16_t> & samples, int & sample_rate)
+{
+  std::FILE * file = std::fopen(path, "rb");
+  if (file == nullptr) {
+    std::fprintf(stderr, "Could not open %s\n", path);
+    return false;
+  }
+
+  char riff[12];
+  if (std::fread(riff, 1, sizeof(riff), file) != sizeof(riff) ||
+      std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+    std::fprintf(stderr, "%s is not a WAV file\n", path);
+    std::fclose(file);
+    return false;
+  }
+
+  std::uint16_t format = 0, channels = 0, bits = 0;
+  std::uint32_t rate = 0;
+  bool have_format = false;
+  char chunk[8];
+  while (std::fread(chunk, 1, sizeof(chunk), file) == sizeof(chunk)) {
+    std::uint32_t size;
+    std::memcpy(&size, chunk + 4, sizeof(size));
+
+    if (std::memcmp(chunk, "fmt ", 4) == 0) {
+      std::vector<std::uint8_t> fmt(size);
+      if (size < 16 || std::fread(fmt.data(), 1, size, file) != size) break;
+      std::memcpy(&format, &fmt[0], 2);
+      std::memcpy(&channels, &fmt[2], 2);
+      std::memcpy(&rate, &fmt[4], 4);
+      std::memcpy(&bits, &fmt[14], 2);
+      // WAVE_FORMAT_EXTENSIBLE keeps the real format in the sub format GUID
+      if (format == 0xFFFE && size >= 26) std::memcpy(&format, &fmt[24], 2);
+      have_format = true;
+    } else if (std::memcmp(chunk, "data", 4) == 0 && have_format) {
+      const bool pcm16 = format == 1 && bits == 16;
+      const bool float32 = format == 3 && bits == 32;
+      if ((!pcm16 && !float32) || channels == 0) {
+        std::fprintf(
+          stderr, "%s: only 16 bit PCM and 32 bit float WAV files are supported\n", path);
+        break;
+      }
+
+      std::vector<std::uint8_t> data(size);
+      const std::size_t read = std::fread(data.data(), 1, size, file);
+      const std::size_t frames = read / (bits / 8) / channels;
+      samples.resize(frames);
+      for (std::size_t i = 0; i < frames; ++i) {
+        float sum = 0;
+        for (std::size_t c = 0; c < channels; ++c) {
+          const std::size_t index = i * channels + c;
+          if (pcm16) {
+            std::int16_t value;
+            std::memcpy(&value, &data[index * 2], 2);
+            sum += value;
+          } else {
+            float value;
+            std::memcpy(&value, &data[index * 4], 4);
+            sum += value * 32768.0f;
+          }
+        }
+        samples[i] = static_cast<std::int16_t>(std::clamp(sum / channels, -32768.0f, 32767.0f));
+      }
+      sample_rate = static_cast<int>(rate);
+      std::fclose(file);
+      return true;
+    } else if (std::fseek(file, size + (size & 1), SEEK_CUR) != 0) {
+      break;
+    }
+  }
+
+  std::fprintf(stderr, "%s: no usable audio data\n", path);
+  std::fclose(file);
+  return false;
+}
+
+/**
+ * @brief Bring audio to the olaf sample rate, integer multiples are decimated
+ */
+inline bool resample(std::vector<std::int16_t> & samples, int sample_rate, int olaf_rate)
+{
+  if (sample_rate == olaf_rate) return true;
+  if (sample_rate % olaf_rate != 0) {
+    std::fprintf(
+      stderr, "Sample rate %d Hz is not a multiple of %d Hz, resample the file first\n",
+      sample_rate, olaf_rate);
+    return false;
+  }
+
+  const int factor = sample_rate / olaf_rate;
+  if (factor > AUDIO_DECIMATOR_MAX_FACTOR) {
+    std::fprintf(
+      stderr, "Sample rate %d Hz is over %d times %d Hz, resample the file first\n",
+      sample_rate, AUDIO_DECIMATOR_MAX_FACTOR, olaf_rate);
+    return false;
+  }
+
+  // the firmware's decimator, the last block padded with silence
+  const std::size_t block = 1024 * static_cast<std::size_t>(factor);
+  std::vector<std::int16_t> state(AUDIO_DECIMATOR_STATE_LENGTH(block));
+  audio_decimator decimator;
+  audio_decimator_init(&decimator, factor, state.data(), block);
+  const std::size_t produced = samples.size() / factor;
+  samples.resize((samples.size() + block - 1) / block * block, 0);
+  for (std::size_t i = 0; i < samples.size(); i += block) {
+    // in place: output i / factor never passes the input still to be read
+    audio_decimator_process(&decimator, samples.data() + i, samples.data() + i / factor);
+  }
+  samples.resize(produced);
+  return true;
+}
+
+/**
+ * @brief Notes with harmonics and a decaying envelope, enough structure for stable event points
+ */
+inline std::vector<std::int16_t> synthetic_song(std::uint32_t seed, int seconds, int sample_rate)
+{
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> uniform(0, 1);
+  std::normal_distribution<float> noise(0, 1);
+
+  std::vector<std::int16_t> audio(static_cast<std::size_t>(seconds) * sample_rate);
+  std::size_t i = 0;
+  while (i < audio.size()) {
+    const int length = static_cast<int>(sample_rate * (0.1f + 0.3f * uniform(generator)));
+    float frequencies[3];
+    for (float & f : frequencies) {
+      f = 200 + 2500 * uniform(generator) * uniform(generator);
+    }
+    for (int k = 0; k < length && i < audio.size(); ++k, ++i) {
+      const float t = static_cast<float>(k) / sample_rate;
+      float value = 0;
+      for (float f : frequencies) {
+        value += std::sin(6.2831853f * f * t) + 0.4f * std::sin(6.2831853f * 2 * f * t);
+      }
+      value = value * std::exp(-3 * t) / 4 + 0.02f * noise(generator);
+      audio[i] = static_cast<std::int16_t>(std::clamp(value * 8000.0f, -32768.0f, 32767.0f));
+    }
+  }
+  return audio;
+}
+
+/**
+ * @brief Add white noise at a signal to noise ratio relative to the RMS of the audio
+ */
+inline void add_noise(std::vector<std::int16_t> & samples, float snr_db, std::uint32_t seed)
+{
+  double energy = 0;
+  for (const std::int16_t sample : samples) {
+    energy += static_cast<double>(sample) * sample;
+  }
+  const double rms = std::sqrt(energy / std::max<std::size_t>(1, samples.size()));
+
+  std::mt19937 generator(seed);
+  std::normal_distribution<float> noise(0, static_cast<float>(rms * std::pow(10.0, -snr_db / 20)));
+  for (std::int16_t & sample : samples) {
+    sample = static_cast<std::int16_t>(std::clamp(sample + noise(generator), -32768.0f, 32767.0f));
+  }
+}
+
+/**
+ * @brief Schroeder reverb: four parallel combs and two allpasses
+ * @param rt60 Time in seconds for the tail to decay by 60 dB
+ * @param wet Part of the reverberated signal in the output, 0..1
+ */
+inline void add_reverb(std::vector<std::int16_t> & samples, float rt60, float wet, int sample_rate)
+{
+  const int comb_delays[4] = {1557, 1617, 1491, 1422};
+  const int allpass_delays[2] = {225, 556};
+  const float scale = sample_rate / 44100.0f;
+
+  std::vector<std::vector<float>> combs, allpasses;
+  float feedback[4];
+  for (int i = 0; i < 4; ++i) {
+    const int delay = std::max(1, static_cast<int>(comb_delays[i] * scale));
+    combs.emplace_back(delay, 0.0f);
+    // gain per pass so the loop decays 60 dB in rt60 seconds
+    feedback[i] = std::pow(10.0f, -3.0f * delay / (rt60 * sample_rate));
+  }
+  for (int delay : allpass_delays) {
+    allpasses.emplace_back(std::max(1, static_cast<int>(delay * scale)), 0.0f);
+  }
+
+  std::size_t positions[6] = {};
+  for (std::int16_t & sample : samples) {
+    const float dry = sample / 32768.0f;
+    float comb_sum = 0;
+    for (int i = 0; i < 4; ++i) {
+      float & slot = combs[i][positions[i]];
+      const float delayed = slot;
+      slot = dry + delayed * feedback[i];
+      comb_sum += delayed;
+      positions[i] = (positions[i] + 1) % combs[i].size();
+    }
+
+    float value = comb_sum / 4;
+    for (int i = 0; i < 2; ++i) {
+      float & slot = allpasses[i][positions[4 + i]];
+      const float delayed = slot;
+      slot = value + delayed * 0.5f;
+      value = delayed - 0.5f * slot;
+      positions[4 + i] = (positions[4 + i] + 1) % allpasses[i].size();
+    }
+
+    const float out = (1 - wet) * dry + wet * value;
+    sample = static_cast<std::int16_t>(std::clamp(out * 32768.0f, -32768.0f, 32767.0f));
+  }
+}
+
+/**
+ * @brief Real FFT in the output layout of arm_rfft_fast_f32: DC and Nyquist in the
+ * first pair, then bins 1 .. n/2 - 1 interleaved re/im, unscaled.
+ */
+inline void float_rfft(const float * in, float * out, int n)
+{
+  std::vector<std::complex<double>> x(in, in + n);
+  for (int i = 1, j = 0; i < n; ++i) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(x[i], x[j]);
+  }
+  for (int length = 2; length <= n; length <<= 1) {
+    const std::complex<double> step = std::polar(1.0, -2.0 * 3.14159265358979323846 / length);
+    for (int start = 0; start < n; start += length) {
+      std::complex<double> w = 1;
+      for (int k = 0; k < length / 2; ++k, w *= step) {
+        const std::complex<double> t = w * x[start + k + length / 2];
+        x[start + k + length / 2] = x[start + k] - t;
+        x[start + k] += t;
+      }
+    }
+  }
+  out[0] = static_cast<float>(x[0].real());
+  out[1] = static_cast<float>(x[n / 2].real());
+  for (int k = 1; k < n / 2; ++k) {
+    out[2 * k] = static_cast<float>(x[k].real());
+    out[2 * k + 1] = static_cast<float>(x[k].imag());
+  }
+}
+
+/**
+ * @brief Q15 copy of the Hamming window for an audio block
+ */
+inline std::vector<std::int16_t> window_q15(int audio_block_size)
+{
+  std::vector<std::int16_t> window(audio_block_size);
+  const float * float_window = olaf::fft_window(audio_block_size);
+  for (std::size_t i = 0; i < window.size(); ++i) {
+    window[i] = static_cast<std::int16_t>(std::min(32767.0f, float_window[i] * 32768.0f + 0.5f));
+  }
+  return window;
+}
+
+/**
+ * @brief The sorted, packed fingerprints (hash << 16 | t1) of a song, as DB::register_audio expects
+ *
+ * Uses the same Q31 FFT and extractors as olaf::FingerprintStream, and hashes with
+ * config.hashLayout.
+ */
+inline std::vector<std::uint64_t> index_audio(
+  const olaf::Config & config, const std::vector<std::int16_t> & audio)
+{
+  const std::vector<std::int16_t> window = window_q15(config.audioBlockSize);
+  olaf::FixedPointRFFT<std::int32_t> fft(config.audioBlockSize);
+  olaf::EPExtractorQ31 ep_extractor(config, fft.fraction_bits());
+  olaf::FPExtractor fp_extractor(config);
+  std::vector<std::int32_t> fft_in(config.audioBlockSize), fft_out(2 * config.audioBlockSize);
+  olaf::FingerprintBatch batch;
+
+  std::vector<std::uint64_t> packed;
+  int block_index = 0;
+  for (std::size_t start = 0; start + config.audioBlockSize <= audio.size();
+       start += config.audioStepSize, ++block_index) {
+    olaf::apply_window(audio.data() + start, window.data(), fft_in.data(), fft_in.size());
+    fft.transform(fft_in.data(), fft_out.data());
+    ep_extractor.extract(fft_out.data(), block_index);
+    fp_extractor.extract(ep_extractor.event_points(), block_index);
+
+    auto & fingerprints = fp_extractor.get_fingerprints();
+    batch.assign(fingerprints);
+    batch.hash(config.hashLayout);
+    for (std::size_t i = 0; i < batch.size; ++i) {
+      packed.push_back((batch.hashes[i] << 16) + (batch.t1[i] & 0xFFFF));
+    }
+    fingerprints.fingerprint_index = 0;
+  }
+  std::sort(packed.begin(), packed.end());
+  return packed;
+}
+
+}  // namespace host
+
+#endif  // PENLIGHT_HOST_AUDIO_HPP
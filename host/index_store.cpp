@@ -0,0 +1,293 @@
+// Indexes a catalog into a fingerprint store with bounded memory.
+//
+// Worker threads read and fingerprint the songs, olaf::FPStoreBuilder spills
+// every song and the hashes for the stop-list to temporary files, and merges
+// them into the store at the end. Only the songs being fingerprinted, the run
+// buffer and the merge buffers are in memory, so the catalog can be much larger
+// than RAM. Progress is printed as songs/s and MB/s of audio, followed by the
+// time of the extraction and the merge.
+//
+// With --check the catalog is indexed a second time in memory with
+// StopListBuilder and FPStoreWriter, and both stores have to be identical.
+//
+// Usage: index_store [options] output.store [reference.wav ...]
+//   --config default|esp32|mem  Config profile (mem)
+//   --hash-layout 1|2           Hash layout (the profile's)
+//   --max-occurrences N         Stop-list threshold, 0 for none (50)
+//   --synthetic N               N synthetic songs, used when no WAV files are given (100)
+//   --seconds S                 Length of a synthetic song (180)
+//   --threads N                 Fingerprinting threads (hardware threads)
+//   --run-kib N                 Hashes sorted in memory per run (65536)
+//   --fan-in N                  Runs merged at once (64)
+//   --check                     Compare with a store built in memory
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "host_audio.hpp"
+#include "olaf_config.hpp"
+#include "olaf_fp_store.hpp"
+#include "olaf_fp_store_builder.hpp"
+#include "olaf_stop_list.hpp"
+
+namespace
+{
+
+struct Options
+{
+  std::string profile = "mem";
+  int hash_layout = 0;
+  // the profiles leave the stop-list off, it is chosen when indexing
+  int max_occurrences = 50;
+  std::string output;
+  std::vector<std::string> references;
+  int synthetic = 100;
+  int seconds = 180;
+  std::size_t threads = 0;
+  std::size_t run_kib = olaf::FPStoreBuilder::default_run_bytes / 1024;
+  std::size_t fan_in = olaf::FPStoreBuilder::default_fan_in;
+  bool check = false;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+bool parse(int argc, char ** argv, Options & options)
+{
+  for (int i = 1; i < argc; ++i) {
+    const char * arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (std::strcmp(arg, "--config") == 0 && has_value) {
+      options.profile = argv[++i];
+    } else if (std::strcmp(arg, "--hash-layout") == 0 && has_value) {
+      options.hash_layout = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--max-occurrences") == 0 && has_value) {
+      options.max_occurrences = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--synthetic") == 0 && has_value) {
+      options.synthetic = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--seconds") == 0 && has_value) {
+      options.seconds = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--threads") == 0 && has_value) {
+      options.threads = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(arg, "--run-kib") == 0 && has_value) {
+      options.run_kib = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(arg, "--fan-in") == 0 && has_value) {
+      options.fan_in = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(arg, "--check") == 0) {
+      options.check = true;
+    } else if (arg[0] == '-') {
+      std::fprintf(stderr, "Unknown option %s\n", arg);
+      return false;
+    } else if (options.output.empty()) {
+      options.output = arg;
+    } else {
+      options.references.push_back(arg);
+    }
+  }
+  if (options.output.empty()) {
+    std::fprintf(stderr, "Usage: index_store [options] output.store [reference.wav ...]\n");
+    return false;
+  }
+  return true;
+}
+
+bool profile_config(const std::string & profile, olaf::Config & config)
+{
+  if (profile == "default") {
+    config = olaf::Config::create_default();
+  } else if (profile == "esp32") {
+    config = olaf::Config::create_esp_32();
+  } else if (profile == "mem") {
+    config = olaf::Config::create_mem();
+  } else {
+    std::fprintf(stderr, "Unknown config profile %s\n", profile.c_str());
+    return false;
+  }
+  config.verbose = false;
+  return true;
+}
+
+// the audio of song index, audio id index + 1
+bool load(
+  const Options & options, const olaf::Config & config, std::size_t index,
+  std::vector<std::int16_t> & samples)
+{
+  if (options.references.empty()) {
+    samples = host::synthetic_song(
+      static_cast<std::uint32_t>(index + 1), options.seconds, config.audioSampleRate);
+    return true;
+  }
+  int sample_rate = 0;
+  return host::read_wav(options.references[index].c_str(), samples, sample_rate) &&
+         host::resample(samples, sample_rate, config.audioSampleRate);
+}
+
+// the store written the in memory way, for --check
+bool write_in_memory(const Options & options, const olaf::Config & config, const char * path)
+{
+  const std::size_t song_count =
+    options.references.empty() ? options.synthetic : options.references.size();
+  std::vector<std::vector<std::uint64_t>> fingerprints(song_count);
+  std::vector<std::uint32_t> durations(song_count);
+  olaf::StopListBuilder stop_list_builder;
+  for (std::size_t i = 0; i < song_count; ++i) {
+    std::vector<std::int16_t> samples;
+    if (!load(options, config, i, samples)) return false;
+    fingerprints[i] = host::index_audio(config, samples);
+    durations[i] =
+      static_cast<std::uint32_t>(samples.size() * std::uint64_t{1000} / config.audioSampleRate);
+    stop_list_builder.add_song(fingerprints[i]);
+  }
+  const std::vector<std::uint64_t> stop_list = stop_list_builder.build(config);
+
+  olaf::FPStoreWriter writer;
+  writer.set_hash_layout(config.hashLayout);
+  writer.set_stop_list(stop_list);
+  std::vector<std::vector<std::uint64_t>> pruned(song_count);
+  for (std::size_t i = 0; i < song_count; ++i) {
+    olaf::StopListBuilder::prune(fingerprints[i], stop_list, pruned[i]);
+    writer.add_song(static_cast<std::uint32_t>(i + 1), pruned[i], durations[i]);
+  }
+  return writer.write(path);
+}
+
+bool same_files(const char * a, const char * b)
+{
+  std::FILE * file_a = std::fopen(a, "rb");
+  std::FILE * file_b = std::fopen(b, "rb");
+  bool same = file_a != nullptr && file_b != nullptr;
+  std::vector<char> buffer_a(1 << 16), buffer_b(1 << 16);
+  while (same) {
+    const std::size_t read_a = std::fread(buffer_a.data(), 1, buffer_a.size(), file_a);
+    const std::size_t read_b = std::fread(buffer_b.data(), 1, buffer_b.size(), file_b);
+    same = read_a == read_b && std::memcmp(buffer_a.data(), buffer_b.data(), read_a) == 0;
+    if (read_a < buffer_a.size()) break;
+  }
+  if (file_a != nullptr) std::fclose(file_a);
+  if (file_b != nullptr) std::fclose(file_b);
+  return same;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  Options options;
+  olaf::Config config;
+  if (!parse(argc, argv, options) || !profile_config(options.profile, config)) {
+    return 1;
+  }
+  if (options.hash_layout != 0) {
+    config.hashLayout = options.hash_layout;
+  }
+  config.maxHashOccurrences = static_cast<std::size_t>(std::max(0, options.max_occurrences));
+
+  const std::size_t song_count =
+    options.references.empty() ? options.synthetic : options.references.size();
+  const std::size_t threads = options.threads > 0
+                                ? options.threads
+                                : std::max(1u, std::thread::hardware_concurrency());
+  std::printf(
+    "Profile %s, hash layout %d, stop-list over %zu: %zu songs on %zu threads, %zu KiB runs, "
+    "fan-in %zu\n",
+    options.profile.c_str(), config.hashLayout, config.maxHashOccurrences, song_count, threads,
+    options.run_kib, options.fan_in);
+
+  olaf::FPStoreBuilder builder(
+    config, options.output.c_str(), options.run_kib * 1024, options.fan_in);
+
+  std::mutex mutex;
+  std::atomic<std::size_t> next_song{0};
+  std::atomic<bool> failed{false};
+  std::size_t done = 0;
+  std::uint64_t audio_bytes = 0;
+  const auto start = Clock::now();
+  auto last_report = start;
+
+  const auto report = [&](const char * end) {
+    const double elapsed = seconds_since(start);
+    std::fprintf(
+      stderr, "\r%zu/%zu songs, %.1f songs/s, %.1f MB/s audio, %.1f MB spilled%s", done,
+      song_count, done / elapsed, audio_bytes / elapsed / 1e6, builder.get_spilled_bytes() / 1e6,
+      end);
+  };
+
+  const auto work = [&]() {
+    std::vector<std::int16_t> samples;
+    for (std::size_t i = next_song++; i < song_count && !failed; i = next_song++) {
+      if (!load(options, config, i, samples)) {
+        failed = true;
+        break;
+      }
+      const std::vector<std::uint64_t> fingerprints = host::index_audio(config, samples);
+      const auto duration_ms =
+        static_cast<std::uint32_t>(samples.size() * std::uint64_t{1000} / config.audioSampleRate);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!builder.add_song(static_cast<std::uint32_t>(i + 1), fingerprints, duration_ms)) {
+        failed = true;
+        break;
+      }
+      ++done;
+      audio_bytes += samples.size() * sizeof(std::int16_t);
+      if (seconds_since(last_report) >= 1) {
+        last_report = Clock::now();
+        report("");
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t < threads; ++t) {
+    workers.emplace_back(work);
+  }
+  for (std::thread & worker : workers) {
+    worker.join();
+  }
+  if (failed) {
+    std::fprintf(stderr, "\n");
+    return 1;
+  }
+  report("\n");
+  const double extract_s = seconds_since(start);
+
+  const auto merge_start = Clock::now();
+  const std::uint64_t spilled = builder.get_spilled_bytes();
+  if (!builder.finish()) {
+    return 1;
+  }
+  const double merge_s = seconds_since(merge_start);
+
+  std::printf(
+    "Extracted %zu songs in %.2f s: %.1f songs/s, %.1f MB/s audio, %zu runs\n", song_count,
+    extract_s, song_count / extract_s, audio_bytes / extract_s / 1e6, builder.get_run_count());
+  std::printf(
+    "Merged in %.2f s: %.1f MB/s spilled, %llu fingerprints, %zu stop-list hashes, "
+    "%.1f MB store\n",
+    merge_s, spilled / merge_s / 1e6,
+    static_cast<unsigned long long>(builder.get_total_fingerprints()),
+    builder.get_stop_list().size(), builder.get_file_size() / 1e6);
+
+  if (options.check) {
+    const std::string reference = options.output + ".check";
+    const bool same =
+      write_in_memory(options, config, reference.c_str()) &&
+      same_files(options.output.c_str(), reference.c_str());
+    std::remove(reference.c_str());
+    std::printf("In memory store: %s\n", same ? "identical" : "DIFFERENT");
+    if (!same) return 1;
+  }
+  return 0;
+}
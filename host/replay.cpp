@@ -0,0 +1,378 @@
+// Offline replay of audio through the complete fingerprinting pipeline.
+//
+// References are indexed into a DB with the selected Config profile. Excerpts
+// of the references, optionally degraded with noise and reverb, are then fed
+// block by block through window, FFT, EPExtractor, FPExtractor and FPMatcher,
+// the way the capture thread delivers them. Audio that is not in the DB gives
+// the false positive rate. The report is meant to be compared before and
+// after every DSP or Config change.
+//
+// Usage: replay [options] [reference.wav ...]
+//   --config PROFILE            default, esp32, mem or mem-tracking (mem)
+//   --hash-layout 1|2           Hash layout of the index and the queries (the profile's)
+//   --exact-after N             Exact hash lookups first once an offset has N votes (the profile's)
+//   --max-occurrences N         Stop-list hashes occurring more than N times, 0: none (the profile's)
+//   --prune                     Remove stop-list hashes from the index instead of skipping them
+//   --synthetic N               N synthetic songs, used when no WAV files are given (20)
+//   --negative FILE             WAV file that is not in the DB, repeatable
+//   --queries N                 Excerpts per reference (3)
+//   --duration S                Excerpt length in seconds (20)
+//   --noise DB                  Add white noise at this SNR
+//   --reverb RT60               Add reverb decaying 60 dB in RT60 seconds
+//   --wet W                     Reverb mix, 0..1 (0.3)
+//   --seed N                    Seed of the excerpt offsets and noise (1)
+//   --verbose                   One line per query
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "host_audio.hpp"
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+#include "olaf_stop_list.hpp"
+#include "olaf_stream_pool.hpp"
+
+namespace
+{
+
+struct Options
+{
+  std::string profile = "mem";
+  int hash_layout = 0;
+  int exact_lookup_votes = -1;
+  long max_occurrences = -1;
+  bool prune = false;
+  std::vector<std::string> references;
+  std::vector<std::string> negatives;
+  int synthetic = 20;
+  int queries = 3;
+  float duration = 20;
+  float noise_snr = 0;
+  bool noise = false;
+  float reverb_rt60 = 0;
+  float wet = 0.3f;
+  std::uint32_t seed = 1;
+  bool verbose = false;
+};
+
+struct Audio
+{
+  std::string name;
+  std::uint32_t audio_id;  // 0 when not in the DB
+  std::vector<std::int16_t> samples;
+};
+
+struct QueryResult
+{
+  bool identified = false;
+  bool false_positive = false;
+  float first_correct_s = 0;
+  double cpu_us = 0;
+  float audio_s = 0;
+  std::uint64_t db_lookups = 0;
+  std::uint64_t db_exact_lookups = 0;
+  std::uint64_t db_exact_misses = 0;
+  std::uint64_t db_hits = 0;
+};
+
+double thread_cpu_us()
+{
+  std::timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+bool parse(int argc, char ** argv, Options & options)
+{
+  for (int i = 1; i < argc; ++i) {
+    const char * arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (std::strcmp(arg, "--config") == 0 && has_value) {
+      options.profile = argv[++i];
+    } else if (std::strcmp(arg, "--hash-layout") == 0 && has_value) {
+      options.hash_layout = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--exact-after") == 0 && has_value) {
+      options.exact_lookup_votes = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--max-occurrences") == 0 && has_value) {
+      options.max_occurrences = std::atol(argv[++i]);
+    } else if (std::strcmp(arg, "--prune") == 0) {
+      options.prune = true;
+    } else if (std::strcmp(arg, "--synthetic") == 0 && has_value) {
+      options.synthetic = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--negative") == 0 && has_value) {
+      options.negatives.push_back(argv[++i]);
+    } else if (std::strcmp(arg, "--queries") == 0 && has_value) {
+      options.queries = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--duration") == 0 && has_value) {
+      options.duration = static_cast<float>(std::atof(argv[++i]));
+    } else if (std::strcmp(arg, "--noise") == 0 && has_value) {
+      options.noise = true;
+      options.noise_snr = static_cast<float>(std::atof(argv[++i]));
+    } else if (std::strcmp(arg, "--reverb") == 0 && has_value) {
+      options.reverb_rt60 = static_cast<float>(std::atof(argv[++i]));
+    } else if (std::strcmp(arg, "--wet") == 0 && has_value) {
+      options.wet = static_cast<float>(std::atof(argv[++i]));
+    } else if (std::strcmp(arg, "--seed") == 0 && has_value) {
+      options.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    } else if (std::strcmp(arg, "--verbose") == 0) {
+      options.verbose = true;
+    } else if (arg[0] == '-') {
+      std::fprintf(stderr, "Unknown option %s\n", arg);
+      return false;
+    } else {
+      options.references.push_back(arg);
+    }
+  }
+  return true;
+}
+
+bool profile_config(const std::string & profile, olaf::Config & config)
+{
+  if (profile == "default") {
+    config = olaf::Config::create_default();
+  } else if (profile == "esp32") {
+    config = olaf::Config::create_esp_32();
+  } else if (profile == "mem") {
+    config = olaf::Config::create_mem();
+  } else if (profile == "mem-tracking") {
+    config = olaf::Config::create_mem_tracking();
+  } else {
+    std::fprintf(stderr, "Unknown config profile %s\n", profile.c_str());
+    return false;
+  }
+  // results are polled from the matcher, not printed
+  config.printResultEvery = 0;
+  config.verbose = false;
+  return true;
+}
+
+bool load(
+  const std::string & path, std::uint32_t audio_id, const olaf::Config & config, Audio & audio)
+{
+  int sample_rate = 0;
+  audio.name = path;
+  audio.audio_id = audio_id;
+  return host::read_wav(path.c_str(), audio.samples, sample_rate) &&
+         host::resample(audio.samples, sample_rate, config.audioSampleRate);
+}
+
+// the audio id the matcher currently reports, 0 when it reports nothing
+std::uint32_t reported_audio_id(const olaf::Config & config, const olaf::FPMatcher & matcher)
+{
+  if (config.minMatchConfidence > 0) {
+    return matcher.is_decided() ? matcher.get_decided_result().match_identifier : 0;
+  }
+  return matcher.get_best_match_count() >= config.minMatchCount ? matcher.get_best_audio_id() : 0;
+}
+
+QueryResult replay(
+  const olaf::Config & config, const olaf::DB & db, const std::vector<std::int16_t> & excerpt,
+  std::uint32_t expected_id)
+{
+  QueryResult result;
+  olaf::FingerprintStream stream(config, db, [](int, float, float, std::uint32_t, float, float) {});
+  const std::size_t block = config.audioStepSize;
+
+  for (std::size_t i = 0; i < excerpt.size(); i += block) {
+    const std::size_t n = std::min(block, excerpt.size() - i);
+    const double start = thread_cpu_us();
+    stream.process(excerpt.data() + i, n);
+    result.cpu_us += thread_cpu_us() - start;
+
+    const std::uint32_t reported = reported_audio_id(config, stream.matcher());
+    if (reported != 0 && reported != expected_id) {
+      result.false_positive = true;
+    }
+    if (reported != 0 && reported == expected_id && !result.identified) {
+      result.identified = true;
+      result.first_correct_s = static_cast<float>(i + n) / config.audioSampleRate;
+    }
+  }
+  result.audio_s = static_cast<float>(excerpt.size()) / config.audioSampleRate;
+  result.db_lookups = stream.matcher().get_db_lookups();
+  result.db_exact_lookups = stream.matcher().get_db_exact_lookups();
+  result.db_exact_misses = stream.matcher().get_db_exact_misses();
+  result.db_hits = stream.matcher().get_db_hits();
+  return result;
+}
+
+float percentile(std::vector<float> values, float fraction)
+{
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  const std::size_t index = static_cast<std::size_t>(fraction * (values.size() - 1) + 0.5f);
+  return values[index];
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  Options options;
+  olaf::Config config;
+  if (!parse(argc, argv, options) || !profile_config(options.profile, config)) {
+    return 1;
+  }
+  if (options.hash_layout != 0) {
+    config.hashLayout = options.hash_layout;
+  }
+  if (options.exact_lookup_votes >= 0) {
+    config.exactLookupVotes = options.exact_lookup_votes;
+  }
+  if (options.max_occurrences >= 0) {
+    config.maxHashOccurrences = static_cast<std::size_t>(options.max_occurrences);
+  }
+
+  std::vector<Audio> references, negatives;
+  if (options.references.empty()) {
+    // a quarter more synthetic songs that are left out of the DB
+    const int negative_count = std::max(1, options.synthetic / 4);
+    for (int i = 0; i < options.synthetic + negative_count; ++i) {
+      const bool reference = i < options.synthetic;
+      Audio audio{
+        "synthetic " + std::to_string(i + 1), reference ? static_cast<std::uint32_t>(i + 1) : 0,
+        host::synthetic_song(static_cast<std::uint32_t>(i + 1), 90, config.audioSampleRate)};
+      (reference ? references : negatives).push_back(std::move(audio));
+    }
+  } else {
+    for (std::size_t i = 0; i < options.references.size(); ++i) {
+      references.emplace_back();
+      const auto audio_id = static_cast<std::uint32_t>(i + 1);
+      if (!load(options.references[i], audio_id, config, references.back())) {
+        return 1;
+      }
+    }
+  }
+  for (const std::string & path : options.negatives) {
+    negatives.emplace_back();
+    if (!load(path, 0, config, negatives.back())) {
+      return 1;
+    }
+  }
+
+  // index the references, with the stop-list of the profile skipped at query time or pruned
+  const double index_start = thread_cpu_us();
+  std::vector<std::vector<std::uint64_t>> fingerprints;
+  olaf::StopListBuilder stop_list_builder;
+  for (const Audio & audio : references) {
+    fingerprints.push_back(host::index_audio(config, audio.samples));
+    stop_list_builder.add_song(fingerprints.back());
+  }
+  const std::vector<std::uint64_t> stop_list = stop_list_builder.build(config);
+  std::vector<std::uint64_t> pruned;
+  olaf::DB db;
+  for (std::size_t i = 0; i < references.size(); ++i) {
+    if (options.prune) {
+      olaf::StopListBuilder::prune(fingerprints[i], stop_list, pruned);
+      fingerprints[i].swap(pruned);
+    }
+    db.register_audio(references[i].audio_id, fingerprints[i].data(), fingerprints[i].size());
+  }
+  if (!options.prune) {
+    db.set_stop_list(stop_list);
+  }
+  const double index_s = (thread_cpu_us() - index_start) / 1e6;
+
+  std::printf(
+    "Profile %s, hash layout %d: %zu references, indexed in %.2f s\n", options.profile.c_str(),
+    config.hashLayout, references.size(), index_s);
+  std::printf(
+    "Index: %zu fingerprints (%zu KiB), %zu stop-list hashes %s\n", db.get_total_fingerprints(),
+    db.get_total_fingerprints() * sizeof(std::uint64_t) / 1024, stop_list.size(),
+    options.prune ? "pruned" : "skipped at query time");
+  std::printf("Degradation: ");
+  if (options.noise) std::printf("noise %.1f dB SNR, ", options.noise_snr);
+  if (options.reverb_rt60 > 0) {
+    std::printf("reverb RT60 %.2f s wet %.2f, ", options.reverb_rt60, options.wet);
+  }
+  std::printf("%.1f s excerpts at random offsets\n", options.duration);
+
+  std::mt19937 generator(options.seed);
+  std::size_t positives = 0, identified = 0, false_positives = 0, negative_hits = 0, queries = 0;
+  std::vector<float> first_correct;
+  double cpu_us = 0, audio_s = 0;
+  std::uint64_t db_lookups = 0, db_exact_lookups = 0, db_exact_misses = 0, db_hits = 0;
+
+  const auto run = [&](const Audio & audio) {
+    const std::size_t length = std::min(
+      audio.samples.size(), static_cast<std::size_t>(options.duration * config.audioSampleRate));
+    std::uniform_int_distribution<std::size_t> offsets(0, audio.samples.size() - length);
+
+    for (int q = 0; q < options.queries; ++q) {
+      const std::size_t offset = offsets(generator);
+      std::vector<std::int16_t> excerpt(
+        audio.samples.begin() + offset, audio.samples.begin() + offset + length);
+      if (options.reverb_rt60 > 0) {
+        host::add_reverb(excerpt, options.reverb_rt60, options.wet, config.audioSampleRate);
+      }
+      if (options.noise) {
+        host::add_noise(excerpt, options.noise_snr, generator());
+      }
+
+      const QueryResult result = replay(config, db, excerpt, audio.audio_id);
+      queries++;
+      cpu_us += result.cpu_us;
+      audio_s += result.audio_s;
+      db_lookups += result.db_lookups;
+      db_exact_lookups += result.db_exact_lookups;
+      db_exact_misses += result.db_exact_misses;
+      db_hits += result.db_hits;
+      if (audio.audio_id != 0) {
+        positives++;
+      }
+      if (result.identified) {
+        identified++;
+        first_correct.push_back(result.first_correct_s);
+      }
+      if (result.false_positive) {
+        false_positives++;
+        if (audio.audio_id == 0) negative_hits++;
+      }
+
+      if (options.verbose) {
+        std::printf(
+          "  %-24s at %7.2f s: %s", audio.name.c_str(),
+          static_cast<float>(offset) / config.audioSampleRate,
+          audio.audio_id == 0 ? "negative" : (result.identified ? "identified" : "missed"));
+        if (result.identified) std::printf(" after %.2f s", result.first_correct_s);
+        if (result.false_positive) std::printf(", false positive");
+        std::printf(", %.0f us/s\n", result.cpu_us / result.audio_s);
+      }
+    }
+  };
+
+  for (const Audio & audio : references) run(audio);
+  for (const Audio & audio : negatives) run(audio);
+
+  std::printf(
+    "Match rate: %zu/%zu (%.1f%%)\n", identified, positives,
+    positives ? 100.0 * identified / positives : 0.0);
+  float mean_first_correct = 0;
+  for (float t : first_correct) {
+    mean_first_correct += t / first_correct.size();
+  }
+  std::printf(
+    "Time to first correct match: median %.2f s, mean %.2f s, p90 %.2f s, max %.2f s\n",
+    percentile(first_correct, 0.5f), mean_first_correct, percentile(first_correct, 0.9f),
+    percentile(first_correct, 1.0f));
+  std::printf(
+    "False positives: %zu/%zu queries (%.1f%%), %zu of %zu negative queries\n", false_positives,
+    queries, queries ? 100.0 * false_positives / queries : 0.0, negative_hits, queries - positives);
+  std::printf(
+    "DB hits: %.2f per lookup, %llu lookups, %.1f%% exact first of which %.1f%% widened\n",
+    db_lookups ? static_cast<double>(db_hits) / db_lookups : 0.0,
+    static_cast<unsigned long long>(db_lookups),
+    db_lookups ? 100.0 * db_exact_lookups / db_lookups : 0.0,
+    db_exact_lookups ? 100.0 * db_exact_misses / db_exact_lookups : 0.0);
+  std::printf(
+    "CPU: %.0f us per second of audio (%.3f%% of a core)\n", cpu_us / audio_s,
+    cpu_us / audio_s / 1e4);
+  return 0;
+}
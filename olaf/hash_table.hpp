@@ -11,7 +11,7 @@
 
 #include <array>
 #include <functional>
-#include <memory>
+#include <memory_resource>
 #include <optional>
 #include <utility>
 #include <vector>
@@ -22,6 +22,9 @@ namespace olaf
 /**
  * @class HashTable
  * @brief A modern C++17 hash table implementation
+ *
+ * Buckets and entries are allocated from the memory resource passed to the
+ * constructor. Growing the table relinks the existing entries.
  */
 template <typename Key, typename Value>
 class HashTable
@@ -35,7 +38,7 @@ private:
   struct Entry
   {
     KeyValuePair pair;
-    std::unique_ptr<Entry> next;
+    Entry * next;
 
     Entry(const Key & k, const Value & v) : pair(k, v), next(nullptr) {}
     Entry(Key && k, Value && v) : pair(std::move(k), std::move(v)), next(nullptr) {}
@@ -46,7 +49,8 @@ private:
     49157,    98317,    196613,   393241,    786433,    1572869,   3145739,   6291469,
     12582917, 25165843, 50331653, 100663319, 201326611, 402653189, 805306457, 1610612741};
 
-  std::vector<std::unique_ptr<Entry>> table_;
+  std::pmr::polymorphic_allocator<Entry> allocator_;
+  std::pmr::vector<Entry *> table_;
   unsigned int table_size_;
   HashFunc hash_func_;
   EqualFunc equal_func_;
@@ -65,30 +69,39 @@ private:
 
   void enlarge()
   {
-    auto old_table = std::move(table_);
+    std::pmr::vector<Entry *> old_table = std::move(table_);
     const unsigned int old_table_size = table_size_;
 
     ++prime_index_;
     allocate_table();
 
     for (unsigned int i = 0; i < old_table_size; ++i) {
-      Entry * rover = old_table[i].get();
+      Entry * rover = old_table[i];
 
       while (rover != nullptr) {
-        Entry * next = rover->next.get();
+        Entry * next = rover->next;
         const unsigned int index = hash_func_(rover->pair.first) % table_size_;
 
-        // Move the entry to the new table
-        auto moved_entry =
-          std::make_unique<Entry>(std::move(rover->pair.first), std::move(rover->pair.second));
-        moved_entry->next = std::move(table_[index]);
-        table_[index] = std::move(moved_entry);
+        // Link the entry into the new table
+        rover->next = table_[index];
+        table_[index] = rover;
 
         rover = next;
       }
     }
   }
 
+  void destroy_entries()
+  {
+    for (Entry * rover : table_) {
+      while (rover != nullptr) {
+        Entry * next = rover->next;
+        allocator_.delete_object(rover);
+        rover = next;
+      }
+    }
+  }
+
 public:
   class Iterator
   {
@@ -100,7 +113,7 @@ public:
     void find_next()
     {
       if (current_entry_ && current_entry_->next) {
-        current_entry_ = current_entry_->next.get();
+        current_entry_ = current_entry_->next;
         return;
       }
 
@@ -109,7 +122,7 @@ public:
 
       while (chain_index_ < table_->table_size_) {
         if (table_->table_[chain_index_]) {
-          current_entry_ = table_->table_[chain_index_].get();
+          current_entry_ = table_->table_[chain_index_];
           break;
         }
         ++chain_index_;
@@ -146,8 +159,12 @@ public:
     bool operator!=(const Iterator & other) const { return current_entry_ != other.current_entry_; }
   };
 
-  HashTable(HashFunc hash_func, EqualFunc equal_func)
-  : table_size_(0),
+  HashTable(
+    HashFunc hash_func, EqualFunc equal_func,
+    std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+  : allocator_(resource),
+    table_(resource),
+    table_size_(0),
     hash_func_(std::move(hash_func)),
     equal_func_(std::move(equal_func)),
     entries_(0),
@@ -156,15 +173,15 @@ public:
     allocate_table();
   }
 
-  ~HashTable() = default;
+  ~HashTable() { destroy_entries(); }
 
   // Delete copy operations
   HashTable(const HashTable &) = delete;
   HashTable & operator=(const HashTable &) = delete;
 
-  // Allow move operations
+  // Allow move construction, the memory resource can not be reassigned
   HashTable(HashTable &&) noexcept = default;
-  HashTable & operator=(HashTable &&) noexcept = default;
+  HashTable & operator=(HashTable &&) = delete;
 
   bool insert(const Key & key, const Value & value)
   {
@@ -173,19 +190,19 @@ public:
     }
 
     const unsigned int index = hash_func_(key) % table_size_;
-    Entry * rover = table_[index].get();
+    Entry * rover = table_[index];
 
     while (rover != nullptr) {
       if (equal_func_(rover->pair.first, key)) {
         rover->pair.second = value;
         return true;
       }
-      rover = rover->next.get();
+      rover = rover->next;
     }
 
-    auto new_entry = std::make_unique<Entry>(key, value);
-    new_entry->next = std::move(table_[index]);
-    table_[index] = std::move(new_entry);
+    Entry * new_entry = allocator_.new_object<Entry>(key, value);
+    new_entry->next = table_[index];
+    table_[index] = new_entry;
 
     ++entries_;
     return true;
@@ -198,19 +215,19 @@ public:
     }
 
     const unsigned int index = hash_func_(key) % table_size_;
-    Entry * rover = table_[index].get();
+    Entry * rover = table_[index];
 
     while (rover != nullptr) {
       if (equal_func_(rover->pair.first, key)) {
         rover->pair.second = std::move(value);
         return true;
       }
-      rover = rover->next.get();
+      rover = rover->next;
     }
 
-    auto new_entry = std::make_unique<Entry>(std::move(key), std::move(value));
-    new_entry->next = std::move(table_[index]);
-    table_[index] = std::move(new_entry);
+    Entry * new_entry = allocator_.new_object<Entry>(std::move(key), std::move(value));
+    new_entry->next = table_[index];
+    table_[index] = new_entry;
 
     ++entries_;
     return true;
@@ -219,13 +236,13 @@ public:
   std::optional<Value> lookup(const Key & key) const
   {
     const unsigned int index = hash_func_(key) % table_size_;
-    Entry * rover = table_[index].get();
+    Entry * rover = table_[index];
 
     while (rover != nullptr) {
       if (equal_func_(key, rover->pair.first)) {
         return rover->pair.second;
       }
-      rover = rover->next.get();
+      rover = rover->next;
     }
 
     return std::nullopt;
@@ -240,19 +257,23 @@ public:
     }
 
     if (equal_func_(key, table_[index]->pair.first)) {
-      table_[index] = std::move(table_[index]->next);
+      Entry * removed = table_[index];
+      table_[index] = removed->next;
+      allocator_.delete_object(removed);
       --entries_;
       return true;
     }
 
-    Entry * rover = table_[index].get();
+    Entry * rover = table_[index];
     while (rover->next) {
       if (equal_func_(key, rover->next->pair.first)) {
-        rover->next = std::move(rover->next->next);
+        Entry * removed = rover->next;
+        rover->next = removed->next;
+        allocator_.delete_object(removed);
         --entries_;
         return true;
       }
-      rover = rover->next.get();
+      rover = rover->next;
     }
 
     return false;
@@ -264,7 +285,7 @@ public:
   {
     for (unsigned int i = 0; i < table_size_; ++i) {
       if (table_[i]) {
-        return Iterator(this, i, table_[i].get());
+        return Iterator(this, i, table_[i]);
       }
     }
     return end();
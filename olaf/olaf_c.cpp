@@ -0,0 +1,201 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file olaf_c.cpp
+ * @brief The C interface of olaf_c.h over olaf::SpectrumStream
+ *
+ * Compiled with -fno-exceptions -fno-rtti for the firmware: nothing here
+ * throws or needs type information, and the callback is a captureless lambda
+ * that std::function stores without allocating.
+ */
+
+#include "olaf_c.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+#include "olaf_memory.hpp"
+#include "olaf_spectrum_stream.hpp"
+
+struct olaf_stream
+{
+  olaf::Arena arena;
+  olaf::Config config;
+  olaf::DB db;
+  olaf::SpectrumStream stream;
+  // bytes of the caller's buffer before the arena
+  std::size_t header_bytes;
+  // samples up to the end of the last pushed block, since create or reset
+  std::uint64_t samples = 0;
+
+  olaf_stream(const olaf::Config & profile, void * buffer, std::size_t size, std::size_t header)
+  : arena(buffer, size),
+    config(profile),
+    db(&arena),
+    stream(config, db, [](int, float, float, std::uint32_t, float, float) {}, 0, &arena),
+    header_bytes(header)
+  {
+  }
+};
+
+namespace
+{
+
+bool profile_config(olaf_config_profile profile, olaf::Config & config)
+{
+  switch (profile) {
+    case OLAF_CONFIG_DEFAULT:
+      config = olaf::Config::create_default();
+      break;
+    case OLAF_CONFIG_ESP32:
+      config = olaf::Config::create_esp_32();
+      break;
+    case OLAF_CONFIG_MEM:
+      config = olaf::Config::create_mem();
+      break;
+    case OLAF_CONFIG_MEM_TRACKING:
+      config = olaf::Config::create_mem_tracking();
+      break;
+    default:
+      return false;
+  }
+  config.printResultEvery = 0;
+  config.verbose = false;
+  return true;
+}
+
+}  // namespace
+
+extern "C" {
+
+olaf_stream * olaf_stream_create(
+  olaf_config_profile profile, const olaf_reference * references, size_t reference_count,
+  void * buffer, size_t buffer_size)
+{
+  olaf::Config config;
+  if (!profile_config(profile, config)) {
+    return nullptr;
+  }
+  void * start = buffer;
+  std::size_t space = buffer_size;
+  if (std::align(alignof(olaf_stream), sizeof(olaf_stream), start, space) == nullptr) {
+    return nullptr;
+  }
+  std::byte * arena_start = static_cast<std::byte *>(start) + sizeof(olaf_stream);
+  const auto header = static_cast<std::size_t>(arena_start - static_cast<std::byte *>(buffer));
+
+  auto * stream = new (start) olaf_stream(config, arena_start, buffer_size - header, header);
+  for (std::size_t i = 0; i < reference_count; ++i) {
+    stream->db.register_audio(
+      references[i].audio_id, references[i].fingerprints, references[i].fingerprint_count);
+  }
+  return stream;
+}
+
+void olaf_stream_push_spectrum(olaf_stream * stream, const float * spectrum)
+{
+#if defined(OLAF_HEAP_GUARD)
+  olaf::HeapGuard guard;
+#endif
+  stream->stream.process(spectrum);
+  // the first block brings a whole block of audio, every later one a step
+  stream->samples += stream->samples == 0 ? stream->config.audioBlockSize
+                                          : stream->config.audioStepSize;
+}
+
+void olaf_stream_poll(const olaf_stream * stream, olaf_match_state * state)
+{
+  const olaf::Config & config = stream->config;
+  const olaf::FPMatcher & matcher = stream->stream.matcher();
+  const double query_time =
+    static_cast<double>(stream->samples) / static_cast<double>(config.audioSampleRate);
+  const double seconds_per_block =
+    static_cast<double>(config.audioStepSize) / static_cast<double>(config.audioSampleRate);
+
+  // the decided match once there is one, otherwise the best offset so far
+  const olaf::MatchResult * best =
+    matcher.is_decided() ? &matcher.get_decided_result() : matcher.get_best_result();
+
+  *state = olaf_match_state{};
+  state->decided = matcher.is_decided();
+  state->matched = config.minMatchConfidence > 0
+                     ? state->decided
+                     : matcher.get_best_match_count() >= config.minMatchCount;
+  state->query_time = static_cast<float>(query_time);
+  state->confidence = matcher.get_confidence();
+  if (best != nullptr) {
+    state->audio_id = best->match_identifier;
+    state->match_count = best->match_count;
+    // fingerprint times are block starts, the offset maps the last sample of the last block
+    const int offset = best->query_fingerprint_t1 - best->reference_fingerprint_t1;
+    state->reference_time = static_cast<float>(query_time - offset * seconds_per_block);
+  }
+}
+
+void olaf_stream_set_load_control(olaf_stream * stream, uint32_t (*clock_us)(), float budget_us)
+{
+  stream->stream.set_load_control(clock_us, budget_us);
+}
+
+void olaf_stream_poll_load(const olaf_stream * stream, olaf_load_state * state)
+{
+  const olaf::LoadTelemetry & telemetry = stream->stream.get_load_telemetry();
+  state->level = telemetry.level;
+  state->min_event_point_magnitude = telemetry.min_event_point_magnitude;
+  state->max_event_points = telemetry.max_event_points;
+  state->max_fingerprints = telemetry.max_fingerprints;
+  state->budget_us = telemetry.budget_us;
+  state->average_us = telemetry.average_us;
+  state->worst_us = telemetry.worst_us;
+  state->blocks = telemetry.blocks;
+  state->over_budget = telemetry.over_budget;
+}
+
+void olaf_stream_reset(olaf_stream * stream)
+{
+  stream->stream.reset();
+  stream->samples = 0;
+}
+
+size_t olaf_stream_memory_used(const olaf_stream * stream)
+{
+  return stream->header_bytes + stream->arena.used();
+}
+
+int olaf_config_sample_rate(olaf_config_profile profile)
+{
+  olaf::Config config;
+  return profile_config(profile, config) ? config.audioSampleRate : 0;
+}
+
+int olaf_config_step_size(olaf_config_profile profile)
+{
+  olaf::Config config;
+  return profile_config(profile, config) ? config.audioStepSize : 0;
+}
+
+int olaf_config_block_size(olaf_config_profile profile)
+{
+  olaf::Config config;
+  return profile_config(profile, config) ? config.audioBlockSize : 0;
+}
+
+}  // extern "C"
@@ -0,0 +1,146 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_C_H
+#define OLAF_C_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file olaf_c.h
+ * @brief C interface to fingerprint and match one audio stream.
+ *
+ * For the C firmware: a stream is built in a caller owned buffer, so after
+ * olaf_stream_create() nothing is allocated from the heap. The caller windows
+ * and transforms the audio, as the firmware's audio pipeline already does:
+ * feed every spectrum with olaf_stream_push_spectrum() and read the match with
+ * olaf_stream_poll() from the same thread. The implementation, olaf_c.cpp, is
+ * built without exceptions and RTTI.
+ *
+ * The buffer holds the stream, the audio references and the match
+ * candidates. As with an olaf::Arena, running out of it aborts: size it with
+ * olaf_stream_memory_used() after a representative run, plus some headroom.
+ * There is nothing to destroy: the stream is gone with the buffer.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Config profiles, olaf::Config::create_default(), create_esp_32(), create_mem() and
+ * create_mem_tracking()
+ */
+enum olaf_config_profile {
+  OLAF_CONFIG_DEFAULT,
+  OLAF_CONFIG_ESP32,
+  OLAF_CONFIG_MEM,
+  OLAF_CONFIG_MEM_TRACKING,
+};
+
+/** The sorted, packed fingerprints of one reference, e.g. olaf_db_mem_fps in flash */
+struct olaf_reference {
+  uint32_t audio_id;
+  const uint64_t * fingerprints;
+  size_t fingerprint_count;
+};
+
+/** What the stream matched so far */
+struct olaf_match_state {
+  bool matched;           /* enough votes to report the match, as replay does */
+  bool decided;           /* the matcher locked on to the reference */
+  uint32_t audio_id;      /* best reference, 0 without votes */
+  int match_count;        /* votes of its best time offset */
+  float confidence;       /* votes the best reference leads by */
+  float query_time;       /* seconds of audio in the spectra pushed since create or reset */
+  float reference_time;   /* position of the last block's last sample in the reference, in s */
+};
+
+/** How the stream keeps to its time budget, see olaf_stream_set_load_control() */
+struct olaf_load_state {
+  int level;                       /* 0: the profile's limits, every level extracts less */
+  float min_event_point_magnitude; /* weaker spectral peaks are no event points */
+  int max_event_points;            /* event points per block */
+  size_t max_fingerprints;         /* fingerprints per block */
+  float budget_us;                 /* processing time available per block */
+  float average_us;                /* running average of the block time */
+  float worst_us;                  /* slowest block */
+  uint32_t blocks;                 /* blocks timed */
+  uint32_t over_budget;            /* blocks that took longer than the budget */
+};
+
+struct olaf_stream;
+
+/**
+ * @brief Build a stream matching against the references in buffer
+ * @param references Must outlive the stream, they are not copied
+ * @return The stream, at the start of buffer, or NULL for an unknown profile
+ *         or a buffer too small for the stream itself
+ */
+struct olaf_stream * olaf_stream_create(
+  enum olaf_config_profile profile, const struct olaf_reference * references,
+  size_t reference_count, void * buffer, size_t buffer_size);
+
+/**
+ * @brief Fingerprint and match the spectrum of the next block
+ *
+ * One spectrum per step of the profile, see olaf_config_step_size(), each of
+ * olaf_config_block_size() samples at the profile's sample rate, PCM scaled
+ * to [-1, 1) and multiplied by olaf's Hamming window (olaf_window.h).
+ * @param spectrum olaf_config_block_size() floats in the layout of arm_rfft_fast_f32:
+ *        DC and Nyquist first, then re/im of every bin
+ */
+void olaf_stream_push_spectrum(struct olaf_stream * stream, const float * spectrum);
+
+/** @brief The current match, cheap enough to call after every push */
+void olaf_stream_poll(const struct olaf_stream * stream, struct olaf_match_state * state);
+
+/**
+ * @brief Time every block and extract less while blocks take too long
+ * @param clock_us Free running microsecond clock that may wrap, NULL stops load control
+ * @param budget_us Processing time available per block, 0 for the step period. Only
+ *        olaf_stream_push_spectrum() is timed, the caller's window and FFT are not
+ *
+ * Starts from the profile's limits, and returns to them when load control stops.
+ */
+void olaf_stream_set_load_control(
+  struct olaf_stream * stream, uint32_t (*clock_us)(void), float budget_us);
+
+/** @brief The load level, the limits it sets and the block times they are based on */
+void olaf_stream_poll_load(const struct olaf_stream * stream, struct olaf_load_state * state);
+
+/** @brief Forget the audio and the match, e.g. when playback restarts */
+void olaf_stream_reset(struct olaf_stream * stream);
+
+/** @brief Bytes of the buffer in use */
+size_t olaf_stream_memory_used(const struct olaf_stream * stream);
+
+/** @brief Sample rate of a profile, 0 for an unknown profile */
+int olaf_config_sample_rate(enum olaf_config_profile profile);
+
+/** @brief Samples between processed blocks of a profile, 0 for an unknown profile */
+int olaf_config_step_size(enum olaf_config_profile profile);
+
+/** @brief Samples per block, the FFT size, of a profile, 0 for an unknown profile */
+int olaf_config_block_size(enum olaf_config_profile profile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // OLAF_C_H
@@ -64,6 +64,10 @@ struct Config
   int minFreqDistance;
   int maxFreqDistance;
   std::size_t maxFingerprints;
+  // layout of the fingerprint hash, see olaf_fp_hash.hpp: 1 the original 34 bit
+  // hash, 2 the 42 bit hash with finer frequency deltas and the position of t2.
+  // A database only matches queries hashed with the layout it was indexed with
+  int hashLayout;
 
   //------------ Matcher configuration
   std::size_t maxResults;
@@ -72,7 +76,23 @@ struct Config
   float minMatchTimeDiff;
   float keepMatchesFor;
   float printResultEvery;
+  // declare a match as soon as the vote margin over the runner-up song,
+  // weighted by time offset consistency, reaches this value. 0 disables
+  float minMatchConfidence;
   std::size_t maxDBCollisions;
+  // once a time offset has this many votes, look up the exact hash first and
+  // the full searchRange only when that misses. 0 always searches the full range
+  int exactLookupVotes;
+  // once locked on a match, only look this many seconds around the predicted
+  // reference time, 0 disables tracking
+  float trackingWindow;
+  // fall back to full search after this many seconds without a verified hit
+  float trackingTimeout;
+
+  //------------ Index configuration
+  // hashes occurring more often than this in the whole catalog are put on
+  // the stop-list, 0 disables the stop-list
+  std::size_t maxHashOccurrences;
 
   /**
      * The default configuration to use on traditional computers.
@@ -113,6 +133,7 @@ struct Config
     config.maxFreqDistance = 128;
 
     config.maxFingerprints = 300;
+    config.hashLayout = 1;
 
     // maximum number of results
     config.maxResults = 50;
@@ -121,7 +142,13 @@ struct Config
     config.minMatchTimeDiff = 0;
     config.keepMatchesFor = 0;
     config.printResultEvery = 0;
+    config.minMatchConfidence = 0;
     config.maxDBCollisions = 2000;
+    config.exactLookupVotes = 0;
+    config.trackingWindow = 0;
+    config.trackingTimeout = 3;
+
+    config.maxHashOccurrences = 0;
 
     return config;
   }
@@ -166,6 +193,22 @@ struct Config
 
     return config;
   }
+
+  /**
+     * The in memory configuration that decides early and then tracks the match:
+     * a song is reported once it leads the runner-up by minMatchConfidence votes,
+     * and the lookups stay around the matched position afterwards. For live
+     * matching on a microcontroller, where a match has to come fast and cheap.
+     */
+  static Config create_mem_tracking()
+  {
+    Config config = create_mem();
+
+    config.minMatchConfidence = 4;
+    config.trackingWindow = 0.5f;
+
+    return config;
+  }
 };
 
 }  // namespace olaf
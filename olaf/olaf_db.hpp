@@ -21,6 +21,7 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <memory_resource>
 #include <span>
 #include <vector>
 
@@ -48,7 +49,52 @@ class DB
 {
 private:
   // List of audio references (no heap allocation for fingerprint data)
-  std::vector<AudioReference> audio_refs_;
+  std::pmr::vector<AudioReference> audio_refs_;
+
+  // Sorted hashes that are too common to be informative (not owned)
+  std::span<const std::uint64_t> stop_list_;
+
+  // Setlist scope: when scoped_, queries only visit audio_refs_[active_indices_[i]]
+  bool scoped_ = false;
+  std::pmr::vector<std::uint32_t> active_ids_;
+  std::pmr::vector<std::size_t> active_indices_;
+
+  void update_active_indices()
+  {
+    active_indices_.clear();
+    if (!scoped_) return;
+    for (std::size_t i = 0; i < audio_refs_.size(); ++i) {
+      if (
+        std::find(active_ids_.begin(), active_ids_.end(), audio_refs_[i].audio_id) !=
+        active_ids_.end()) {
+        active_indices_.push_back(i);
+      }
+    }
+  }
+
+  std::size_t searched_ref_count() const
+  {
+    return scoped_ ? active_indices_.size() : audio_refs_.size();
+  }
+
+  const AudioReference & searched_ref(std::size_t i) const
+  {
+    return audio_refs_[scoped_ ? active_indices_[i] : i];
+  }
+
+  /**
+     * @brief Bit i is set when start_key + i is on the stop-list
+     * Ranges wider than 64 keys are checked per key with is_stopped.
+     */
+  std::uint64_t stopped_mask(std::uint64_t start_key, std::uint64_t stop_key) const
+  {
+    std::uint64_t mask = 0;
+    auto it = std::lower_bound(stop_list_.begin(), stop_list_.end(), start_key);
+    for (; it != stop_list_.end() && *it <= stop_key; ++it) {
+      mask |= static_cast<std::uint64_t>(1) << (*it - start_key);
+    }
+    return mask;
+  }
 
   static void unpack(std::uint64_t packed, std::uint64_t & hash, std::uint32_t & timestamp)
   {
@@ -62,7 +108,13 @@ private:
   }
 
 public:
-  explicit DB() {}
+  /**
+   * @param resource Where the audio references and the setlist scope are allocated
+   */
+  explicit DB(std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+  : audio_refs_(resource), active_ids_(resource), active_indices_(resource)
+  {
+  }
 
   /**
      * @brief Register a static fingerprint array for an audio file
@@ -80,86 +132,175 @@ public:
     ref.fingerprints = std::span<const std::uint64_t>(fingerprints, fp_length);
 
     audio_refs_.push_back(ref);
+    update_active_indices();
 
     std::fprintf(stderr, "Registered audio ID %u (%zu fingerprints)\n", audio_id, fp_length);
   }
 
   /**
-     * @brief Find fingerprints across all registered audio files
+     * @brief Set the hashes to ignore at query time
+     *
+     * Fingerprints with these hashes are skipped by find(), whether or not they were
+     * pruned from the registered arrays at index time.
+     * @param sorted_hashes Sorted array of hashes, must outlive the database
+     */
+  void set_stop_list(std::span<const std::uint64_t> sorted_hashes) { stop_list_ = sorted_hashes; }
+
+  std::size_t get_stop_list_size() const { return stop_list_.size(); }
+
+  /**
+     * @brief Check whether a hash is on the stop-list
+     */
+  bool is_stopped(std::uint64_t hash) const
+  {
+    return !stop_list_.empty() && std::binary_search(stop_list_.begin(), stop_list_.end(), hash);
+  }
+
+  /**
+     * @brief Restrict queries to a subset of the registered audio files
+     *
+     * Typically the current song of a setlist and the next few. Swapping the set only
+     * rebuilds a small index list, no fingerprint data is touched. Ids that are not
+     * registered (yet) are remembered and become active once registered.
+     * @param audio_ids Audio IDs to search, an empty span scopes the search to nothing
+     */
+  void set_active_audio(std::span<const std::uint32_t> audio_ids)
+  {
+    scoped_ = true;
+    active_ids_.assign(audio_ids.begin(), audio_ids.end());
+    update_active_indices();
+  }
+
+  /**
+     * @brief Search all registered audio files again
+     */
+  void clear_active_audio()
+  {
+    scoped_ = false;
+    active_ids_.clear();
+    active_indices_.clear();
+  }
+
+  bool is_scoped() const { return scoped_; }
+
+  std::size_t get_active_audio_count() const { return searched_ref_count(); }
+
+  /**
+   * @brief The i-th audio file find() searches, i < get_active_audio_count()
+   */
+  const AudioReference & get_active_audio(std::size_t i) const { return searched_ref(i); }
+
+  /**
+     * @brief Find fingerprints across all active audio files
      * @param start_key Start hash (inclusive)
      * @param stop_key Stop hash (inclusive)
      * @param results Output vector (timestamp << 32 | audio_id)
      * @param max_results Maximum results to find
      * @return Number of results found
      */
+  template <typename Allocator>
   std::size_t find(
-    std::uint64_t start_key, std::uint64_t stop_key, std::vector<std::uint64_t> & results,
-    std::size_t max_results) const
+    std::uint64_t start_key, std::uint64_t stop_key,
+    std::vector<std::uint64_t, Allocator> & results, std::size_t max_results) const
   {
     results.clear();
+    if (start_key > stop_key) return 0;
+
+    const bool use_mask = !stop_list_.empty() && stop_key - start_key < 64;
+    const std::uint64_t stop_mask = use_mask ? stopped_mask(start_key, stop_key) : 0;
+    const auto skip = [&](std::uint64_t hash) {
+      if (stop_list_.empty()) return false;
+      if (use_mask) return ((stop_mask >> (hash - start_key)) & 1) != 0;
+      return is_stopped(hash);
+    };
+
+    // Every key in range is uninformative, skip the search entirely
+    if (
+      use_mask && stop_mask == (~static_cast<std::uint64_t>(0) >> (63 - (stop_key - start_key)))) {
+      return 0;
+    }
 
-    // Search through each audio file
-    for (const auto & audio_ref : audio_refs_) {
-      auto match_it = audio_ref.fingerprints.end();
-
-      // Binary search for any key in range within this audio's fingerprints
-      for (std::uint64_t current_key = start_key; current_key <= stop_key; ++current_key) {
-        const std::uint64_t packed_key = pack(current_key, 0);
+    // Search through each active audio file
+    const std::size_t ref_count = searched_ref_count();
+    for (std::size_t r = 0; r < ref_count; ++r) {
+      const AudioReference & audio_ref = searched_ref(r);
+      const auto & fps = audio_ref.fingerprints;
 
-        // Binary search in sorted array
-        auto it = std::lower_bound(
-          audio_ref.fingerprints.begin(), audio_ref.fingerprints.end(), packed_key,
-          [](std::uint64_t a, std::uint64_t b) { return (a >> 16) < (b >> 16); });
+      // Packed fingerprints sort by hash first: one binary search finds the start of the range
+      for (auto it = std::lower_bound(fps.begin(), fps.end(), pack(start_key, 0));
+           it != fps.end(); ++it) {
+        std::uint64_t ref_hash;
+        std::uint32_t ref_t;
+        unpack(*it, ref_hash, ref_t);
+        if (ref_hash > stop_key) break;
 
-        if (it != audio_ref.fingerprints.end() && ((*it) >> 16) == (packed_key >> 16)) {
-          match_it = it;
-          break;
+        if (skip(ref_hash)) {
+          // Low information hash, not worth tallying
+        } else if (results.size() < max_results) {
+          const std::uint64_t t = ref_t;
+          results.push_back((t << 32) | audio_ref.audio_id);
+        } else {
+          std::fprintf(stderr, "Warning: Max results %zu reached\n", max_results);
+          return results.size();
         }
       }
+    }
 
-      if (match_it != audio_ref.fingerprints.end()) {
-        // Find all collisions (same hash range, different timestamps)
-        const std::size_t index = std::distance(audio_ref.fingerprints.begin(), match_it);
-
-        // Search backwards from match
-        for (std::size_t i = index; i < audio_ref.fingerprints.size(); --i) {
-          std::uint64_t ref_hash;
-          std::uint32_t ref_t;
-          unpack(audio_ref.fingerprints[i], ref_hash, ref_t);
-
-          if (ref_hash >= start_key && ref_hash <= stop_key) {
-            if (results.size() < max_results) {
-              const std::uint64_t t = ref_t;
-              results.push_back((t << 32) | audio_ref.audio_id);
-            } else {
-              std::fprintf(stderr, "Warning: Max results %zu reached\n", max_results);
-              return results.size();
-            }
-          } else {
-            break;
-          }
-
-          if (i == 0) break;  // Prevent underflow
-        }
+    return results.size();
+  }
 
-        // Search forwards from match
-        for (std::size_t i = index + 1; i < audio_ref.fingerprints.size(); ++i) {
-          std::uint64_t ref_hash;
-          std::uint32_t ref_t;
-          unpack(audio_ref.fingerprints[i], ref_hash, ref_t);
-
-          if (ref_hash >= start_key && ref_hash <= stop_key) {
-            if (results.size() < max_results) {
-              const std::uint64_t t = ref_t;
-              results.push_back((t << 32) | audio_ref.audio_id);
-            } else {
-              std::fprintf(stderr, "Warning: Max results %zu reached\n", max_results);
-              return results.size();
-            }
-          } else {
-            break;
-          }
-        }
+  /**
+     * @brief Find fingerprints of a single audio file close to an expected reference time
+     *
+     * Used to verify a locked-on match: only the fingerprints of audio_id with a
+     * timestamp in [t_start, t_stop] are visited. As the packed fingerprints are sorted
+     * on (hash, timestamp), every key is a single bounded binary search. Like find(),
+     * nothing is found when audio_id is outside the set_active_audio() scope.
+     * @param audio_id Audio file to search
+     * @param start_key Start hash (inclusive)
+     * @param stop_key Stop hash (inclusive)
+     * @param t_start First reference timestamp (inclusive)
+     * @param t_stop Last reference timestamp (inclusive)
+     * @param results Output vector (timestamp << 32 | audio_id)
+     * @param max_results Maximum results to find
+     * @return Number of results found
+     */
+  template <typename Allocator>
+  std::size_t find_near(
+    std::uint32_t audio_id, std::uint64_t start_key, std::uint64_t stop_key, std::uint32_t t_start,
+    std::uint32_t t_stop, std::vector<std::uint64_t, Allocator> & results,
+    std::size_t max_results) const
+  {
+    results.clear();
+
+    // Timestamps are packed in 16 bits, a window past them has nothing to find
+    t_stop = std::min<std::uint32_t>(t_stop, 0xFFFF);
+    if (t_start > t_stop) return 0;
+
+    const AudioReference * audio_ref = nullptr;
+    const std::size_t ref_count = searched_ref_count();
+    for (std::size_t r = 0; r < ref_count && audio_ref == nullptr; ++r) {
+      if (searched_ref(r).audio_id == audio_id) audio_ref = &searched_ref(r);
+    }
+    if (audio_ref == nullptr) return 0;
+
+    const auto & fps = audio_ref->fingerprints;
+
+    for (std::uint64_t current_key = start_key; current_key <= stop_key; ++current_key) {
+      if (is_stopped(current_key)) continue;
+
+      auto it = std::lower_bound(fps.begin(), fps.end(), pack(current_key, t_start));
+      const std::uint64_t last = pack(current_key, t_stop);
+
+      for (; it != fps.end() && *it <= last; ++it) {
+        if (results.size() >= max_results) return results.size();
+
+        std::uint64_t ref_hash;
+        std::uint32_t ref_t;
+        unpack(*it, ref_hash, ref_t);
+
+        const std::uint64_t t = ref_t;
+        results.push_back((t << 32) | audio_id);
       }
     }
 
@@ -167,11 +308,13 @@ public:
   }
 
   /**
-     * @brief Check if any fingerprint exists in range across all audio files
+     * @brief Check if any fingerprint exists in range across all active audio files
      */
   bool find_single(std::uint64_t start_key, std::uint64_t stop_key) const
   {
-    for (const auto & audio_ref : audio_refs_) {
+    const std::size_t ref_count = searched_ref_count();
+    for (std::size_t r = 0; r < ref_count; ++r) {
+      const AudioReference & audio_ref = searched_ref(r);
       for (const auto & packed : audio_ref.fingerprints) {
         std::uint64_t ref_hash;
         std::uint32_t ref_t;
@@ -196,6 +339,7 @@ public:
         audio_refs_.begin(), audio_refs_.end(),
         [audio_id](const AudioReference & ref) { return ref.audio_id == audio_id; }),
       audio_refs_.end());
+    update_active_indices();
   }
 
   /**
@@ -211,6 +355,10 @@ public:
     std::printf("Database Statistics:\n");
     std::printf("  Total audio files: %zu\n", audio_refs_.size());
     std::printf("  Total fingerprints: %zu\n", total_fingerprints);
+    std::printf("  Stop-list hashes: %zu\n", stop_list_.size());
+    if (scoped_) {
+      std::printf("  Active audio files: %zu\n", active_indices_.size());
+    }
 
     if (verbose) {
       std::printf("\nRegistered audio files:\n");
@@ -250,7 +398,21 @@ public:
     return total;
   }
 
-  void clear() { audio_refs_.clear(); }
+  /**
+     * @brief Remove all registered audio files, the stop-list and setlist scope stay
+     */
+  void clear_audio()
+  {
+    audio_refs_.clear();
+    update_active_indices();
+  }
+
+  void clear()
+  {
+    audio_refs_.clear();
+    stop_list_ = {};
+    clear_active_audio();
+  }
 };
 
 }  // namespace olaf
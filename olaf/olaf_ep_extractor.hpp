@@ -20,11 +20,17 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory_resource>
+#include <type_traits>
 #include <vector>
 
 #include "olaf_config.hpp"
 #include "olaf_max_filter.hpp"
+#include "olaf_profile.h"
 
 #if defined(__ARM_NEON)
 #include <arm_neon.h>
@@ -57,50 +63,101 @@ struct EventPoint
  */
 struct ExtractedEventPoints
 {
-  std::vector<EventPoint> event_points;
+  std::pmr::vector<EventPoint> event_points;
   int event_point_index = 0;
 };
 
 /**
- * @class EPExtractor
+ * @class BasicEPExtractor
  * @brief Event Point extractor with state information
+ *
+ * Magnitude is the type the spectra are stored and max filtered in: float for
+ * the floating point FFT, an unsigned integer power (re^2 + im^2) for the
+ * Q15/Q31 FFT. Peak picking only compares magnitudes, so the monotonic power
+ * finds the same peaks without a square root per bin; only the threshold is
+ * converted once and the magnitude of an accepted event point is converted back.
  */
-class EPExtractor
+template <typename Magnitude>
+class BasicEPExtractor
 {
 private:
   const Config & config_;
-  std::vector<std::vector<float>> mags_;
-  std::vector<std::vector<float>> maxes_;
+  std::pmr::vector<std::pmr::vector<Magnitude>> mags_;
+  std::pmr::vector<std::pmr::vector<Magnitude>> maxes_;
+  MaxFilterScratch<Magnitude> max_filter_scratch_;
+  // maxima of one frequency bin over filterSizeTime blocks
+  std::pmr::vector<Magnitude> timeslice_;
   int filter_index_ = 0;
   int audio_block_index_ = 0;
   ExtractedEventPoints event_points_;
-
-  static float max_filter_time(const float * array, std::size_t array_size)
+  // fixed-point fraction bits of the FFT output, unused for float
+  int fraction_bits_ = 0;
+  // runtime limits, start at the Config values, see LoadController
+  float min_event_point_magnitude_ = 0;
+  Magnitude min_magnitude_ = {};
+  int max_event_points_ = 0;
+  std::size_t dropped_event_points_ = 0;
+
+  static Magnitude max_filter_time(const Magnitude * array, std::size_t array_size)
   {
 #if defined(__ARM_NEON)
-    assert(array_size % 4 == 0);
-    float32x4_t vec_max = vld1q_f32(array);
-    for (std::size_t j = 4; j < array_size; j += 4) {
-      float32x4_t vec = vld1q_f32(array + j);
-      vec_max = vmaxq_f32(vec_max, vec);
+    if constexpr (std::is_same_v<Magnitude, float>) {
+      assert(array_size % 4 == 0);
+      float32x4_t vec_max = vld1q_f32(array);
+      for (std::size_t j = 4; j < array_size; j += 4) {
+        float32x4_t vec = vld1q_f32(array + j);
+        vec_max = vmaxq_f32(vec_max, vec);
+      }
+      float32x2_t max_val = vpmax_f32(vget_low_f32(vec_max), vget_high_f32(vec_max));
+      max_val = vpmax_f32(max_val, max_val);
+      return vget_lane_f32(max_val, 0);
     }
-    float32x2_t max_val = vpmax_f32(vget_low_f32(vec_max), vget_high_f32(vec_max));
-    max_val = vpmax_f32(max_val, max_val);
-    return vget_lane_f32(max_val, 0);
-#else
-    float max_val = -10000000.0f;
+#endif
+    Magnitude max_val = std::numeric_limits<Magnitude>::lowest();
     for (std::size_t i = 0; i < array_size; ++i) {
       max_val = std::max(max_val, array[i]);
     }
     return max_val;
-#endif
   }
 
   void max_filter_frequency(
-    const std::vector<float> & data, std::vector<float> & max_output, int half_filter_size)
+    const std::pmr::vector<Magnitude> & data, std::pmr::vector<Magnitude> & max_output,
+    int half_filter_size)
   {
     const std::size_t filter_size = half_filter_size * 2 + 1;
-    max_filter(data, filter_size, max_output);
+    max_filter(data, filter_size, max_output, max_filter_scratch_);
+  }
+
+  // magnitude as the float extractor would report it
+  float to_float_magnitude(Magnitude value) const
+  {
+    if constexpr (std::is_floating_point_v<Magnitude>) {
+      return value;
+    } else {
+      float magnitude = std::ldexp(std::sqrt(static_cast<float>(value)), -fraction_bits_);
+      if (config_.sqrtMagnitude) {
+        magnitude = std::sqrt(magnitude);
+      }
+      return magnitude;
+    }
+  }
+
+  // minEventPointMagnitude expressed in stored units
+  Magnitude threshold_to_magnitude() const
+  {
+    if constexpr (std::is_floating_point_v<Magnitude>) {
+      return min_event_point_magnitude_;
+    } else {
+      double magnitude = min_event_point_magnitude_;
+      if (config_.sqrtMagnitude) {
+        magnitude *= magnitude;
+      }
+      const double power = std::ldexp(magnitude * magnitude, 2 * fraction_bits_);
+      if (power >= static_cast<double>(std::numeric_limits<Magnitude>::max())) {
+        return std::numeric_limits<Magnitude>::max();
+      }
+      return static_cast<Magnitude>(std::ceil(power));
+    }
   }
 
   void extract_internal()
@@ -113,31 +170,34 @@ private:
     int event_point_index = event_points_.event_point_index;
 
     for (std::size_t j = min_frequency_bin; j < half_audio_block_size - 1; ++j) {
-      const float current_val = mags_[half_filter_size_time][j];
-      const float max_val = maxes_[half_filter_size_time][j];
+      const Magnitude current_val = mags_[half_filter_size_time][j];
+      const Magnitude max_val = maxes_[half_filter_size_time][j];
 
-      if (current_val < config_.minEventPointMagnitude || current_val != max_val) {
+      if (current_val < min_magnitude_ || current_val != max_val) {
         continue;
       }
 
-      std::vector<float> timeslice(filter_size_time);
       for (std::size_t t = 0; t < filter_size_time; ++t) {
-        timeslice[t] = maxes_[t][j];
+        timeslice_[t] = maxes_[t][j];
       }
 
-      const float max_val_time = max_filter_time(timeslice.data(), config_.filterSizeTime);
+      const Magnitude max_val_time = max_filter_time(timeslice_.data(), config_.filterSizeTime);
 
       if (current_val == max_val_time) {
         const int time_index = audio_block_index_ - half_filter_size_time;
         const int frequency_bin = static_cast<int>(j);
-        const float magnitude = mags_[half_filter_size_time][frequency_bin];
-
-        if (event_point_index == config_.maxEventPoints) {
-          std::fprintf(
-            stderr,
-            "Warning: Eventpoint maximum index %d reached, event points are ignored, "
-            "consider increasing config.maxEventPoints if you see this often.\n",
-            config_.maxEventPoints);
+        const float magnitude = to_float_magnitude(mags_[half_filter_size_time][frequency_bin]);
+
+        if (event_point_index >= max_event_points_) {
+          ++dropped_event_points_;
+          // a lowered limit is expected to be hit
+          if (max_event_points_ == config_.maxEventPoints) {
+            std::fprintf(
+              stderr,
+              "Warning: Eventpoint maximum index %d reached, event points are ignored, "
+              "consider increasing config.maxEventPoints if you see this often.\n",
+              config_.maxEventPoints);
+          }
         } else {
           event_points_.event_points[event_point_index].time_index = time_index;
           event_points_.event_points[event_point_index].frequency_bin = frequency_bin;
@@ -156,8 +216,8 @@ private:
 
   void rotate()
   {
-    std::vector<float> temp_max = std::move(maxes_[0]);
-    std::vector<float> temp_mag = std::move(mags_[0]);
+    std::pmr::vector<Magnitude> temp_max = std::move(maxes_[0]);
+    std::pmr::vector<Magnitude> temp_mag = std::move(mags_[0]);
 
     for (int i = 1; i < config_.filterSizeTime; ++i) {
       maxes_[i - 1] = std::move(maxes_[i]);
@@ -170,25 +230,77 @@ private:
     mags_[config_.filterSizeTime - 1] = std::move(temp_mag);
   }
 
-public:
-  explicit EPExtractor(const Config & config) : config_(config)
+  void process_magnitudes(int audio_block_index)
   {
-    const int half_audio_block_size = config_.audioBlockSize / 2;
+    audio_block_index_ = audio_block_index;
 
-    event_points_.event_points.resize(config_.maxEventPoints);
-    event_points_.event_point_index = 0;
+    OLAF_PROFILE_BEGIN(OLAF_STAGE_MAX_FILTER);
+    max_filter_frequency(
+      mags_.at(filter_index_), maxes_.at(filter_index_), config_.halfFilterSizeFrequency);
+    OLAF_PROFILE_END(OLAF_STAGE_MAX_FILTER);
 
-    for (auto & ep : event_points_.event_points) {
-      ep.time_index = (1 << 23);
+    if (filter_index_ == config_.filterSizeTime - 1) {
+      OLAF_PROFILE_BEGIN(OLAF_STAGE_EXTRACT_EP);
+      extract_internal();
+      OLAF_PROFILE_END(OLAF_STAGE_EXTRACT_EP);
+      rotate();
+    } else {
+      ++filter_index_;
     }
+  }
+
+  template <typename Power, typename Sample>
+  void extract_fixed(const Sample * fft_out, int audio_block_index)
+  {
+    static_assert(std::is_same_v<Magnitude, Power>, "Magnitude type does not fit the FFT output");
+
+    OLAF_PROFILE_BEGIN(OLAF_STAGE_MAGNITUDE);
+    std::pmr::vector<Magnitude> & mags = mags_.at(filter_index_);
+    const int half_audio_block_size = config_.audioBlockSize / 2;
+    for (int j = 0; j < half_audio_block_size; ++j) {
+      const Power re = static_cast<Power>(std::abs(static_cast<std::int64_t>(fft_out[2 * j])));
+      const Power im = static_cast<Power>(std::abs(static_cast<std::int64_t>(fft_out[2 * j + 1])));
+      mags[j] = re * re + im * im;
+    }
+    OLAF_PROFILE_END(OLAF_STAGE_MAGNITUDE);
+
+    process_magnitudes(audio_block_index);
+  }
+
+public:
+  /**
+   * @brief Create an extractor
+   * @param config The configuration
+   * @param fraction_bits For integer magnitudes: the number of fraction bits of the
+   * fixed-point FFT output, see FixedPointRFFT::fraction_bits()
+   * @param resource Where the spectra and event points are allocated
+   */
+  explicit BasicEPExtractor(
+    const Config & config, int fraction_bits = 0,
+    std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+  : config_(config),
+    mags_(resource),
+    maxes_(resource),
+    timeslice_(config.filterSizeTime, resource),
+    event_points_{std::pmr::vector<EventPoint>(config.maxEventPoints, resource), 0},
+    fraction_bits_(fraction_bits)
+  {
+    const std::size_t half_audio_block_size = config_.audioBlockSize / 2;
 
-    mags_.resize(config_.filterSizeTime, std::vector<float>(half_audio_block_size, 0.0f));
-    maxes_.resize(config_.filterSizeTime, std::vector<float>(half_audio_block_size, 0.0f));
+    mags_.reserve(config_.filterSizeTime);
+    maxes_.reserve(config_.filterSizeTime);
+    for (int t = 0; t < config_.filterSizeTime; ++t) {
+      mags_.emplace_back(half_audio_block_size, Magnitude{0});
+      maxes_.emplace_back(half_audio_block_size, Magnitude{0});
+    }
 
+    min_event_point_magnitude_ = config_.minEventPointMagnitude;
+    min_magnitude_ = threshold_to_magnitude();
+    max_event_points_ = config_.maxEventPoints;
     filter_index_ = 0;
   }
 
-  const std::vector<float> & get_mags() const
+  const std::pmr::vector<Magnitude> & get_mags() const
   {
     if (filter_index_ == config_.filterSizeTime - 1) {
       return mags_[config_.filterSizeTime - 2];
@@ -199,8 +311,9 @@ public:
 
   void extract(const float * fft_out, int audio_block_index)
   {
-    audio_block_index_ = audio_block_index;
+    static_assert(std::is_same_v<Magnitude, float>, "Use an EPExtractor for float spectra");
 
+    OLAF_PROFILE_BEGIN(OLAF_STAGE_MAGNITUDE);
     int magnitude_index = 0;
     for (int j = 0; j < config_.audioBlockSize; j += 2) {
       mags_.at(filter_index_).at(magnitude_index) = std::hypot(fft_out[j], fft_out[j + 1]);
@@ -210,21 +323,87 @@ public:
       }
       ++magnitude_index;
     }
+    OLAF_PROFILE_END(OLAF_STAGE_MAGNITUDE);
 
-    max_filter_frequency(
-      mags_.at(filter_index_), maxes_.at(filter_index_), config_.halfFilterSizeFrequency);
+    process_magnitudes(audio_block_index);
+  }
 
-    if (filter_index_ == config_.filterSizeTime - 1) {
-      extract_internal();
-      rotate();
-    } else {
-      ++filter_index_;
+  /**
+   * @brief Extract from a Q15 spectrum, interleaved re/im as written by arm_rfft_q15
+   */
+  void extract(const std::int16_t * fft_out, int audio_block_index)
+  {
+    extract_fixed<std::uint32_t>(fft_out, audio_block_index);
+  }
+
+  /**
+   * @brief Extract from a Q31 spectrum, interleaved re/im as written by arm_rfft_q31
+   */
+  void extract(const std::int32_t * fft_out, int audio_block_index)
+  {
+    extract_fixed<std::uint64_t>(fft_out, audio_block_index);
+  }
+
+  /**
+   * @brief Change the minimum event point magnitude at run time
+   */
+  void set_min_event_point_magnitude(float magnitude)
+  {
+    min_event_point_magnitude_ = magnitude;
+    min_magnitude_ = threshold_to_magnitude();
+  }
+
+  float get_min_event_point_magnitude() const { return min_event_point_magnitude_; }
+
+  /**
+   * @brief Lower the number of event points kept at run time, at most config.maxEventPoints
+   */
+  void set_max_event_points(int max_event_points)
+  {
+    max_event_points_ = std::clamp(max_event_points, 1, config_.maxEventPoints);
+  }
+
+  int get_max_event_points() const { return max_event_points_; }
+
+  /**
+   * @brief Event points ignored because the maximum was reached
+   */
+  std::size_t get_dropped_event_points() const { return dropped_event_points_; }
+
+  /**
+   * @brief Forget the spectra and event points, e.g. after a gap in the audio
+   */
+  void reset()
+  {
+    for (int t = 0; t < config_.filterSizeTime; ++t) {
+      std::fill(mags_[t].begin(), mags_[t].end(), Magnitude{0});
+      std::fill(maxes_[t].begin(), maxes_[t].end(), Magnitude{0});
     }
+    for (auto & ep : event_points_.event_points) {
+      ep = EventPoint{};
+    }
+    event_points_.event_point_index = 0;
+    filter_index_ = 0;
   }
 
   ExtractedEventPoints & event_points() { return event_points_; }
 };
 
+/**
+ * @brief The floating point event point extractor
+ */
+using EPExtractor = BasicEPExtractor<float>;
+
+/**
+ * @brief Event point extractor for spectra of FixedPointRFFT<std::int16_t>
+ */
+using EPExtractorQ15 = BasicEPExtractor<std::uint32_t>;
+
+/**
+ * @brief Event point extractor for spectra of FixedPointRFFT<std::int32_t>
+ */
+using EPExtractorQ31 = BasicEPExtractor<std::uint64_t>;
+
 }  // namespace olaf
 
 #endif  // OLAF_EP_EXTRACTOR_HPP
@@ -0,0 +1,167 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_FINGERPRINT_STREAM_HPP
+#define OLAF_FINGERPRINT_STREAM_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+#include "olaf_fixed_point.hpp"
+#include "olaf_fp_matcher.hpp"
+#include "olaf_load_controller.hpp"
+#include "olaf_profile.h"
+#include "olaf_spectrum_stream.hpp"
+#include "olaf_window.hpp"
+
+namespace olaf
+{
+
+/**
+ * @class FingerprintStream
+ * @brief Complete fingerprinting state of one audio stream: window, FFT, extractors and matcher
+ *
+ * Streams share nothing but the Config and the DB, which are only read, so
+ * different streams can be processed on different threads at the same time.
+ * A single stream must be processed by one thread at a time. The Q31 FFT is
+ * used as it needs no external FFT library and finds the same fingerprints
+ * as the float FFT. With set_load_control() every block is timed, window and
+ * FFT included, and a LoadController adapts the extraction limits to the time
+ * budget. The stages after the FFT are a SpectrumStreamQ31.
+ */
+class FingerprintStream
+{
+private:
+  const Config & config_;
+  std::pmr::vector<std::int16_t> window_;
+  // the last audioBlockSize samples as a ring, the oldest at write_index_
+  std::pmr::vector<std::int16_t> samples_;
+  std::size_t write_index_ = 0;
+  // samples until the next block is processed
+  std::size_t until_block_ = 0;
+  std::pmr::vector<std::int32_t> fft_in_;
+  std::pmr::vector<std::int32_t> fft_out_;
+  FixedPointRFFT<std::int32_t> fft_;
+  SpectrumStreamQ31 spectrum_stream_;
+
+  void process_block()
+  {
+    const std::uint32_t start_us = spectrum_stream_.start_block();
+    OLAF_PROFILE_BEGIN(OLAF_STAGE_BLOCK);
+    OLAF_PROFILE_BEGIN(OLAF_STAGE_WINDOW);
+    // the ring in two parts instead of shifting the samples every step
+    const std::size_t oldest = samples_.size() - write_index_;
+    apply_window(samples_.data() + write_index_, window_.data(), fft_in_.data(), oldest);
+    apply_window(samples_.data(), window_.data() + oldest, fft_in_.data() + oldest, write_index_);
+    OLAF_PROFILE_END(OLAF_STAGE_WINDOW);
+    OLAF_PROFILE_BEGIN(OLAF_STAGE_FFT);
+    fft_.transform(fft_in_.data(), fft_out_.data());
+    OLAF_PROFILE_END(OLAF_STAGE_FFT);
+
+    spectrum_stream_.process(fft_out_.data(), start_us);
+    OLAF_PROFILE_END(OLAF_STAGE_BLOCK);
+  }
+
+public:
+  /**
+   * @param resource Where all state of the stream is allocated, e.g. an Arena
+   */
+  FingerprintStream(
+    const Config & config, const DB & db, MatchResultCallback callback,
+    std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+  : config_(config),
+    window_(config.audioBlockSize, resource),
+    samples_(config.audioBlockSize, resource),
+    fft_in_(config.audioBlockSize, resource),
+    fft_out_(2 * config.audioBlockSize, resource),
+    fft_(config.audioBlockSize, resource),
+    spectrum_stream_(config, db, std::move(callback), fft_.fraction_bits(), resource)
+  {
+    until_block_ = samples_.size();
+    const float * window = fft_window(config.audioBlockSize);
+    for (std::size_t i = 0; i < window_.size(); ++i) {
+      window_[i] = static_cast<std::int16_t>(std::min(32767.0f, window[i] * 32768.0f + 0.5f));
+    }
+  }
+
+  /**
+   * @brief Fingerprint and match the next samples of the stream
+   *
+   * Any number of samples can be passed; a block is processed for every
+   * audioStepSize samples once the first audioBlockSize samples are in.
+   */
+  void process(const std::int16_t * samples, std::size_t count)
+  {
+    const std::size_t block_size = samples_.size();
+
+    while (count > 0) {
+      const std::size_t n = std::min({count, until_block_, block_size - write_index_});
+      std::copy(samples, samples + n, samples_.begin() + write_index_);
+      write_index_ = (write_index_ + n) % block_size;
+      until_block_ -= n;
+      samples += n;
+      count -= n;
+
+      if (until_block_ == 0) {
+        process_block();
+        until_block_ = config_.audioStepSize;
+      }
+    }
+  }
+
+  /**
+   * @brief Adapt the extraction limits to the time the blocks take, see LoadController
+   * @param clock Times every block, nullptr stops load control
+   * @param budget_us Processing time available per block, 0 uses the step period
+   *
+   * Starts from the Config limits, and restores them when load control stops.
+   */
+  void set_load_control(LoadClock clock, float budget_us = 0)
+  {
+    spectrum_stream_.set_load_control(clock, budget_us);
+  }
+
+  /**
+   * @brief Forget the audio and match state, e.g. when the stream restarts
+   *
+   * The load level is kept, it depends on the processor rather than the audio.
+   */
+  void reset()
+  {
+    write_index_ = 0;
+    until_block_ = samples_.size();
+    spectrum_stream_.reset();
+  }
+
+  FPMatcher & matcher() { return spectrum_stream_.matcher(); }
+  const FPMatcher & matcher() const { return spectrum_stream_.matcher(); }
+
+  const LoadTelemetry & get_load_telemetry() const
+  {
+    return spectrum_stream_.get_load_telemetry();
+  }
+
+  int get_audio_block_index() const { return spectrum_stream_.get_audio_block_index(); }
+};
+
+}  // namespace olaf
+
+#endif  // OLAF_FINGERPRINT_STREAM_HPP
@@ -0,0 +1,272 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_FIXED_POINT_HPP
+#define OLAF_FIXED_POINT_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+#include "olaf_window.hpp"
+
+#if defined(OLAF_USE_CMSIS_DSP)
+#include <arm_math.h>
+#endif
+
+namespace olaf
+{
+
+/**
+ * @brief Convert a float window to Q15, the format arm_rfft_q15 expects
+ */
+template <std::size_t N>
+constexpr std::array<std::int16_t, N> to_q15(const std::array<float, N> & window)
+{
+  std::array<std::int16_t, N> q15 = {};
+  for (std::size_t i = 0; i < N; ++i) {
+    const float scaled = window[i] * 32768.0f + 0.5f;
+    q15[i] = scaled >= 32767.0f ? 32767 : static_cast<std::int16_t>(scaled);
+  }
+  return q15;
+}
+
+/**
+ * @brief Q15 Hamming window of N samples, generated at compile time
+ */
+template <std::size_t N>
+inline constexpr std::array<std::int16_t, N> hamming_window_q15 = to_q15(hamming_window<N>);
+
+/**
+ * @brief Apply a Q15 window to 16 bit PCM, writing Q15 FFT input
+ */
+inline void apply_window(
+  const std::int16_t * pcm, const std::int16_t * window, std::int16_t * out, std::size_t n)
+{
+  for (std::size_t i = 0; i < n; ++i) {
+    // a Q15 window never exceeds one, so the rounded product stays in range
+    out[i] = static_cast<std::int16_t>((pcm[i] * window[i] + (1 << 14)) >> 15);
+  }
+}
+
+/**
+ * @brief Apply a Q15 window to 16 bit PCM, writing Q31 FFT input
+ */
+inline void apply_window(
+  const std::int16_t * pcm, const std::int16_t * window, std::int32_t * out, std::size_t n)
+{
+  for (std::size_t i = 0; i < n; ++i) {
+    // Q15 x Q15 is Q30, one more bit makes it Q31
+    out[i] = static_cast<std::int32_t>(pcm[i]) * window[i] * 2;
+  }
+}
+
+/**
+ * @class FixedPointRFFT
+ * @brief Real FFT on Q15 (Sample = int16_t) or Q31 (Sample = int32_t) input
+ *
+ * With OLAF_USE_CMSIS_DSP this is arm_rfft_q15 / arm_rfft_q31. Elsewhere a
+ * portable implementation with the same scaling and output layout is used, so
+ * the fixed-point path can be compared with the float path on a host.
+ *
+ * The FFT scales down while transforming to avoid overflow: the output has
+ * fraction_bits() fraction bits, i.e. a float spectrum value v corresponds to
+ * v * 2^fraction_bits(). The output is interleaved re/im, bin k at 2k and 2k + 1.
+ */
+template <typename Sample>
+class FixedPointRFFT
+{
+  static_assert(
+    std::is_same_v<Sample, std::int16_t> || std::is_same_v<Sample, std::int32_t>,
+    "Only Q15 and Q31 are supported");
+
+private:
+  static constexpr int sample_bits = std::is_same_v<Sample, std::int16_t> ? 15 : 31;
+
+  int size_ = 0;
+  int log2_size_ = 0;
+
+#if defined(OLAF_USE_CMSIS_DSP)
+  std::conditional_t<
+    std::is_same_v<Sample, std::int16_t>, arm_rfft_instance_q15, arm_rfft_instance_q31>
+    instance_ = {};
+#else
+  // cos and -sin of 2 pi k / size, in the sample format
+  std::pmr::vector<Sample> twiddle_re_;
+  std::pmr::vector<Sample> twiddle_im_;
+
+  static Sample saturate(std::int64_t value)
+  {
+    constexpr std::int64_t max = std::numeric_limits<Sample>::max();
+    constexpr std::int64_t min = std::numeric_limits<Sample>::min();
+    return static_cast<Sample>(std::clamp(value, min, max));
+  }
+
+  static std::int64_t mul(std::int64_t a, std::int64_t b) { return (a * b) >> sample_bits; }
+
+  // in place radix-2 complex FFT of size_/2 points, halving after every stage
+  void complex_fft(Sample * data) const
+  {
+    const int points = size_ / 2;
+
+    for (int i = 1, j = 0; i < points; ++i) {
+      int bit = points >> 1;
+      for (; j & bit; bit >>= 1) {
+        j ^= bit;
+      }
+      j ^= bit;
+      if (i < j) {
+        std::swap(data[2 * i], data[2 * j]);
+        std::swap(data[2 * i + 1], data[2 * j + 1]);
+      }
+    }
+
+    for (int length = 2; length <= points; length <<= 1) {
+      const int stride = size_ / length;
+      for (int start = 0; start < points; start += length) {
+        for (int k = 0; k < length / 2; ++k) {
+          const std::int64_t w_re = twiddle_re_[k * stride];
+          const std::int64_t w_im = twiddle_im_[k * stride];
+          Sample * a = data + 2 * (start + k);
+          Sample * b = data + 2 * (start + k + length / 2);
+
+          const std::int64_t t_re = mul(b[0], w_re) - mul(b[1], w_im);
+          const std::int64_t t_im = mul(b[0], w_im) + mul(b[1], w_re);
+
+          const std::int64_t a_re = a[0];
+          const std::int64_t a_im = a[1];
+          a[0] = saturate((a_re + t_re) >> 1);
+          a[1] = saturate((a_im + t_im) >> 1);
+          b[0] = saturate((a_re - t_re) >> 1);
+          b[1] = saturate((a_im - t_im) >> 1);
+        }
+      }
+    }
+  }
+#endif
+
+public:
+  /**
+   * @brief Prepare an FFT of size samples, a power of two from 32 to 4096
+   * @param resource Where the twiddles are allocated, unused with CMSIS-DSP
+   */
+  explicit FixedPointRFFT(
+    int size, std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+  : size_(size)
+#if !defined(OLAF_USE_CMSIS_DSP)
+    ,
+    twiddle_re_(size / 2, resource),
+    twiddle_im_(size / 2, resource)
+#endif
+  {
+    while ((1 << log2_size_) < size_) {
+      ++log2_size_;
+    }
+    assert((1 << log2_size_) == size_);
+
+#if defined(OLAF_USE_CMSIS_DSP)
+    (void)resource;
+    if constexpr (std::is_same_v<Sample, std::int16_t>) {
+      arm_rfft_init_q15(&instance_, size_, 0, 1);
+    } else {
+      arm_rfft_init_q31(&instance_, size_, 0, 1);
+    }
+#else
+    constexpr double two_pi = 2.0 * 3.14159265358979323846;
+    const double one = std::ldexp(1.0, sample_bits);
+    for (int k = 0; k < size_ / 2; ++k) {
+      const double phase = two_pi * k / size_;
+      twiddle_re_[k] = saturate(std::llround(std::cos(phase) * one));
+      twiddle_im_[k] = saturate(std::llround(-std::sin(phase) * one));
+    }
+#endif
+  }
+
+  int size() const { return size_; }
+
+  /**
+   * @brief Fraction bits of the output, 15 - (log2(size) - 1) for Q15 and
+   * 31 - log2(size) for Q31, as documented for arm_rfft_q15 / arm_rfft_q31
+   */
+  int fraction_bits() const
+  {
+    return std::is_same_v<Sample, std::int16_t> ? 15 - (log2_size_ - 1) : 31 - log2_size_;
+  }
+
+  /**
+   * @brief Transform size() samples
+   * @param in Windowed input, used as scratch space: arm_rfft_q15 / arm_rfft_q31
+   * modify their input, and so does the portable version, its contents are undefined
+   * afterwards
+   * @param out Spectrum, must hold 2 * size() values like the CMSIS functions require
+   */
+  void transform(Sample * in, Sample * out)
+  {
+#if defined(OLAF_USE_CMSIS_DSP)
+    if constexpr (std::is_same_v<Sample, std::int16_t>) {
+      arm_rfft_q15(&instance_, in, out);
+    } else {
+      arm_rfft_q31(&instance_, in, out);
+    }
+#else
+    // the real input is an N/2 point complex signal of even and odd samples
+    complex_fft(in);
+
+    // arm_rfft_q31 scales down one bit more than arm_rfft_q15
+    const int extra_shift = std::is_same_v<Sample, std::int16_t> ? 1 : 2;
+    const int points = size_ / 2;
+    const Sample * z = in;
+
+    out[0] = saturate(((std::int64_t)z[0] + z[1]) >> (extra_shift - 1));
+    out[1] = 0;
+    out[size_] = saturate(((std::int64_t)z[0] - z[1]) >> (extra_shift - 1));
+    out[size_ + 1] = 0;
+
+    for (int k = 1; k < points; ++k) {
+      const std::int64_t zk_re = z[2 * k];
+      const std::int64_t zk_im = z[2 * k + 1];
+      const std::int64_t zc_re = z[2 * (points - k)];
+      const std::int64_t zc_im = -static_cast<std::int64_t>(z[2 * (points - k) + 1]);
+
+      // X[k] = (Z[k] + Z*[N/2 - k]) / 2 - j W^k (Z[k] - Z*[N/2 - k]) / 2
+      const std::int64_t even_re = zk_re + zc_re;
+      const std::int64_t even_im = zk_im + zc_im;
+      const std::int64_t odd_re = zk_re - zc_re;
+      const std::int64_t odd_im = zk_im - zc_im;
+
+      const std::int64_t w_re = twiddle_re_[k];
+      const std::int64_t w_im = twiddle_im_[k];
+      const std::int64_t rot_re = mul(odd_re, w_re) - mul(odd_im, w_im);
+      const std::int64_t rot_im = mul(odd_re, w_im) + mul(odd_im, w_re);
+
+      out[2 * k] = saturate((even_re + rot_im) >> extra_shift);
+      out[2 * k + 1] = saturate((even_im - rot_re) >> extra_shift);
+    }
+#endif
+  }
+};
+
+}  // namespace olaf
+
+#endif  // OLAF_FIXED_POINT_HPP
@@ -0,0 +1,376 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_FP_CATALOG_HPP
+#define OLAF_FP_CATALOG_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "olaf_db.hpp"
+#include "olaf_fp_store.hpp"
+#include "olaf_stop_list.hpp"
+
+#if OLAF_FP_STORE_HAS_MMAP
+
+namespace olaf
+{
+
+/**
+ * @class FPCatalog
+ * @brief Updatable fingerprint catalog: a main store, a small delta store and tombstones
+ *
+ * Rewriting the store for every added song costs as much as indexing the whole catalog.
+ * The catalog keeps two stores instead, path and path.delta. The main store is only
+ * written by compaction. The delta store holds the songs added since, and a tombstone
+ * entry for every song of the main store that was removed; add_song() and remove_song()
+ * only rewrite the delta. A song in the delta shadows a song with the same audio ID in
+ * the main store, so replacing a song is adding it again.
+ *
+ * attach() registers the live songs of both stores with a DB, and every later change
+ * is applied to that DB: queries see one catalog. Once needs_compaction(), compact()
+ * writes main and delta into a new main store without the removed songs, and prunes
+ * the added songs with the stop-list of the main store. prepare_compaction() does the
+ * writing and can run on another thread while the DB is queried, as long as the catalog
+ * is not changed meanwhile; install_compaction() then swaps the stores on the thread
+ * that owns the DB. A crash between both steps leaves a delta that was already applied
+ * to the main store, opening the catalog again gives the same songs.
+ *
+ * The stop-list is that of the main store, only a full re-index (index_store) updates it.
+ */
+class FPCatalog
+{
+private:
+  struct MainSong
+  {
+    std::uint32_t audio_id;
+    std::size_t entry;
+  };
+
+  std::string path_;
+  std::string delta_path_;
+  std::string compact_path_;
+  std::unique_ptr<FPStore> main_ = std::make_unique<FPStore>();
+  std::unique_ptr<FPStore> delta_ = std::make_unique<FPStore>();
+  // main store entries sorted by audio id
+  std::vector<MainSong> main_songs_;
+  DB * db_ = nullptr;
+
+  static bool exists(const std::string & path)
+  {
+    std::FILE * file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+    std::fclose(file);
+    return true;
+  }
+
+  void index_main()
+  {
+    main_songs_.clear();
+    for (std::size_t i = 0; i < main_->get_song_count(); ++i) {
+      if (!main_->is_tombstone(i)) main_songs_.push_back({main_->get_entry(i).audio_id, i});
+    }
+    std::stable_sort(
+      main_songs_.begin(), main_songs_.end(),
+      [](const MainSong & a, const MainSong & b) { return a.audio_id < b.audio_id; });
+  }
+
+  const MainSong * find_main(std::uint32_t audio_id) const
+  {
+    auto it = std::lower_bound(
+      main_songs_.begin(), main_songs_.end(), audio_id,
+      [](const MainSong & song, std::uint32_t id) { return song.audio_id < id; });
+    return it != main_songs_.end() && it->audio_id == audio_id ? &*it : nullptr;
+  }
+
+  // index of the delta entry of audio_id, get_delta_entry_count() when there is none
+  std::size_t find_delta(std::uint32_t audio_id) const
+  {
+    const std::size_t count = get_delta_entry_count();
+    for (std::size_t i = 0; i < count; ++i) {
+      if (delta_->get_entry(i).audio_id == audio_id) return i;
+    }
+    return count;
+  }
+
+  bool shadowed(std::uint32_t audio_id) const
+  {
+    return find_delta(audio_id) < get_delta_entry_count();
+  }
+
+  void register_song(const FPStore & store, std::size_t entry)
+  {
+    const auto fps = store.get_fingerprints(entry);
+    db_->register_audio(store.get_entry(entry).audio_id, fps.data(), fps.size());
+  }
+
+  // register the live version of audio_id, if any
+  void register_live(std::uint32_t audio_id)
+  {
+    const std::size_t delta_entry = find_delta(audio_id);
+    if (delta_entry < get_delta_entry_count()) {
+      if (!delta_->is_tombstone(delta_entry)) register_song(*delta_, delta_entry);
+    } else if (const MainSong * song = find_main(audio_id)) {
+      register_song(*main_, song->entry);
+    }
+  }
+
+  void register_all()
+  {
+    db_->clear_audio();
+    for (const MainSong & song : main_songs_) {
+      if (!shadowed(song.audio_id)) register_song(*main_, song.entry);
+    }
+    for (std::size_t i = 0; i < get_delta_entry_count(); ++i) {
+      if (!delta_->is_tombstone(i)) register_song(*delta_, i);
+    }
+    db_->set_stop_list(main_->get_stop_list());
+  }
+
+  /**
+   * @brief Write the delta without the entry of audio_id, plus song or a tombstone
+   * @param song Fingerprints of the new entry, nullptr for a tombstone
+   */
+  bool rewrite_delta(
+    std::uint32_t audio_id, const std::span<const std::uint64_t> * song, std::uint32_t duration_ms)
+  {
+    FPStoreWriter writer;
+    writer.set_hash_layout(main_->get_hash_layout());
+    std::vector<std::uint32_t> changed{audio_id};
+    for (std::size_t i = 0; i < get_delta_entry_count(); ++i) {
+      const FPStoreEntry & entry = delta_->get_entry(i);
+      changed.push_back(entry.audio_id);
+      if (entry.audio_id == audio_id) continue;
+      if (delta_->is_tombstone(i)) {
+        writer.add_tombstone(entry.audio_id);
+      } else {
+        writer.add_song(entry.audio_id, delta_->get_fingerprints(i), entry.duration_ms);
+      }
+    }
+    if (song != nullptr) {
+      if (!writer.add_song(audio_id, *song, duration_ms)) return false;
+    } else if (find_main(audio_id) != nullptr) {
+      writer.add_tombstone(audio_id);
+    }
+
+    // the writer reads the old delta, it is only unmapped once the new one is in place
+    const std::string temporary = delta_path_ + ".tmp";
+    if (!writer.write(temporary.c_str())) return false;
+    auto delta = std::make_unique<FPStore>();
+    if (
+      std::rename(temporary.c_str(), delta_path_.c_str()) != 0 ||
+      !delta->open(delta_path_.c_str())) {
+      std::fprintf(stderr, "Could not replace %s\n", delta_path_.c_str());
+      return false;
+    }
+
+    // every delta song moved to the new mapping
+    if (db_ != nullptr) {
+      for (const std::uint32_t id : changed) db_->delete_audio(id);
+    }
+    delta_ = std::move(delta);
+    if (db_ != nullptr) {
+      std::sort(changed.begin(), changed.end());
+      changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+      for (const std::uint32_t id : changed) register_live(id);
+    }
+    return true;
+  }
+
+public:
+  // compact once the delta holds this part of the fingerprints of the main store
+  static constexpr double default_compaction_ratio = 0.1;
+  // or this many entries, every change rewrites the whole delta
+  static constexpr std::size_t default_max_delta_entries = 64;
+
+  FPCatalog() = default;
+  FPCatalog(const FPCatalog &) = delete;
+  FPCatalog & operator=(const FPCatalog &) = delete;
+
+  /**
+     * @brief Open the catalog at path, an empty one is created when there is none
+     * @param hash_layout Config::hashLayout of a new catalog, an existing one keeps its own
+     * @return true when the stores are valid
+     */
+  bool open(const char * path, int hash_layout = 1)
+  {
+    path_ = path;
+    delta_path_ = path_ + ".delta";
+    compact_path_ = path_ + ".compact.tmp";
+    db_ = nullptr;
+    delta_->close();
+
+    if (!exists(path_)) {
+      FPStoreWriter writer;
+      writer.set_hash_layout(hash_layout);
+      if (!writer.write(path_.c_str())) return false;
+    }
+    if (!main_->open(path_.c_str())) return false;
+    index_main();
+
+    if (exists(delta_path_)) {
+      if (!delta_->open(delta_path_.c_str())) return false;
+      if (delta_->get_hash_layout() != main_->get_hash_layout()) {
+        std::fprintf(
+          stderr, "Hash layout %d of %s does not match %d of the catalog\n",
+          delta_->get_hash_layout(), delta_path_.c_str(), main_->get_hash_layout());
+        delta_->close();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+     * @brief Register the live songs and the stop-list with db, and keep it up to date
+     *
+     * Other audio registered with db is removed. The catalog must outlive the registrations.
+     */
+  void attach(DB & db)
+  {
+    db_ = &db;
+    register_all();
+  }
+
+  /**
+     * @brief Add or replace a song
+     * @param fingerprints Sorted packed fingerprints hashed with get_hash_layout()
+     * @return false if the fingerprints are not sorted or the delta could not be written
+     */
+  bool add_song(
+    std::uint32_t audio_id, std::span<const std::uint64_t> fingerprints,
+    std::uint32_t duration_ms = 0)
+  {
+    return rewrite_delta(audio_id, &fingerprints, duration_ms);
+  }
+
+  /**
+     * @brief Remove a song
+     * @return false if the song is not in the catalog or the delta could not be written
+     */
+  bool remove_song(std::uint32_t audio_id)
+  {
+    if (!contains(audio_id)) {
+      std::fprintf(stderr, "Audio ID %u is not in the catalog\n", audio_id);
+      return false;
+    }
+    return rewrite_delta(audio_id, nullptr, 0);
+  }
+
+  bool contains(std::uint32_t audio_id) const
+  {
+    const std::size_t delta_entry = find_delta(audio_id);
+    if (delta_entry < get_delta_entry_count()) return !delta_->is_tombstone(delta_entry);
+    return find_main(audio_id) != nullptr;
+  }
+
+  bool needs_compaction(
+    double ratio = default_compaction_ratio,
+    std::size_t max_delta_entries = default_max_delta_entries) const
+  {
+    return get_delta_entry_count() > max_delta_entries ||
+           get_delta_fingerprints() > ratio * main_->get_total_fingerprints();
+  }
+
+  /**
+     * @brief Write main and delta to a new main store, without touching the current ones
+     */
+  bool prepare_compaction() const
+  {
+    FPStoreWriter writer;
+    writer.set_hash_layout(main_->get_hash_layout());
+    const auto stop_list = main_->get_stop_list();
+    writer.set_stop_list(stop_list);
+    for (const MainSong & song : main_songs_) {
+      if (shadowed(song.audio_id)) continue;
+      writer.add_song(
+        song.audio_id, main_->get_fingerprints(song.entry),
+        main_->get_entry(song.entry).duration_ms);
+    }
+    std::vector<std::vector<std::uint64_t>> pruned(get_delta_entry_count());
+    for (std::size_t i = 0; i < get_delta_entry_count(); ++i) {
+      if (delta_->is_tombstone(i)) continue;
+      StopListBuilder::prune(delta_->get_fingerprints(i), stop_list, pruned[i]);
+      const FPStoreEntry & entry = delta_->get_entry(i);
+      writer.add_song(entry.audio_id, pruned[i], entry.duration_ms);
+    }
+    return writer.write(compact_path_.c_str());
+  }
+
+  /**
+     * @brief Replace the main store by the one of prepare_compaction() and drop the delta
+     */
+  bool install_compaction()
+  {
+    auto main = std::make_unique<FPStore>();
+    if (std::rename(compact_path_.c_str(), path_.c_str()) != 0 || !main->open(path_.c_str())) {
+      std::fprintf(stderr, "Could not replace %s\n", path_.c_str());
+      return false;
+    }
+    std::remove(delta_path_.c_str());
+
+    // the old stores stay mapped until the DB no longer refers to them
+    auto old_main = std::move(main_);
+    auto old_delta = std::move(delta_);
+    main_ = std::move(main);
+    delta_ = std::make_unique<FPStore>();
+    index_main();
+    if (db_ != nullptr) register_all();
+    return true;
+  }
+
+  bool compact() { return prepare_compaction() && install_compaction(); }
+
+  int get_hash_layout() const { return main_->get_hash_layout(); }
+
+  std::size_t get_song_count() const
+  {
+    std::size_t count = 0;
+    for (const MainSong & song : main_songs_) {
+      if (!shadowed(song.audio_id)) ++count;
+    }
+    for (std::size_t i = 0; i < get_delta_entry_count(); ++i) {
+      if (!delta_->is_tombstone(i)) ++count;
+    }
+    return count;
+  }
+
+  /**
+     * @brief Songs and tombstones in the delta
+     */
+  std::size_t get_delta_entry_count() const
+  {
+    return delta_->is_open() ? delta_->get_song_count() : 0;
+  }
+
+  std::uint64_t get_delta_fingerprints() const
+  {
+    return delta_->is_open() ? delta_->get_total_fingerprints() : 0;
+  }
+};
+
+}  // namespace olaf
+
+#endif  // OLAF_FP_STORE_HAS_MMAP
+
+#endif  // OLAF_FP_CATALOG_HPP
@@ -17,15 +17,18 @@
 #ifndef OLAF_FP_EXTRACTOR_HPP
 #define OLAF_FP_EXTRACTOR_HPP
 
+#include <algorithm>
 #include <cassert>
 #include <cinttypes>
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <memory_resource>
 #include <vector>
 
 #include "olaf_config.hpp"
 #include "olaf_ep_extractor.hpp"
+#include "olaf_profile.h"
 
 namespace olaf
 {
@@ -111,7 +114,7 @@ struct Fingerprint
  */
 struct ExtractedFingerprints
 {
-  std::vector<Fingerprint> fingerprints;
+  std::pmr::vector<Fingerprint> fingerprints;
   std::size_t fingerprint_index = 0;
 };
 
@@ -126,6 +129,9 @@ private:
   ExtractedFingerprints fingerprints_;
   std::size_t total_fp_extracted_ = 0;
   bool warning_given_ = false;
+  // runtime limit, starts at config.maxFingerprints, see LoadController
+  std::size_t max_fingerprints_ = 0;
+  std::size_t dropped_fingerprints_ = 0;
 
   static int compare_event_points(const void * a, const void * b)
   {
@@ -187,8 +193,9 @@ private:
               f_diff >= config_.minFreqDistance && f_diff <= config_.maxFreqDistance) {
               assert(t3 > t2);
 
-              if (fingerprints_.fingerprint_index >= config_.maxFingerprints) {
-                if (!warning_given_) {
+              if (fingerprints_.fingerprint_index >= max_fingerprints_) {
+                ++dropped_fingerprints_;
+                if (!warning_given_ && max_fingerprints_ == config_.maxFingerprints) {
                   std::fprintf(
                     stderr,
                     "Warning: Fingerprint maximum index %zu reached, fingerprints are ignored, "
@@ -262,8 +269,9 @@ private:
           f_diff >= config_.minFreqDistance && f_diff <= config_.maxFreqDistance) {
           assert(t2 > t1);
 
-          if (fingerprints_.fingerprint_index == config_.maxFingerprints) {
-            if (!warning_given_) {
+          if (fingerprints_.fingerprint_index >= max_fingerprints_) {
+            ++dropped_fingerprints_;
+            if (!warning_given_ && max_fingerprints_ == config_.maxFingerprints) {
               std::fprintf(
                 stderr,
                 "Warning: Fingerprint maximum index %zu reached, fingerprints are ignored, "
@@ -301,16 +309,38 @@ private:
   }
 
 public:
-  explicit FPExtractor(const Config & config) : config_(config)
+  explicit FPExtractor(
+    const Config & config, std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+  : config_(config),
+    fingerprints_{std::pmr::vector<Fingerprint>(config.maxFingerprints, resource), 0}
   {
-    fingerprints_.fingerprints.resize(config_.maxFingerprints);
-    fingerprints_.fingerprint_index = 0;
     total_fp_extracted_ = 0;
     warning_given_ = false;
+    max_fingerprints_ = config_.maxFingerprints;
   }
 
   std::size_t get_total() const { return total_fp_extracted_; }
 
+  /**
+   * @brief Lower the number of fingerprints per block at run time, at most config.maxFingerprints
+   */
+  void set_max_fingerprints(std::size_t max_fingerprints)
+  {
+    max_fingerprints_ = std::clamp<std::size_t>(max_fingerprints, 1, config_.maxFingerprints);
+  }
+
+  std::size_t get_max_fingerprints() const { return max_fingerprints_; }
+
+  /**
+   * @brief Fingerprints ignored because the maximum was reached
+   */
+  std::size_t get_dropped_fingerprints() const { return dropped_fingerprints_; }
+
+  /**
+   * @brief Drop unmatched fingerprints, e.g. after a gap in the audio
+   */
+  void reset() { fingerprints_.fingerprint_index = 0; }
+
   void extract(ExtractedEventPoints & event_points, int audio_block_index)
   {
     if (config_.verbose) {
@@ -321,6 +351,12 @@ public:
       }
     }
 
+    // nothing to combine, e.g. right after the event point extractor was reset
+    if (event_points.event_point_index == 0) {
+      return;
+    }
+
+    OLAF_PROFILE_BEGIN(OLAF_STAGE_EXTRACT_FP);
     if (config_.numberOfEPsPerFP == 2) {
       extract_two(event_points, audio_block_index);
     } else if (config_.numberOfEPsPerFP == 3) {
@@ -360,6 +396,7 @@ public:
     }
 
     total_fp_extracted_ += fingerprints_.fingerprint_index;
+    OLAF_PROFILE_END(OLAF_STAGE_EXTRACT_FP);
 
     if (config_.verbose) {
       std::fprintf(
@@ -0,0 +1,484 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_FP_HASH_HPP
+#define OLAF_FP_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory_resource>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "olaf_fp_extractor.hpp"
+
+namespace olaf
+{
+
+/**
+ * @brief Versions of the hash layout, Config::hashLayout
+ *
+ * Both keep t3 - t1 in the lowest bits, so a search range around a hash still
+ * tolerates small timing differences, and fit the 48 bits DB::pack leaves.
+ *
+ * Layout 1, 34 bits, the original olaf hash of Fingerprint::calculate_hash():
+ *   0-5 t3 - t1, 6 f1 > f2, 7 f2 > f3, 8 f3 > f1, 9-11 magnitudes (always 0),
+ *   12 t2 - t1 > t3 - t2, 13 |f2 - f1| > |f3 - f2|, 14-21 f1 / 2,
+ *   22-27 |f2 - f1| / 4, 28-33 |f3 - f2| / 4
+ *
+ * Layout 2, 42 bits, halves the frequency delta steps and adds the position of t2:
+ *   0-21 as layout 1, 22-28 |f2 - f1| / 2, 29-35 |f3 - f2| / 2, 36-41 t2 - t1
+ */
+constexpr int hash_layout_v1 = 1;
+constexpr int hash_layout_v2 = 2;
+
+/**
+ * @brief Positions and widths of the fields that differ between the layouts
+ */
+template <int Layout>
+struct HashFields
+{
+  static_assert(Layout == hash_layout_v1 || Layout == hash_layout_v2, "Unknown hash layout");
+
+  static constexpr int delta_shift = Layout == hash_layout_v1 ? 2 : 1;
+  static constexpr std::uint32_t delta_mask = Layout == hash_layout_v1 ? 0x3F : 0x7F;
+  static constexpr int df3f2_position = Layout == hash_layout_v1 ? 28 : 29;
+  static constexpr bool has_t2 = Layout == hash_layout_v2;
+  static constexpr int t2_position = 36;
+};
+
+/**
+ * @struct FingerprintBatch
+ * @brief Fingerprints as separate arrays (SoA), so their hashes can be calculated several at a time
+ *
+ * The hash only depends on frequency bins and time indexes, magnitude info is
+ * disabled in Fingerprint::calculate_hash(). Every hash function below returns
+ * exactly the value of calculate_hash() for hash_layout_v1, and of
+ * hash_fingerprint<hash_layout_v2>() for the wide layout.
+ */
+struct FingerprintBatch
+{
+  std::pmr::vector<std::int32_t> f1, f2, f3;
+  std::pmr::vector<std::int32_t> t1, t2, t3;
+  std::pmr::vector<std::uint64_t> hashes;
+  std::size_t size = 0;
+
+  explicit FingerprintBatch(
+    std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+  : f1(resource), f2(resource), f3(resource), t1(resource), t2(resource), t3(resource),
+    hashes(resource)
+  {
+  }
+
+  void reserve(std::size_t capacity)
+  {
+    for (auto * array : {&f1, &f2, &f3, &t1, &t2, &t3}) {
+      array->resize(capacity);
+    }
+    hashes.resize(capacity);
+  }
+
+  void clear() { size = 0; }
+
+  void push_back(const Fingerprint & fingerprint)
+  {
+    if (size == hashes.size()) {
+      reserve(size == 0 ? 64 : size * 2);
+    }
+    f1[size] = fingerprint.frequency_bin1;
+    f2[size] = fingerprint.frequency_bin2;
+    f3[size] = fingerprint.frequency_bin3;
+    t1[size] = fingerprint.time_index1;
+    t2[size] = fingerprint.time_index2;
+    t3[size] = fingerprint.time_index3;
+    size++;
+  }
+
+  /**
+   * @brief Replace the batch by the extracted fingerprints
+   */
+  void assign(const ExtractedFingerprints & extracted)
+  {
+    clear();
+    if (hashes.size() < extracted.fingerprint_index) {
+      reserve(extracted.fingerprint_index);
+    }
+    for (std::size_t i = 0; i < extracted.fingerprint_index; ++i) {
+      push_back(extracted.fingerprints[i]);
+    }
+  }
+
+  /**
+   * @brief Fill hashes[0, size) with the widest available SIMD path
+   * @param layout Config::hashLayout, the layout the database was indexed with
+   */
+  void hash(int layout = hash_layout_v1);
+};
+
+/**
+ * @brief Hash of one fingerprint, for layout 1 calculate_hash() without the unused magnitudes
+ */
+template <int Layout = hash_layout_v1>
+inline std::uint64_t hash_fingerprint(
+  std::int32_t f1, std::int32_t f2, std::int32_t f3, std::int32_t t1, std::int32_t t2,
+  std::int32_t t3)
+{
+  using Fields = HashFields<Layout>;
+  const std::uint32_t df2f1 = static_cast<std::uint32_t>(std::abs(f2 - f1));
+  const std::uint32_t df3f2 = static_cast<std::uint32_t>(std::abs(f3 - f2));
+
+  const std::uint32_t low = (static_cast<std::uint32_t>(t3 - t1) & 0x3F) |
+                            (static_cast<std::uint32_t>(f1 > f2) << 6) |
+                            (static_cast<std::uint32_t>(f2 > f3) << 7) |
+                            (static_cast<std::uint32_t>(f3 > f1) << 8) |
+                            (static_cast<std::uint32_t>((t2 - t1) > (t3 - t2)) << 12) |
+                            (static_cast<std::uint32_t>(df2f1 > df3f2) << 13) |
+                            ((static_cast<std::uint32_t>(f1 >> 1) & 0xFF) << 14) |
+                            (((df2f1 >> Fields::delta_shift) & Fields::delta_mask) << 22);
+
+  std::uint64_t hash = low | (static_cast<std::uint64_t>(
+                                (df3f2 >> Fields::delta_shift) & Fields::delta_mask)
+                              << Fields::df3f2_position);
+  if constexpr (Fields::has_t2) {
+    hash |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(t2 - t1) & 0x3F)
+            << Fields::t2_position;
+  }
+  return hash;
+}
+
+/**
+ * @brief Scalar reference over SoA arrays, also used for the tail of the SIMD paths
+ */
+template <int Layout = hash_layout_v1>
+inline void hash_fingerprints_scalar(
+  const std::int32_t * f1, const std::int32_t * f2, const std::int32_t * f3,
+  const std::int32_t * t1, const std::int32_t * t2, const std::int32_t * t3, std::size_t count,
+  std::uint64_t * hashes)
+{
+  for (std::size_t i = 0; i < count; ++i) {
+    hashes[i] = hash_fingerprint<Layout>(f1[i], f2[i], f3[i], t1[i], t2[i], t3[i]);
+  }
+}
+
+// The SIMD paths compute the hash in 32 bit lanes. All fields but the top bits
+// of df3f2 fit in the low word; those bits, and t2 - t1 in layout 2, form the
+// high word, and both words are interleaved into 64 bit hashes on store.
+
+#if defined(__SSE2__)
+/**
+ * @brief 4 hashes at a time with SSE2
+ */
+template <int Layout = hash_layout_v1>
+inline void hash_fingerprints_sse2(
+  const std::int32_t * f1, const std::int32_t * f2, const std::int32_t * f3,
+  const std::int32_t * t1, const std::int32_t * t2, const std::int32_t * t3, std::size_t count,
+  std::uint64_t * hashes)
+{
+  const auto abs_epi32 = [](__m128i x) {
+    const __m128i sign = _mm_srai_epi32(x, 31);
+    return _mm_sub_epi32(_mm_xor_si128(x, sign), sign);
+  };
+  const auto bit = [](__m128i mask, int shift) {
+    return _mm_and_si128(mask, _mm_set1_epi32(1 << shift));
+  };
+  using Fields = HashFields<Layout>;
+  const __m128i mask6 = _mm_set1_epi32(0x3F);
+  const __m128i delta_mask = _mm_set1_epi32(Fields::delta_mask);
+
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128i vf1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(f1 + i));
+    const __m128i vf2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(f2 + i));
+    const __m128i vf3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(f3 + i));
+    const __m128i vt1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t1 + i));
+    const __m128i vt2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t2 + i));
+    const __m128i vt3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t3 + i));
+
+    const __m128i df2f1 = abs_epi32(_mm_sub_epi32(vf2, vf1));
+    const __m128i df3f2 = abs_epi32(_mm_sub_epi32(vf3, vf2));
+    const __m128i df3f2_field =
+      _mm_and_si128(_mm_srli_epi32(df3f2, Fields::delta_shift), delta_mask);
+
+    __m128i low = _mm_and_si128(_mm_sub_epi32(vt3, vt1), mask6);
+    low = _mm_or_si128(low, bit(_mm_cmpgt_epi32(vf1, vf2), 6));
+    low = _mm_or_si128(low, bit(_mm_cmpgt_epi32(vf2, vf3), 7));
+    low = _mm_or_si128(low, bit(_mm_cmpgt_epi32(vf3, vf1), 8));
+    low = _mm_or_si128(
+      low, bit(_mm_cmpgt_epi32(_mm_sub_epi32(vt2, vt1), _mm_sub_epi32(vt3, vt2)), 12));
+    low = _mm_or_si128(low, bit(_mm_cmpgt_epi32(df2f1, df3f2), 13));
+    low = _mm_or_si128(
+      low, _mm_slli_epi32(_mm_and_si128(_mm_srai_epi32(vf1, 1), _mm_set1_epi32(0xFF)), 14));
+    low = _mm_or_si128(
+      low,
+      _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(df2f1, Fields::delta_shift), delta_mask), 22));
+    low = _mm_or_si128(low, _mm_slli_epi32(df3f2_field, Fields::df3f2_position));
+    __m128i high = _mm_srli_epi32(df3f2_field, 32 - Fields::df3f2_position);
+    if constexpr (Fields::has_t2) {
+      high = _mm_or_si128(
+        high,
+        _mm_slli_epi32(_mm_and_si128(_mm_sub_epi32(vt2, vt1), mask6), Fields::t2_position - 32));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(hashes + i), _mm_unpacklo_epi32(low, high));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(hashes + i + 2), _mm_unpackhi_epi32(low, high));
+  }
+  hash_fingerprints_scalar<Layout>(
+    f1 + i, f2 + i, f3 + i, t1 + i, t2 + i, t3 + i, count - i, hashes + i);
+}
+#endif
+
+#if defined(__AVX2__)
+/**
+ * @brief 8 hashes at a time with AVX2
+ */
+template <int Layout = hash_layout_v1>
+inline void hash_fingerprints_avx2(
+  const std::int32_t * f1, const std::int32_t * f2, const std::int32_t * f3,
+  const std::int32_t * t1, const std::int32_t * t2, const std::int32_t * t3, std::size_t count,
+  std::uint64_t * hashes)
+{
+  const auto bit = [](__m256i mask, int shift) {
+    return _mm256_and_si256(mask, _mm256_set1_epi32(1 << shift));
+  };
+  using Fields = HashFields<Layout>;
+  const __m256i mask6 = _mm256_set1_epi32(0x3F);
+  const __m256i delta_mask = _mm256_set1_epi32(Fields::delta_mask);
+
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m256i vf1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(f1 + i));
+    const __m256i vf2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(f2 + i));
+    const __m256i vf3 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(f3 + i));
+    const __m256i vt1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t1 + i));
+    const __m256i vt2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t2 + i));
+    const __m256i vt3 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t3 + i));
+
+    const __m256i df2f1 = _mm256_abs_epi32(_mm256_sub_epi32(vf2, vf1));
+    const __m256i df3f2 = _mm256_abs_epi32(_mm256_sub_epi32(vf3, vf2));
+    const __m256i df3f2_field =
+      _mm256_and_si256(_mm256_srli_epi32(df3f2, Fields::delta_shift), delta_mask);
+
+    __m256i low = _mm256_and_si256(_mm256_sub_epi32(vt3, vt1), mask6);
+    low = _mm256_or_si256(low, bit(_mm256_cmpgt_epi32(vf1, vf2), 6));
+    low = _mm256_or_si256(low, bit(_mm256_cmpgt_epi32(vf2, vf3), 7));
+    low = _mm256_or_si256(low, bit(_mm256_cmpgt_epi32(vf3, vf1), 8));
+    low = _mm256_or_si256(
+      low, bit(_mm256_cmpgt_epi32(_mm256_sub_epi32(vt2, vt1), _mm256_sub_epi32(vt3, vt2)), 12));
+    low = _mm256_or_si256(low, bit(_mm256_cmpgt_epi32(df2f1, df3f2), 13));
+    low = _mm256_or_si256(
+      low,
+      _mm256_slli_epi32(_mm256_and_si256(_mm256_srai_epi32(vf1, 1), _mm256_set1_epi32(0xFF)), 14));
+    low = _mm256_or_si256(
+      low, _mm256_slli_epi32(
+             _mm256_and_si256(_mm256_srli_epi32(df2f1, Fields::delta_shift), delta_mask), 22));
+    low = _mm256_or_si256(low, _mm256_slli_epi32(df3f2_field, Fields::df3f2_position));
+    __m256i high = _mm256_srli_epi32(df3f2_field, 32 - Fields::df3f2_position);
+    if constexpr (Fields::has_t2) {
+      high = _mm256_or_si256(
+        high, _mm256_slli_epi32(
+                _mm256_and_si256(_mm256_sub_epi32(vt2, vt1), mask6), Fields::t2_position - 32));
+    }
+
+    // unpack works per 128 bit lane: hashes 0,1,4,5 and 2,3,6,7
+    const __m256i even = _mm256_unpacklo_epi32(low, high);
+    const __m256i odd = _mm256_unpackhi_epi32(low, high);
+    _mm256_storeu_si256(
+      reinterpret_cast<__m256i *>(hashes + i), _mm256_permute2x128_si256(even, odd, 0x20));
+    _mm256_storeu_si256(
+      reinterpret_cast<__m256i *>(hashes + i + 4), _mm256_permute2x128_si256(even, odd, 0x31));
+  }
+  hash_fingerprints_sse2<Layout>(
+    f1 + i, f2 + i, f3 + i, t1 + i, t2 + i, t3 + i, count - i, hashes + i);
+}
+#endif
+
+#if defined(__AVX512F__)
+/**
+ * @brief 16 hashes at a time with AVX-512
+ */
+template <int Layout = hash_layout_v1>
+inline void hash_fingerprints_avx512(
+  const std::int32_t * f1, const std::int32_t * f2, const std::int32_t * f3,
+  const std::int32_t * t1, const std::int32_t * t2, const std::int32_t * t3, std::size_t count,
+  std::uint64_t * hashes)
+{
+  const auto bit = [](__mmask16 mask, int shift) {
+    return _mm512_maskz_set1_epi32(mask, 1 << shift);
+  };
+  // the zero masking forms with every lane set: the plain ones pass an undefined vector
+  // through, which GCC 12 reports as maybe uninitialized under -Wall
+  constexpr __mmask16 lanes32 = 0xFFFF;
+  constexpr __mmask8 lanes64 = 0xFF;
+  using Fields = HashFields<Layout>;
+  const __m512i mask6 = _mm512_set1_epi32(0x3F);
+  const __m512i delta_mask = _mm512_set1_epi32(Fields::delta_mask);
+
+  std::size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m512i vf1 = _mm512_loadu_si512(f1 + i);
+    const __m512i vf2 = _mm512_loadu_si512(f2 + i);
+    const __m512i vf3 = _mm512_loadu_si512(f3 + i);
+    const __m512i vt1 = _mm512_loadu_si512(t1 + i);
+    const __m512i vt2 = _mm512_loadu_si512(t2 + i);
+    const __m512i vt3 = _mm512_loadu_si512(t3 + i);
+
+    const __m512i df2f1 = _mm512_maskz_abs_epi32(lanes32, _mm512_sub_epi32(vf2, vf1));
+    const __m512i df3f2 = _mm512_maskz_abs_epi32(lanes32, _mm512_sub_epi32(vf3, vf2));
+    const __m512i df2f1_field = _mm512_and_si512(
+      _mm512_maskz_srli_epi32(lanes32, df2f1, Fields::delta_shift), delta_mask);
+    const __m512i df3f2_field = _mm512_and_si512(
+      _mm512_maskz_srli_epi32(lanes32, df3f2, Fields::delta_shift), delta_mask);
+    const __m512i f1_field =
+      _mm512_and_si512(_mm512_maskz_srai_epi32(lanes32, vf1, 1), _mm512_set1_epi32(0xFF));
+
+    __m512i low = _mm512_and_si512(_mm512_sub_epi32(vt3, vt1), mask6);
+    low = _mm512_or_si512(low, bit(_mm512_cmpgt_epi32_mask(vf1, vf2), 6));
+    low = _mm512_or_si512(low, bit(_mm512_cmpgt_epi32_mask(vf2, vf3), 7));
+    low = _mm512_or_si512(low, bit(_mm512_cmpgt_epi32_mask(vf3, vf1), 8));
+    low = _mm512_or_si512(
+      low,
+      bit(_mm512_cmpgt_epi32_mask(_mm512_sub_epi32(vt2, vt1), _mm512_sub_epi32(vt3, vt2)), 12));
+    low = _mm512_or_si512(low, bit(_mm512_cmpgt_epi32_mask(df2f1, df3f2), 13));
+    low = _mm512_or_si512(low, _mm512_maskz_slli_epi32(lanes32, f1_field, 14));
+    low = _mm512_or_si512(low, _mm512_maskz_slli_epi32(lanes32, df2f1_field, 22));
+    low = _mm512_or_si512(
+      low, _mm512_maskz_slli_epi32(lanes32, df3f2_field, Fields::df3f2_position));
+    __m512i high = _mm512_maskz_srli_epi32(lanes32, df3f2_field, 32 - Fields::df3f2_position);
+    if constexpr (Fields::has_t2) {
+      high = _mm512_or_si512(
+        high, _mm512_maskz_slli_epi32(
+                lanes32, _mm512_and_si512(_mm512_sub_epi32(vt2, vt1), mask6),
+                Fields::t2_position - 32));
+    }
+
+    // widen to 64 bits instead of interleaving across the four 128 bit lanes
+    for (int half = 0; half < 2; ++half) {
+      const __m512i low64 = _mm512_maskz_cvtepu32_epi64(
+        lanes64, half == 0 ? _mm512_maskz_extracti64x4_epi64(lanes64, low, 0)
+                           : _mm512_maskz_extracti64x4_epi64(lanes64, low, 1));
+      const __m512i high64 = _mm512_maskz_cvtepu32_epi64(
+        lanes64, half == 0 ? _mm512_maskz_extracti64x4_epi64(lanes64, high, 0)
+                           : _mm512_maskz_extracti64x4_epi64(lanes64, high, 1));
+      _mm512_storeu_si512(
+        hashes + i + 8 * half,
+        _mm512_or_si512(low64, _mm512_maskz_slli_epi64(lanes64, high64, 32)));
+    }
+  }
+  hash_fingerprints_avx2<Layout>(
+    f1 + i, f2 + i, f3 + i, t1 + i, t2 + i, t3 + i, count - i, hashes + i);
+}
+#endif
+
+#if defined(__ARM_NEON)
+/**
+ * @brief 4 hashes at a time with NEON
+ */
+template <int Layout = hash_layout_v1>
+inline void hash_fingerprints_neon(
+  const std::int32_t * f1, const std::int32_t * f2, const std::int32_t * f3,
+  const std::int32_t * t1, const std::int32_t * t2, const std::int32_t * t3, std::size_t count,
+  std::uint64_t * hashes)
+{
+  const auto bit = [](uint32x4_t mask, int shift) {
+    return vandq_u32(mask, vdupq_n_u32(1u << shift));
+  };
+  using Fields = HashFields<Layout>;
+  const uint32x4_t mask6 = vdupq_n_u32(0x3F);
+  const uint32x4_t delta_mask = vdupq_n_u32(Fields::delta_mask);
+
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const int32x4_t vf1 = vld1q_s32(f1 + i);
+    const int32x4_t vf2 = vld1q_s32(f2 + i);
+    const int32x4_t vf3 = vld1q_s32(f3 + i);
+    const int32x4_t vt1 = vld1q_s32(t1 + i);
+    const int32x4_t vt2 = vld1q_s32(t2 + i);
+    const int32x4_t vt3 = vld1q_s32(t3 + i);
+
+    const uint32x4_t df2f1 = vreinterpretq_u32_s32(vabsq_s32(vsubq_s32(vf2, vf1)));
+    const uint32x4_t df3f2 = vreinterpretq_u32_s32(vabsq_s32(vsubq_s32(vf3, vf2)));
+    const uint32x4_t df3f2_field = vandq_u32(vshrq_n_u32(df3f2, Fields::delta_shift), delta_mask);
+
+    uint32x4_t low = vandq_u32(vreinterpretq_u32_s32(vsubq_s32(vt3, vt1)), mask6);
+    low = vorrq_u32(low, bit(vcgtq_s32(vf1, vf2), 6));
+    low = vorrq_u32(low, bit(vcgtq_s32(vf2, vf3), 7));
+    low = vorrq_u32(low, bit(vcgtq_s32(vf3, vf1), 8));
+    low = vorrq_u32(low, bit(vcgtq_s32(vsubq_s32(vt2, vt1), vsubq_s32(vt3, vt2)), 12));
+    low = vorrq_u32(low, bit(vcgtq_u32(df2f1, df3f2), 13));
+    const uint32x4_t f1_range = vreinterpretq_u32_s32(vshrq_n_s32(vf1, 1));
+    low = vorrq_u32(low, vshlq_n_u32(vandq_u32(f1_range, vdupq_n_u32(0xFF)), 14));
+    low = vorrq_u32(
+      low, vshlq_n_u32(vandq_u32(vshrq_n_u32(df2f1, Fields::delta_shift), delta_mask), 22));
+    low = vorrq_u32(low, vshlq_n_u32(df3f2_field, Fields::df3f2_position));
+    uint32x4_t high = vshrq_n_u32(df3f2_field, 32 - Fields::df3f2_position);
+    if constexpr (Fields::has_t2) {
+      const uint32x4_t dt2t1 = vreinterpretq_u32_s32(vsubq_s32(vt2, vt1));
+      high = vorrq_u32(high, vshlq_n_u32(vandq_u32(dt2t1, mask6), Fields::t2_position - 32));
+    }
+
+    // interleaving store, low and high word of each hash
+    uint32x4x2_t words = {{low, high}};
+    vst2q_u32(reinterpret_cast<std::uint32_t *>(hashes + i), words);
+  }
+  hash_fingerprints_scalar<Layout>(
+    f1 + i, f2 + i, f3 + i, t1 + i, t2 + i, t3 + i, count - i, hashes + i);
+}
+#endif
+
+/**
+ * @brief Hash count fingerprints given as SoA arrays with the widest available SIMD path
+ */
+template <int Layout = hash_layout_v1>
+inline void hash_fingerprints(
+  const std::int32_t * f1, const std::int32_t * f2, const std::int32_t * f3,
+  const std::int32_t * t1, const std::int32_t * t2, const std::int32_t * t3, std::size_t count,
+  std::uint64_t * hashes)
+{
+#if defined(__AVX512F__)
+  hash_fingerprints_avx512<Layout>(f1, f2, f3, t1, t2, t3, count, hashes);
+#elif defined(__AVX2__)
+  hash_fingerprints_avx2<Layout>(f1, f2, f3, t1, t2, t3, count, hashes);
+#elif defined(__SSE2__)
+  hash_fingerprints_sse2<Layout>(f1, f2, f3, t1, t2, t3, count, hashes);
+#elif defined(__ARM_NEON)
+  hash_fingerprints_neon<Layout>(f1, f2, f3, t1, t2, t3, count, hashes);
+#else
+  hash_fingerprints_scalar<Layout>(f1, f2, f3, t1, t2, t3, count, hashes);
+#endif
+}
+
+inline void FingerprintBatch::hash(int layout)
+{
+  if (layout == hash_layout_v2) {
+    hash_fingerprints<hash_layout_v2>(
+      f1.data(), f2.data(), f3.data(), t1.data(), t2.data(), t3.data(), size, hashes.data());
+  } else {
+    hash_fingerprints<hash_layout_v1>(
+      f1.data(), f2.data(), f3.data(), t1.data(), t2.data(), t3.data(), size, hashes.data());
+  }
+}
+
+}  // namespace olaf
+
+#endif  // OLAF_FP_HASH_HPP
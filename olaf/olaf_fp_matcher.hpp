@@ -21,54 +21,94 @@
 #include <cinttypes>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <functional>
+#include <memory_resource>
 #include <unordered_map>
 #include <vector>
 
 #include "olaf_config.hpp"
 #include "olaf_db.hpp"
 #include "olaf_fp_extractor.hpp"
+#include "olaf_fp_hash.hpp"
+#include "olaf_match_votes.hpp"
+#include "olaf_profile.h"
 
 namespace olaf
 {
 
 /**
  * @brief Callback function to respond to a match result.
+ *
+ * Called from match() once all fingerprints of the block are counted, or from
+ * print_results(), never while votes are being tallied, so it may reset the matcher.
  */
 using MatchResultCallback = std::function<void(
   int match_count, float query_start, float query_stop, std::uint32_t audio_id,
   float reference_start, float reference_stop)>;
 
 /**
- * @struct MatchResult
- * @brief Represents a single match result
+ * @struct AudioTally
+ * @brief Votes of all time offset candidates of a single audio file
  */
-struct MatchResult
+struct AudioTally
 {
-  int reference_fingerprint_t1 = 0;
-  int query_fingerprint_t1 = 0;
-  int first_reference_fingerprint_t1 = 0;
-  int last_reference_fingerprint_t1 = 0;
-  int match_count = 0;
-  std::uint32_t match_identifier = 0;
-  std::uint64_t result_hash_table_key = 0;
+  int votes = 0;
+  int best_count = 0;
+  std::uint64_t best_key = 0;
 };
 
 /**
- * @class FPMatcher
+ * @class BasicFPMatcher
  * @brief Matches extracted fingerprints with a database
+ * @tparam Votes Where the votes per time offset are counted: MapVotes or HistogramVotes
  */
-class FPMatcher
+template <typename Votes>
+class BasicFPMatcher
 {
 private:
   const Config & config_;
-  DB & db_;
-  std::unordered_map<std::uint64_t, MatchResult> result_hash_table_;
-  std::vector<std::uint64_t> db_results_;
+  const DB & db_;
+  // match candidates come and go every block, the pool reuses their nodes
+  std::pmr::unsynchronized_pool_resource pool_;
+  Votes votes_;
+  std::pmr::vector<std::uint64_t> db_results_;
+  // the fingerprints of the current block, hashed in one batch
+  FingerprintBatch batch_;
+  // database lookups and the hits they returned, the cost of the hash layout
+  std::uint64_t db_lookups_ = 0;
+  std::uint64_t db_exact_lookups_ = 0;
+  std::uint64_t db_exact_misses_ = 0;
+  std::uint64_t db_hits_ = 0;
   MatchResultCallback result_callback_;
   int last_print_at_ = 0;
 
-  void tally_results(
+  // Running confidence: per audio tallies and the two best audio files
+  std::pmr::unordered_map<std::uint32_t, AudioTally> audio_tallies_;
+  const AudioTally * first_ = nullptr;
+  const AudioTally * second_ = nullptr;
+  std::uint32_t first_id_ = 0;
+  float confidence_ = 0;
+  bool decided_ = false;
+  std::uint64_t decided_key_ = 0;
+  // decided during the current block, reported once its votes are counted
+  bool decision_pending_ = false;
+
+  // Tracking state, valid while tracking_
+  bool tracking_ = false;
+  std::uint32_t tracked_audio_id_ = 0;
+  int tracked_offset_ = 0;
+  int last_tracked_hit_ = 0;
+
+  // copies of the best matches while printing results, the callback may reset the votes
+  std::pmr::vector<MatchResult> match_results_;
+
+  int seconds_to_blocks(float seconds) const
+  {
+    return static_cast<int>((seconds * config_.audioSampleRate) / config_.audioStepSize);
+  }
+
+  const MatchResult & tally_results(
     int query_fingerprint_t1, int reference_fingerprint_t1, std::uint32_t match_identifier)
   {
     const int time_diff = (query_fingerprint_t1 - reference_fingerprint_t1) >> 2;
@@ -77,11 +117,11 @@ private:
     const std::uint64_t match_part = static_cast<std::uint64_t>(match_identifier);
     const std::uint64_t result_hash_table_key = diff_part + match_part;
 
-    auto it = result_hash_table_.find(result_hash_table_key);
+    MatchResult * existing = votes_.find(result_hash_table_key);
 
-    if (it != result_hash_table_.end()) {
+    if (existing != nullptr) {
       // Update existing match
-      auto & match = it->second;
+      auto & match = *existing;
       match.reference_fingerprint_t1 = reference_fingerprint_t1;
       match.query_fingerprint_t1 = query_fingerprint_t1;
       match.match_count++;
@@ -89,6 +129,8 @@ private:
         std::min(reference_fingerprint_t1, match.first_reference_fingerprint_t1);
       match.last_reference_fingerprint_t1 =
         std::max(reference_fingerprint_t1, match.last_reference_fingerprint_t1);
+      update_confidence(match);
+      return match;
     } else {
       // Create new match
       MatchResult match;
@@ -100,17 +142,249 @@ private:
       match.match_identifier = match_identifier;
       match.result_hash_table_key = result_hash_table_key;
 
-      result_hash_table_[result_hash_table_key] = match;
+      const MatchResult & inserted = votes_.insert(match);
+      if (votes_.take_evicted()) {
+        // the tallies still count the replaced candidate
+        rebuild_confidence();
+      } else {
+        update_confidence(inserted);
+      }
+      return inserted;
+    }
+  }
+
+  /**
+     * @brief Votes in the offset bins next to key, time offsets are quantized so a
+     * consistent match may straddle two bins
+     */
+  int neighbour_votes(std::uint64_t key) const
+  {
+    constexpr std::uint64_t one_bin = static_cast<std::uint64_t>(1) << 32;
+    int votes = 0;
+    for (const std::uint64_t neighbour : {key - one_bin, key + one_bin}) {
+      const MatchResult * match = votes_.find(neighbour);
+      if (match != nullptr) votes += match->match_count;
+    }
+    return votes;
+  }
+
+  void evaluate_confidence()
+  {
+    const int runner_up = second_ ? second_->best_count : 0;
+    const int consistent = first_->best_count + neighbour_votes(first_->best_key);
+    const float consistency = static_cast<float>(consistent) / static_cast<float>(first_->votes);
+    confidence_ = static_cast<float>(first_->best_count - runner_up) * std::min(consistency, 1.0f);
+  }
+
+  /**
+     * @brief Update the running confidence after a vote for match
+     *
+     * The confidence is the vote margin of the best audio file over the runner-up,
+     * scaled by the fraction of the best file's votes that agree on its time offset.
+     * Counts only grow between resets, so the two best files are kept up to date
+     * incrementally.
+     */
+  void update_confidence(const MatchResult & match)
+  {
+    const std::uint32_t audio_id = match.match_identifier;
+    AudioTally & tally = audio_tallies_[audio_id];
+    tally.votes++;
+    if (match.match_count > tally.best_count) {
+      tally.best_count = match.match_count;
+      tally.best_key = match.result_hash_table_key;
+    }
+
+    if (first_ == &tally) {
+      // still the best
+    } else if (first_ == nullptr || tally.best_count > first_->best_count) {
+      second_ = first_;
+      first_ = &tally;
+      first_id_ = audio_id;
+    } else if (second_ == nullptr || tally.best_count > second_->best_count) {
+      second_ = &tally;
+    }
+
+    evaluate_confidence();
+
+    if (
+      !decided_ && config_.minMatchConfidence > 0 && confidence_ >= config_.minMatchConfidence &&
+      first_->best_count >= config_.minMatchCount) {
+      decided_ = true;
+      decided_key_ = first_->best_key;
+
+      const MatchResult & best = *votes_.find(decided_key_);
+      if (config_.verbose) {
+        std::fprintf(
+          stderr, "Decided on audio id %u, count %d, confidence %.2f\n", first_id_,
+          best.match_count, confidence_);
+      }
+      // The confidence replaces the minMatchTimeDiff criterion for a decision
+      decision_pending_ = true;
     }
   }
 
+  /**
+     * @brief Rebuild the per audio tallies, needed when matches are removed
+     */
+  void rebuild_confidence()
+  {
+    audio_tallies_.clear();
+    first_ = nullptr;
+    second_ = nullptr;
+    confidence_ = 0;
+
+    votes_.for_each([this](const MatchResult & match) {
+      AudioTally & tally = audio_tallies_[match.match_identifier];
+      tally.votes += match.match_count;
+      if (match.match_count > tally.best_count) {
+        tally.best_count = match.match_count;
+        tally.best_key = match.result_hash_table_key;
+      }
+    });
+
+    for (const auto & pair : audio_tallies_) {
+      const AudioTally & tally = pair.second;
+      if (first_ == nullptr || tally.best_count > first_->best_count) {
+        second_ = first_;
+        first_ = &tally;
+        first_id_ = pair.first;
+      } else if (second_ == nullptr || tally.best_count > second_->best_count) {
+        second_ = &tally;
+      }
+    }
+
+    if (first_ != nullptr) {
+      evaluate_confidence();
+    }
+
+    if (decided_ && votes_.find(decided_key_) == nullptr) {
+      decided_ = false;
+    }
+  }
+
+  /**
+     * @brief Hand a match to the result callback
+     * @param match The match to report
+     * @param check_time_diff Only report matches spanning at least minMatchTimeDiff
+     */
+  void report_result(const MatchResult & match, bool check_time_diff = true)
+  {
+    const float seconds_per_block =
+      static_cast<float>(config_.audioStepSize) / static_cast<float>(config_.audioSampleRate);
+
+    const float time_delta =
+      seconds_per_block * (match.query_fingerprint_t1 - match.reference_fingerprint_t1);
+
+    const float reference_start = match.first_reference_fingerprint_t1 * seconds_per_block;
+    const float reference_stop = match.last_reference_fingerprint_t1 * seconds_per_block;
+
+    if (!check_time_diff || (reference_stop - reference_start) >= config_.minMatchTimeDiff) {
+      const float query_start =
+        match.first_reference_fingerprint_t1 * seconds_per_block + time_delta;
+      const float query_stop =
+        match.last_reference_fingerprint_t1 * seconds_per_block + time_delta;
+
+      result_callback_(
+        match.match_count, query_start, query_stop, match.match_identifier, reference_start,
+        reference_stop);
+    }
+  }
+
+  /**
+     * @brief A match is confident enough to lock on when it is decided or, without a
+     * confidence threshold, when it would be reported
+     */
+  bool is_lockable(const MatchResult & match) const
+  {
+    if (config_.minMatchConfidence > 0) {
+      return decided_;
+    }
+
+    if (match.match_count < config_.minMatchCount) return false;
+
+    const float seconds_per_block =
+      static_cast<float>(config_.audioStepSize) / static_cast<float>(config_.audioSampleRate);
+    const float duration =
+      (match.last_reference_fingerprint_t1 - match.first_reference_fingerprint_t1) *
+      seconds_per_block;
+    return duration >= config_.minMatchTimeDiff;
+  }
+
+  /**
+     * @brief Verify a query fingerprint against the locked song only
+     *
+     * Only reference fingerprints within trackingWindow of the predicted reference
+     * time are visited. Every hit is a vote, but only the hit closest to the
+     * prediction moves the tracked offset, by at most one block per fingerprint, so a
+     * hash that repeats elsewhere in the window can not pull the lock away.
+     */
+  void track_single_fingerprint(
+    std::uint32_t query_fingerprint_t1, std::uint64_t query_fingerprint_hash)
+  {
+    const int range = config_.searchRange;
+    const int window = seconds_to_blocks(config_.trackingWindow);
+    const int predicted_t1 = static_cast<int>(query_fingerprint_t1) - tracked_offset_;
+
+    if (predicted_t1 + window < 0) return;
+
+    const std::uint32_t t_start = static_cast<std::uint32_t>(std::max(0, predicted_t1 - window));
+    const std::uint32_t t_stop = static_cast<std::uint32_t>(predicted_t1 + window);
+
+    OLAF_PROFILE_BEGIN(OLAF_STAGE_DB_FIND);
+    db_.find_near(
+      tracked_audio_id_, query_fingerprint_hash - range, query_fingerprint_hash + range, t_start,
+      t_stop, db_results_, config_.maxDBCollisions);
+    OLAF_PROFILE_END(OLAF_STAGE_DB_FIND);
+    db_lookups_++;
+    db_hits_ += db_results_.size();
+
+    OLAF_PROFILE_BEGIN(OLAF_STAGE_TALLY);
+    int closest_t1 = -1;
+    int closest_distance = window + 1;
+    for (const auto & db_result : db_results_) {
+      const int reference_fingerprint_t1 = static_cast<int>(db_result >> 32);
+      tally_results(query_fingerprint_t1, reference_fingerprint_t1, tracked_audio_id_);
+
+      const int distance = std::abs(reference_fingerprint_t1 - predicted_t1);
+      if (distance < closest_distance) {
+        closest_distance = distance;
+        closest_t1 = reference_fingerprint_t1;
+      }
+    }
+
+    if (closest_t1 >= 0) {
+      // Follow small drifts of the offset
+      const int offset = static_cast<int>(query_fingerprint_t1) - closest_t1;
+      tracked_offset_ += std::clamp(offset - tracked_offset_, -1, 1);
+      last_tracked_hit_ = static_cast<int>(query_fingerprint_t1);
+    }
+    OLAF_PROFILE_END(OLAF_STAGE_TALLY);
+  }
+
   void match_single_fingerprint(
     std::uint32_t query_fingerprint_t1, std::uint64_t query_fingerprint_hash)
   {
     const int range = config_.searchRange;
-    const std::size_t number_of_results = db_.find(
-      query_fingerprint_hash - range, query_fingerprint_hash + range, db_results_,
-      config_.maxDBCollisions);
+    // coarse to fine: once an offset has formed, the exact hash usually hits
+    const bool exact_first =
+      config_.exactLookupVotes > 0 && get_best_match_count() >= config_.exactLookupVotes;
+
+    OLAF_PROFILE_BEGIN(OLAF_STAGE_DB_FIND);
+    std::size_t number_of_results = 0;
+    if (exact_first) {
+      number_of_results = db_.find(
+        query_fingerprint_hash, query_fingerprint_hash, db_results_, config_.maxDBCollisions);
+      db_exact_lookups_++;
+    }
+    if (number_of_results == 0) {
+      if (exact_first) db_exact_misses_++;
+      number_of_results = db_.find(
+        query_fingerprint_hash - range, query_fingerprint_hash + range, db_results_,
+        config_.maxDBCollisions);
+    }
+    OLAF_PROFILE_END(OLAF_STAGE_DB_FIND);
+    db_lookups_++;
+    db_hits_ += number_of_results;
 
     if (config_.verbose) {
       std::fprintf(
@@ -130,6 +404,7 @@ private:
         query_fingerprint_hash, number_of_results, range, config_.maxDBCollisions);
     }
 
+    OLAF_PROFILE_BEGIN(OLAF_STAGE_TALLY);
     for (const auto & db_result : db_results_) {
       const std::uint32_t reference_fingerprint_t1 = static_cast<std::uint32_t>(db_result >> 32);
       const std::uint32_t match_identifier = static_cast<std::uint32_t>(db_result);
@@ -142,8 +417,17 @@ private:
           reference_fingerprint_t1, delta);
       }
 
-      tally_results(query_fingerprint_t1, reference_fingerprint_t1, match_identifier);
+      const MatchResult & match =
+        tally_results(query_fingerprint_t1, reference_fingerprint_t1, match_identifier);
+
+      if (config_.trackingWindow > 0 && !tracking_ && is_lockable(match)) {
+        const MatchResult & locked = decided_ ? get_decided_result() : match;
+        lock(
+          locked.match_identifier, locked.query_fingerprint_t1 - locked.reference_fingerprint_t1,
+          static_cast<int>(query_fingerprint_t1));
+      }
     }
+    OLAF_PROFILE_END(OLAF_STAGE_TALLY);
   }
 
   void remove_old_matches(int current_query_time)
@@ -151,22 +435,32 @@ private:
     const int max_age =
       static_cast<int>((config_.keepMatchesFor * config_.audioSampleRate) / config_.audioStepSize);
 
-    auto it = result_hash_table_.begin();
-    while (it != result_hash_table_.end()) {
-      const int age = current_query_time - it->second.query_fingerprint_t1;
-      if (age > max_age) {
-        it = result_hash_table_.erase(it);
-      } else {
-        ++it;
-      }
+    if (votes_.expire(current_query_time, max_age)) {
+      rebuild_confidence();
     }
   }
 
 public:
-  FPMatcher(const Config & config, DB & db, MatchResultCallback callback)
-  : config_(config), db_(db), result_callback_(std::move(callback)), last_print_at_(0)
+  /**
+   * @param resource Where the match candidates and buffers are allocated
+   */
+  BasicFPMatcher(
+    const Config & config, const DB & db, MatchResultCallback callback,
+    std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+  : config_(config),
+    db_(db),
+    pool_(resource),
+    votes_(config, db, resource, &pool_),
+    db_results_(resource),
+    batch_(resource),
+    result_callback_(std::move(callback)),
+    last_print_at_(0),
+    audio_tallies_(&pool_),
+    match_results_(resource)
   {
     db_results_.reserve(config.maxDBCollisions);
+    batch_.reserve(config.maxFingerprints);
+    match_results_.reserve(config.maxResults);
   }
 
   void match(ExtractedFingerprints & fingerprints)
@@ -174,9 +468,28 @@ public:
     auto first = fingerprints.fingerprints.begin();
     auto last = first + fingerprints.fingerprint_index;
 
-    for (auto it = first; it != last; ++it) {
-      const std::uint64_t hash = it->calculate_hash();
-      match_single_fingerprint(it->time_index1, hash);
+    batch_.assign(fingerprints);
+    batch_.hash(config_.hashLayout);
+
+    for (std::size_t i = 0; i < batch_.size; ++i) {
+      const std::uint64_t hash = batch_.hashes[i];
+      if (tracking_) {
+        track_single_fingerprint(batch_.t1[i], hash);
+      } else {
+        match_single_fingerprint(batch_.t1[i], hash);
+      }
+    }
+
+    if (tracking_ && fingerprints.fingerprint_index > 0) {
+      const int current_query_time = (last - 1)->time_index1;
+      if (current_query_time - last_tracked_hit_ > seconds_to_blocks(config_.trackingTimeout)) {
+        if (config_.verbose) {
+          std::fprintf(
+            stderr, "Lost track of audio id %u at q t1 %d, back to full search\n",
+            tracked_audio_id_, current_query_time);
+        }
+        unlock();
+      }
     }
 
     if (fingerprints.fingerprint_index > 0 && config_.printResultEvery != 0) {
@@ -197,8 +510,120 @@ public:
     }
 
     fingerprints.fingerprint_index = 0;
+
+    if (decision_pending_) {
+      decision_pending_ = false;
+      // the decided match may have expired with this block
+      if (decided_) report_result(get_decided_result(), false);
+    }
+  }
+
+  /**
+     * @brief Whether the running confidence crossed minMatchConfidence
+     *
+     * Once decided the pipeline may throttle extraction, the decision holds until
+     * reset() or until the decided match expires (keepMatchesFor).
+     */
+  bool is_decided() const { return decided_; }
+
+  /**
+     * @brief Current confidence of the best audio file, in votes
+     */
+  float get_confidence() const { return confidence_; }
+
+  /**
+     * @brief Audio id with the most consistent votes, only meaningful with votes
+     */
+  std::uint32_t get_best_audio_id() const { return first_id_; }
+
+  /**
+     * @brief Votes of the best time offset of the best audio file, 0 without votes
+     */
+  int get_best_match_count() const { return first_ ? first_->best_count : 0; }
+
+  /**
+     * @brief Best time offset of the best audio file, nullptr without votes
+     */
+  const MatchResult * get_best_result() const
+  {
+    return first_ ? votes_.find(first_->best_key) : nullptr;
+  }
+
+  /**
+     * @brief Database lookups since construction, one per query fingerprint
+     */
+  std::uint64_t get_db_lookups() const { return db_lookups_; }
+
+  /**
+     * @brief Lookups of the exact hash first, see Config::exactLookupVotes
+     */
+  std::uint64_t get_db_exact_lookups() const { return db_exact_lookups_; }
+
+  /**
+     * @brief Exact lookups without hits, widened to the full searchRange
+     */
+  std::uint64_t get_db_exact_misses() const { return db_exact_misses_; }
+
+  /**
+     * @brief Reference fingerprints the lookups returned, each one a vote to count
+     */
+  std::uint64_t get_db_hits() const { return db_hits_; }
+
+  /**
+     * @brief The decided match, only valid while is_decided()
+     */
+  const MatchResult & get_decided_result() const { return *votes_.find(decided_key_); }
+
+  /**
+     * @brief Forget all votes, the decision and the tracking lock
+     */
+  void reset()
+  {
+    votes_.clear();
+    audio_tallies_.clear();
+    first_ = nullptr;
+    second_ = nullptr;
+    first_id_ = 0;
+    confidence_ = 0;
+    decided_ = false;
+    decided_key_ = 0;
+    decision_pending_ = false;
+    tracking_ = false;
   }
 
+  /**
+     * @brief Lock on to a song, only verifying fingerprints around the predicted time
+     * @param audio_id Locked audio file
+     * @param offset Query time minus reference time, in blocks
+     * @param query_time Current query time, in blocks
+     */
+  void lock(std::uint32_t audio_id, int offset, int query_time)
+  {
+    tracking_ = true;
+    tracked_audio_id_ = audio_id;
+    tracked_offset_ = offset;
+    last_tracked_hit_ = query_time;
+
+    if (config_.verbose) {
+      std::fprintf(
+        stderr, "Tracking audio id %u with offset %d at q t1 %d\n", audio_id, offset, query_time);
+    }
+  }
+
+  /**
+     * @brief Go back to searching every fingerprint in the whole database
+     *
+     * The votes for the lost song would decide and lock on it again with the next
+     * hit, so they are forgotten with the decision: another song can win.
+     */
+  void unlock() { reset(); }
+
+  bool is_tracking() const { return tracking_; }
+
+  std::uint32_t get_tracked_audio_id() const { return tracked_audio_id_; }
+
+  int get_tracked_offset() const { return tracked_offset_; }
+
   static void print_header()
   {
     std::printf(
@@ -216,14 +641,11 @@ public:
 
   void print_results()
   {
-    std::vector<std::reference_wrapper<const MatchResult>> match_results;
-    match_results.reserve(config_.maxResults);
-
-    for (const auto & pair : result_hash_table_) {
-      const auto & match = pair.second;
+    match_results_.clear();
 
+    votes_.for_each([this](const MatchResult & match) {
       if (match.match_count > 1) {
-        auto time_delta = (int)(pair.first >> 32);
+        auto time_delta = (int)(match.result_hash_table_key >> 32);
         printf(
           "[%d]: match id %u, count %d, q t1 %d, ref t1 %d..%d\n", time_delta,
           match.match_identifier, match.match_count, match.query_fingerprint_t1,
@@ -231,51 +653,34 @@ public:
       }
 
       if (match.match_count >= config_.minMatchCount) {
-        if (match_results.size() >= config_.maxResults) {
+        if (match_results_.size() >= config_.maxResults) {
           std::sort(
-            match_results.begin(), match_results.end(),
+            match_results_.begin(), match_results_.end(),
             [](const MatchResult & a, const MatchResult & b) {
               return b.match_count < a.match_count;
             });
 
-          const int current_least = match_results.back().get().match_count;
+          const int current_least = match_results_.back().match_count;
           if (match.match_count > current_least) {
-            match_results.back() = std::cref(match);
+            match_results_.back() = match;
           }
         } else {
-          match_results.push_back(std::cref(match));
+          match_results_.push_back(match);
         }
       }
-    }
+    });
 
-    if (!match_results.empty()) {
+    if (!match_results_.empty()) {
       std::sort(
-        match_results.begin(), match_results.end(),
+        match_results_.begin(), match_results_.end(),
         [](const MatchResult & a, const MatchResult & b) { return b.match_count < a.match_count; });
     }
 
     const float seconds_per_block =
       static_cast<float>(config_.audioStepSize) / static_cast<float>(config_.audioSampleRate);
 
-    for (const auto & match_ref : match_results) {
-      const auto & match = match_ref.get();
-
-      const float time_delta =
-        seconds_per_block * (match.query_fingerprint_t1 - match.reference_fingerprint_t1);
-
-      const float reference_start = match.first_reference_fingerprint_t1 * seconds_per_block;
-      const float reference_stop = match.last_reference_fingerprint_t1 * seconds_per_block;
-
-      if ((reference_stop - reference_start) >= config_.minMatchTimeDiff) {
-        const float query_start =
-          match.first_reference_fingerprint_t1 * seconds_per_block + time_delta;
-        const float query_stop =
-          match.last_reference_fingerprint_t1 * seconds_per_block + time_delta;
-
-        result_callback_(
-          match.match_count, query_start, query_stop, match.match_identifier, reference_start,
-          reference_stop);
-      }
+    for (const MatchResult & match : match_results_) {
+      report_result(match);
 
       printf(
         "%d, %.2f, %.2f, %u, %.2f, %.2f\n", match.match_count,
@@ -287,12 +692,15 @@ public:
         match.last_reference_fingerprint_t1 * seconds_per_block);
     }
 
-    if (match_results.empty()) {
+    if (match_results_.empty()) {
       result_callback_(0, 0, 0, 0, 0, 0);
     }
   }
 };
 
+using FPMatcher = BasicFPMatcher<MapVotes>;
+using HistogramFPMatcher = BasicFPMatcher<HistogramVotes>;
+
 }  // namespace olaf
 
 #endif  // OLAF_FP_MATCHER_HPP
@@ -0,0 +1,515 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_FP_STORE_HPP
+#define OLAF_FP_STORE_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "olaf_db.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define OLAF_FP_STORE_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define OLAF_FP_STORE_HAS_MMAP 0
+#endif
+
+namespace olaf
+{
+
+/**
+ * @file olaf_fp_store.hpp
+ * @brief Binary fingerprint store that can be memory mapped and registered without copying.
+ *
+ * Layout of a store (all integers in the byte order of the writer, see header.byte_order):
+ *
+ *   [FPStoreHeader]        64 bytes at offset 0
+ *   [FPStoreEntry x N]     per song directory at header.directory_offset
+ *   [fingerprints]         one section per song, each aligned to header.section_alignment
+ *   [stop-list]            optional sorted hashes for DB::set_stop_list, aligned as well
+ *
+ * A section is the sorted, packed fingerprint array of one song, exactly as expected by
+ * DB::register_audio, with hashes of header.hash_layout (Config::hashLayout); stores
+ * written before that field existed read 0 there and hold layout 1 hashes. Opening a
+ * store only validates the header and directory, the fingerprint pages are faulted in
+ * on demand by the binary searches in DB::find.
+ *
+ * The store is read in place, so it only opens on a machine of the byte order it was
+ * written with. header.byte_order holds fp_store_byte_order_mark as written, a reader
+ * of the other byte order sees it swapped and refuses the store. Stores written before
+ * that field existed read 0 there and are little endian.
+ *
+ * An entry with fp_store_entry_tombstone in its flags has no fingerprints: it marks an
+ * audio ID as deleted in the delta segment of an FPCatalog, see olaf_fp_catalog.hpp.
+ */
+
+constexpr char fp_store_magic[8] = {'O', 'L', 'A', 'F', 'F', 'P', 'S', '\0'};
+constexpr std::uint32_t fp_store_version = 1;
+constexpr std::uint32_t fp_store_default_alignment = 64;
+constexpr std::uint64_t fp_store_entry_tombstone = 1;
+constexpr std::uint16_t fp_store_byte_order_mark = 0xFEFF;
+
+/**
+ * @struct FPStoreHeader
+ * @brief Fixed size header at the start of a fingerprint store
+ */
+struct FPStoreHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t header_size;
+  std::uint32_t song_count;
+  std::uint32_t section_alignment;
+  std::uint64_t directory_offset;
+  std::uint64_t total_fingerprints;
+  std::uint64_t file_size;
+  std::uint64_t stop_list_offset;
+  std::uint32_t stop_list_count;
+  std::uint16_t hash_layout;
+  // fp_store_byte_order_mark in the byte order of the writer
+  std::uint16_t byte_order;
+};
+
+/**
+ * @struct FPStoreEntry
+ * @brief Directory entry describing the fingerprint section of a single song
+ */
+struct FPStoreEntry
+{
+  std::uint32_t audio_id;
+  std::uint32_t duration_ms;
+  std::uint64_t fingerprints_offset;
+  std::uint64_t fingerprint_count;
+  // fp_store_entry_tombstone, 0 for a song
+  std::uint64_t flags;
+};
+
+static_assert(sizeof(FPStoreHeader) == 64, "FPStoreHeader must stay 64 bytes");
+static_assert(sizeof(FPStoreEntry) == 32, "FPStoreEntry must stay 32 bytes");
+
+inline std::uint64_t fp_store_align_up(std::uint64_t value, std::uint64_t alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief Write zeros from file offset from up to offset to
+ */
+inline bool fp_store_write_padding(std::FILE * file, std::uint64_t from, std::uint64_t to)
+{
+  static const char zeros[fp_store_default_alignment] = {0};
+  while (from < to) {
+    const std::size_t chunk =
+      static_cast<std::size_t>(std::min<std::uint64_t>(to - from, sizeof(zeros)));
+    if (std::fwrite(zeros, 1, chunk, file) != chunk) return false;
+    from += chunk;
+  }
+  return true;
+}
+
+/**
+ * @class FPStoreWriter
+ * @brief Host side writer for the binary fingerprint store
+ *
+ * The writer only keeps references to the fingerprint arrays, they need to stay valid
+ * until write() returns. Every array must be sorted ascending, as DB::find relies on it.
+ */
+class FPStoreWriter
+{
+private:
+  struct PendingSong
+  {
+    std::uint32_t audio_id;
+    std::uint32_t duration_ms;
+    std::span<const std::uint64_t> fingerprints;
+    std::uint64_t flags;
+  };
+
+  std::vector<PendingSong> songs_;
+  std::span<const std::uint64_t> stop_list_;
+  std::uint32_t alignment_;
+  std::uint16_t hash_layout_ = 1;
+
+public:
+  explicit FPStoreWriter(std::uint32_t alignment = fp_store_default_alignment)
+  : alignment_(alignment)
+  {
+    // Sections have to be at least aligned for uint64_t access
+    if (alignment_ < alignof(std::uint64_t) || (alignment_ & (alignment_ - 1)) != 0) {
+      alignment_ = fp_store_default_alignment;
+    }
+  }
+
+  /**
+     * @brief Add the sorted fingerprint array of a song
+     * @param audio_id Unique identifier for this audio
+     * @param fingerprints Sorted packed fingerprints (hash << 16 | t1)
+     * @param duration_ms Audio duration in milliseconds, 0 if unknown
+     * @return false if the fingerprints are not sorted
+     */
+  bool add_song(
+    std::uint32_t audio_id, std::span<const std::uint64_t> fingerprints,
+    std::uint32_t duration_ms = 0)
+  {
+    if (!std::is_sorted(fingerprints.begin(), fingerprints.end())) {
+      std::fprintf(stderr, "Fingerprints of audio ID %u are not sorted\n", audio_id);
+      return false;
+    }
+    songs_.push_back({audio_id, duration_ms, fingerprints, 0});
+    return true;
+  }
+
+  /**
+     * @brief Add an entry without fingerprints that marks audio_id as deleted
+     */
+  void add_tombstone(std::uint32_t audio_id)
+  {
+    songs_.push_back({audio_id, 0, {}, fp_store_entry_tombstone});
+  }
+
+  std::size_t get_song_count() const { return songs_.size(); }
+
+  /**
+     * @brief Store a stop-list with the songs
+     * @param sorted_hashes Sorted hashes, e.g. from StopListBuilder::build()
+     */
+  void set_stop_list(std::span<const std::uint64_t> sorted_hashes) { stop_list_ = sorted_hashes; }
+
+  /**
+     * @brief Record the Config::hashLayout the fingerprints were hashed with, 1 by default
+     */
+  void set_hash_layout(int hash_layout) { hash_layout_ = static_cast<std::uint16_t>(hash_layout); }
+
+  /**
+     * @brief Write all added songs to a store file
+     * @return true on success
+     */
+  bool write(const char * path) const
+  {
+    FPStoreHeader header = {};
+    std::memcpy(header.magic, fp_store_magic, sizeof(header.magic));
+    header.version = fp_store_version;
+    header.header_size = sizeof(FPStoreHeader);
+    header.song_count = static_cast<std::uint32_t>(songs_.size());
+    header.section_alignment = alignment_;
+    header.directory_offset = sizeof(FPStoreHeader);
+    header.hash_layout = hash_layout_;
+    header.byte_order = fp_store_byte_order_mark;
+
+    std::vector<FPStoreEntry> directory(songs_.size());
+    std::uint64_t offset = header.directory_offset + directory.size() * sizeof(FPStoreEntry);
+
+    for (std::size_t i = 0; i < songs_.size(); ++i) {
+      offset = fp_store_align_up(offset, alignment_);
+      directory[i].audio_id = songs_[i].audio_id;
+      directory[i].duration_ms = songs_[i].duration_ms;
+      directory[i].fingerprints_offset = offset;
+      directory[i].fingerprint_count = songs_[i].fingerprints.size();
+      directory[i].flags = songs_[i].flags;
+      offset += songs_[i].fingerprints.size_bytes();
+      header.total_fingerprints += songs_[i].fingerprints.size();
+    }
+
+    if (!stop_list_.empty()) {
+      offset = fp_store_align_up(offset, alignment_);
+      header.stop_list_offset = offset;
+      header.stop_list_count = static_cast<std::uint32_t>(stop_list_.size());
+      offset += stop_list_.size_bytes();
+    }
+    header.file_size = offset;
+
+    std::FILE * file = std::fopen(path, "wb");
+    if (file == nullptr) {
+      std::fprintf(stderr, "Could not open %s for writing\n", path);
+      return false;
+    }
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && !directory.empty()) {
+      ok = std::fwrite(directory.data(), sizeof(FPStoreEntry), directory.size(), file) ==
+           directory.size();
+    }
+
+    std::uint64_t written = header.directory_offset + directory.size() * sizeof(FPStoreEntry);
+    for (std::size_t i = 0; ok && i < songs_.size(); ++i) {
+      ok = fp_store_write_padding(file, written, directory[i].fingerprints_offset);
+      written = directory[i].fingerprints_offset;
+
+      const auto & fps = songs_[i].fingerprints;
+      if (ok && !fps.empty()) {
+        ok = std::fwrite(fps.data(), sizeof(std::uint64_t), fps.size(), file) == fps.size();
+      }
+      written += fps.size_bytes();
+    }
+
+    if (ok && !stop_list_.empty()) {
+      ok = fp_store_write_padding(file, written, header.stop_list_offset) &&
+           std::fwrite(stop_list_.data(), sizeof(std::uint64_t), stop_list_.size(), file) ==
+             stop_list_.size();
+    }
+
+    if (std::fclose(file) != 0) ok = false;
+
+    if (!ok) {
+      std::fprintf(stderr, "Failed writing fingerprint store %s\n", path);
+    }
+    return ok;
+  }
+};
+
+/**
+ * @class FPStore
+ * @brief Read only view on a binary fingerprint store
+ *
+ * On the host the store is memory mapped, so opening a multi-GB catalog is instant and
+ * the pages are shared between all processes using the same file. On the MCU the same
+ * format can be placed in a flash partition and attached with attach().
+ */
+class FPStore
+{
+private:
+  const std::uint8_t * data_ = nullptr;
+  std::size_t size_ = 0;
+  bool mapped_ = false;
+  const FPStoreHeader * header_ = nullptr;
+  const FPStoreEntry * directory_ = nullptr;
+
+  // count elements at offset lie inside the store, divided so a corrupt count can not wrap
+  bool fits(std::uint64_t offset, std::uint64_t count, std::size_t element_size) const
+  {
+    return offset <= size_ && count <= (size_ - offset) / element_size;
+  }
+
+  bool validate()
+  {
+    if (size_ < sizeof(FPStoreHeader)) {
+      std::fprintf(stderr, "Fingerprint store too small: %zu bytes\n", size_);
+      return false;
+    }
+
+    header_ = reinterpret_cast<const FPStoreHeader *>(data_);
+    if (std::memcmp(header_->magic, fp_store_magic, sizeof(fp_store_magic)) != 0) {
+      std::fprintf(stderr, "Not a fingerprint store (bad magic)\n");
+      return false;
+    }
+    const bool same_byte_order =
+      header_->byte_order == fp_store_byte_order_mark ||
+      (header_->byte_order == 0 && std::endian::native == std::endian::little);
+    if (!same_byte_order) {
+      std::fprintf(
+        stderr, "Fingerprint store of another byte order (mark 0x%04x)\n", header_->byte_order);
+      return false;
+    }
+    if (header_->version != fp_store_version || header_->header_size != sizeof(FPStoreHeader)) {
+      std::fprintf(
+        stderr, "Unsupported fingerprint store version %u (expected %u)\n", header_->version,
+        fp_store_version);
+      return false;
+    }
+    if (header_->file_size > size_) {
+      std::fprintf(
+        stderr, "Truncated fingerprint store: %zu of %llu bytes\n", size_,
+        static_cast<unsigned long long>(header_->file_size));
+      return false;
+    }
+
+    if (
+      header_->directory_offset % alignof(FPStoreEntry) != 0 ||
+      !fits(header_->directory_offset, header_->song_count, sizeof(FPStoreEntry))) {
+      std::fprintf(stderr, "Invalid fingerprint store directory\n");
+      return false;
+    }
+    directory_ = reinterpret_cast<const FPStoreEntry *>(data_ + header_->directory_offset);
+
+    for (std::uint32_t i = 0; i < header_->song_count; ++i) {
+      const FPStoreEntry & entry = directory_[i];
+      if (
+        entry.fingerprints_offset % alignof(std::uint64_t) != 0 ||
+        !fits(entry.fingerprints_offset, entry.fingerprint_count, sizeof(std::uint64_t))) {
+        std::fprintf(stderr, "Invalid fingerprint section for audio ID %u\n", entry.audio_id);
+        return false;
+      }
+    }
+
+    if (
+      header_->stop_list_offset % alignof(std::uint64_t) != 0 ||
+      !fits(header_->stop_list_offset, header_->stop_list_count, sizeof(std::uint64_t))) {
+      std::fprintf(stderr, "Invalid fingerprint store stop-list\n");
+      return false;
+    }
+    return true;
+  }
+
+public:
+  FPStore() = default;
+  ~FPStore() { close(); }
+
+  FPStore(const FPStore &) = delete;
+  FPStore & operator=(const FPStore &) = delete;
+
+  /**
+     * @brief Use a store that is already in memory, e.g. in memory mapped flash
+     * @param data Start of the store, at least 8 byte aligned
+     * @param size Size of the store in bytes
+     * @return true if the header and directory are valid
+     */
+  bool attach(const void * data, std::size_t size)
+  {
+    close();
+    data_ = static_cast<const std::uint8_t *>(data);
+    size_ = size;
+    if (!validate()) {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+#if OLAF_FP_STORE_HAS_MMAP
+  /**
+     * @brief Memory map a store file read only
+     * @return true if the file is mapped and valid
+     */
+  bool open(const char * path)
+  {
+    close();
+
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      std::fprintf(stderr, "Could not open fingerprint store %s\n", path);
+      return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+      std::fprintf(stderr, "Could not stat fingerprint store %s\n", path);
+      ::close(fd);
+      return false;
+    }
+
+    const std::size_t size = static_cast<std::size_t>(st.st_size);
+    void * addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+
+    if (addr == MAP_FAILED) {
+      std::fprintf(stderr, "Could not mmap fingerprint store %s\n", path);
+      return false;
+    }
+
+    // Lookups are binary searches, read ahead would only pollute the page cache
+    ::madvise(addr, size, MADV_RANDOM);
+
+    data_ = static_cast<const std::uint8_t *>(addr);
+    size_ = size;
+    mapped_ = true;
+
+    if (!validate()) {
+      close();
+      return false;
+    }
+    return true;
+  }
+#endif
+
+  void close()
+  {
+#if OLAF_FP_STORE_HAS_MMAP
+    if (mapped_ && data_ != nullptr) {
+      ::munmap(const_cast<std::uint8_t *>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    header_ = nullptr;
+    directory_ = nullptr;
+  }
+
+  bool is_open() const { return header_ != nullptr; }
+
+  std::size_t get_song_count() const { return header_ ? header_->song_count : 0; }
+
+  std::uint64_t get_total_fingerprints() const { return header_ ? header_->total_fingerprints : 0; }
+
+  /**
+     * @brief Config::hashLayout the store was written with, queries must use the same
+     */
+  int get_hash_layout() const
+  {
+    return header_ && header_->hash_layout != 0 ? static_cast<int>(header_->hash_layout) : 1;
+  }
+
+  const FPStoreEntry & get_entry(std::size_t index) const { return directory_[index]; }
+
+  bool is_tombstone(std::size_t index) const
+  {
+    return (directory_[index].flags & fp_store_entry_tombstone) != 0;
+  }
+
+  std::span<const std::uint64_t> get_fingerprints(std::size_t index) const
+  {
+    const FPStoreEntry & entry = directory_[index];
+    return std::span<const std::uint64_t>(
+      reinterpret_cast<const std::uint64_t *>(data_ + entry.fingerprints_offset),
+      static_cast<std::size_t>(entry.fingerprint_count));
+  }
+
+  std::span<const std::uint64_t> get_stop_list() const
+  {
+    if (header_ == nullptr || header_->stop_list_count == 0) return {};
+    return std::span<const std::uint64_t>(
+      reinterpret_cast<const std::uint64_t *>(data_ + header_->stop_list_offset),
+      static_cast<std::size_t>(header_->stop_list_count));
+  }
+
+  /**
+     * @brief Register every song of the store with a database, without copying
+     *
+     * The stop-list of the store, if any, is installed as well. Tombstones are skipped.
+     * The store must outlive the database registrations.
+     * @return Number of registered songs
+     */
+  std::size_t register_all(DB & db) const
+  {
+    std::size_t registered = 0;
+    for (std::size_t i = 0; i < get_song_count(); ++i) {
+      if (is_tombstone(i)) continue;
+      const auto fps = get_fingerprints(i);
+      db.register_audio(directory_[i].audio_id, fps.data(), fps.size());
+      ++registered;
+    }
+    if (header_ != nullptr && header_->stop_list_count > 0) {
+      db.set_stop_list(get_stop_list());
+    }
+    return registered;
+  }
+};
+
+}  // namespace olaf
+
+#endif  // OLAF_FP_STORE_HPP
@@ -0,0 +1,474 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_FP_STORE_BUILDER_HPP
+#define OLAF_FP_STORE_BUILDER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "olaf_config.hpp"
+#include "olaf_fp_store.hpp"
+
+namespace olaf
+{
+
+/**
+ * @class FPStoreBuilder
+ * @brief Host side writer of fingerprint stores for catalogs that do not fit in memory
+ *
+ * FPStoreWriter needs every fingerprint array, and StopListBuilder every distinct hash of
+ * the catalog, in memory until the store is written. The builder spills to disk instead:
+ * add_song() appends the sorted section of a song to a temporary file and, when the
+ * configuration has a stop-list, its hashes to a run buffer that is sorted and written as
+ * a run file whenever it is full. finish() k-way merges the runs, at most fan_in at a
+ * time, to count every hash of the catalog, then streams the sections into the store in
+ * audio ID order, pruned by the stop-list. The store is the same as the one FPStoreWriter
+ * writes from StopListBuilder::prune()d arrays.
+ *
+ * Memory stays at the run buffer, a read buffer per merged run, the stop-list and 24
+ * bytes per song. The temporary files are created next to the store and removed again.
+ */
+class FPStoreBuilder
+{
+private:
+  struct SpilledSong
+  {
+    std::uint32_t audio_id;
+    std::uint32_t duration_ms;
+    std::uint64_t spill_offset;
+    std::uint64_t fingerprint_count;
+  };
+
+  // buffered sequential reads of a file of uint64_t values
+  class Reader
+  {
+  private:
+    std::FILE * file_;
+    std::vector<std::uint64_t> buffer_;
+    std::size_t position_ = 0;
+    std::size_t size_ = 0;
+    std::uint64_t remaining_;
+
+  public:
+    Reader(std::FILE * file, std::uint64_t count, std::size_t buffer_values)
+    : file_(file), buffer_(buffer_values), remaining_(count)
+    {
+    }
+
+    bool next(std::uint64_t & value)
+    {
+      if (position_ == size_) {
+        const std::size_t wanted =
+          static_cast<std::size_t>(std::min<std::uint64_t>(buffer_.size(), remaining_));
+        if (wanted == 0) return false;
+        size_ = std::fread(buffer_.data(), sizeof(std::uint64_t), wanted, file_);
+        position_ = 0;
+        remaining_ -= size_;
+        if (size_ == 0) return false;
+      }
+      value = buffer_[position_++];
+      return true;
+    }
+  };
+
+  // buffered sequential writes of uint64_t values
+  class Writer
+  {
+  private:
+    std::FILE * file_;
+    std::vector<std::uint64_t> buffer_;
+    bool ok_ = true;
+
+  public:
+    Writer(std::FILE * file, std::size_t buffer_values) : file_(file)
+    {
+      buffer_.reserve(buffer_values);
+    }
+
+    void push(std::uint64_t value)
+    {
+      buffer_.push_back(value);
+      if (buffer_.size() == buffer_.capacity()) flush();
+    }
+
+    bool flush()
+    {
+      if (ok_ && !buffer_.empty()) {
+        ok_ = std::fwrite(buffer_.data(), sizeof(std::uint64_t), buffer_.size(), file_) ==
+              buffer_.size();
+      }
+      buffer_.clear();
+      return ok_;
+    }
+  };
+
+  struct Run
+  {
+    std::string path;
+    std::uint64_t count;
+  };
+
+  std::string path_;
+  std::string sections_path_;
+  std::size_t max_occurrences_;
+  std::uint16_t hash_layout_;
+  std::uint32_t alignment_;
+  std::size_t fan_in_;
+  std::FILE * sections_ = nullptr;
+  std::uint64_t sections_count_ = 0;
+  std::vector<SpilledSong> songs_;
+  std::vector<std::uint64_t> run_;
+  std::vector<Run> runs_;
+  std::size_t runs_written_ = 0;
+  std::uint64_t spilled_bytes_ = 0;
+  bool failed_ = false;
+
+  std::vector<std::uint64_t> stop_list_;
+  std::uint64_t total_fingerprints_ = 0;
+  std::uint64_t file_size_ = 0;
+
+  std::string next_run_path() { return path_ + ".run" + std::to_string(runs_written_++) + ".tmp"; }
+
+  bool fail(const char * what, const std::string & path)
+  {
+    std::fprintf(stderr, "Failed %s %s\n", what, path.c_str());
+    failed_ = true;
+    return false;
+  }
+
+  bool spill_run()
+  {
+    if (run_.empty()) return true;
+    std::sort(run_.begin(), run_.end());
+    Run run{next_run_path(), run_.size()};
+    std::FILE * file = std::fopen(run.path.c_str(), "wb");
+    if (file == nullptr) return fail("creating", run.path);
+    const bool ok = std::fwrite(run_.data(), sizeof(std::uint64_t), run_.size(), file) ==
+                    run_.size();
+    if (std::fclose(file) != 0 || !ok) return fail("writing", run.path);
+    spilled_bytes_ += run_.size() * sizeof(std::uint64_t);
+    runs_.push_back(std::move(run));
+    run_.clear();
+    return true;
+  }
+
+  /**
+   * @brief k-way merge of sorted runs, every value in order goes to sink
+   */
+  template <typename Sink>
+  bool merge(std::span<const Run> runs, std::size_t buffer_values, Sink && sink)
+  {
+    std::vector<std::FILE *> files;
+    std::vector<Reader> readers;
+    files.reserve(runs.size());
+    readers.reserve(runs.size());
+    bool ok = true;
+    for (const Run & run : runs) {
+      std::FILE * file = std::fopen(run.path.c_str(), "rb");
+      if (file == nullptr) {
+        ok = fail("opening", run.path);
+        break;
+      }
+      files.push_back(file);
+      readers.emplace_back(file, run.count, buffer_values);
+    }
+
+    using Head = std::pair<std::uint64_t, std::size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    for (std::size_t i = 0; ok && i < readers.size(); ++i) {
+      std::uint64_t value;
+      if (readers[i].next(value)) heads.push({value, i});
+    }
+    std::uint64_t merged = 0;
+    while (ok && !heads.empty()) {
+      const auto [value, index] = heads.top();
+      heads.pop();
+      sink(value);
+      ++merged;
+      std::uint64_t next;
+      if (readers[index].next(next)) heads.push({next, index});
+    }
+
+    std::uint64_t expected = 0;
+    for (std::FILE * file : files) std::fclose(file);
+    for (const Run & run : runs) {
+      std::remove(run.path.c_str());
+      expected += run.count;
+    }
+    if (ok && merged != expected) return fail("reading", runs.front().path);
+    return ok;
+  }
+
+  // merge fan_in runs at a time until at most fan_in are left
+  bool reduce_runs(std::size_t buffer_values)
+  {
+    while (runs_.size() > fan_in_) {
+      Run output{next_run_path(), 0};
+      std::FILE * file = std::fopen(output.path.c_str(), "wb");
+      if (file == nullptr) return fail("creating", output.path);
+
+      // merge() removes its inputs
+      const std::size_t count = std::min(fan_in_, runs_.size() - fan_in_ + 1);
+      std::vector<Run> inputs(runs_.begin(), runs_.begin() + count);
+      runs_.erase(runs_.begin(), runs_.begin() + count);
+      Writer writer(file, buffer_values);
+      const bool merged = merge(inputs, buffer_values, [&](std::uint64_t value) {
+        writer.push(value);
+        ++output.count;
+      });
+      const bool written = writer.flush();
+      if (std::fclose(file) != 0 || !written || !merged) {
+        std::remove(output.path.c_str());
+        return merged ? fail("writing", output.path) : false;
+      }
+      spilled_bytes_ += output.count * sizeof(std::uint64_t);
+      runs_.push_back(std::move(output));
+    }
+    return true;
+  }
+
+  bool count_hashes(std::size_t buffer_values)
+  {
+    if (!reduce_runs(buffer_values)) return false;
+    std::uint64_t current = 0;
+    std::size_t occurrences = 0;
+    const bool ok = merge(runs_, buffer_values, [&](std::uint64_t hash) {
+      if (occurrences > 0 && hash == current) {
+        ++occurrences;
+        return;
+      }
+      if (occurrences > max_occurrences_) stop_list_.push_back(current);
+      current = hash;
+      occurrences = 1;
+    });
+    if (occurrences > max_occurrences_) stop_list_.push_back(current);
+    runs_.clear();
+    return ok;
+  }
+
+  bool write_store(std::size_t buffer_values)
+  {
+    std::FILE * file = std::fopen(path_.c_str(), "wb");
+    if (file == nullptr) return fail("creating", path_);
+
+    FPStoreHeader header = {};
+    std::memcpy(header.magic, fp_store_magic, sizeof(header.magic));
+    header.version = fp_store_version;
+    header.header_size = sizeof(FPStoreHeader);
+    header.song_count = static_cast<std::uint32_t>(songs_.size());
+    header.section_alignment = alignment_;
+    header.directory_offset = sizeof(FPStoreHeader);
+    header.hash_layout = hash_layout_;
+    header.byte_order = fp_store_byte_order_mark;
+
+    // the directory is written again once the pruned counts are known
+    std::vector<FPStoreEntry> directory(songs_.size());
+    std::uint64_t written = header.directory_offset + directory.size() * sizeof(FPStoreEntry);
+    bool ok = std::fseek(file, static_cast<long>(written), SEEK_SET) == 0;
+
+    Writer writer(file, buffer_values);
+    for (std::size_t i = 0; ok && i < songs_.size(); ++i) {
+      const SpilledSong & song = songs_[i];
+      const std::uint64_t offset = fp_store_align_up(written, alignment_);
+      ok = writer.flush() && fp_store_write_padding(file, written, offset) &&
+           std::fseek(
+             sections_, static_cast<long>(song.spill_offset * sizeof(std::uint64_t)),
+             SEEK_SET) == 0;
+
+      // both the section and the stop-list are sorted by hash, walk them in lock step
+      Reader reader(sections_, song.fingerprint_count, buffer_values);
+      auto stop_it = stop_list_.begin();
+      std::uint64_t kept = 0, read = 0, packed;
+      while (ok && reader.next(packed)) {
+        ++read;
+        const std::uint64_t hash = packed >> 16;
+        while (stop_it != stop_list_.end() && *stop_it < hash) ++stop_it;
+        if (stop_it != stop_list_.end() && *stop_it == hash) continue;
+        writer.push(packed);
+        ++kept;
+      }
+      if (read != song.fingerprint_count) ok = fail("reading", sections_path_);
+
+      directory[i] = {song.audio_id, song.duration_ms, offset, kept, 0};
+      header.total_fingerprints += kept;
+      written = offset + kept * sizeof(std::uint64_t);
+    }
+    ok = writer.flush() && ok;
+
+    if (ok && !stop_list_.empty()) {
+      header.stop_list_offset = fp_store_align_up(written, alignment_);
+      header.stop_list_count = static_cast<std::uint32_t>(stop_list_.size());
+      ok = fp_store_write_padding(file, written, header.stop_list_offset) &&
+           std::fwrite(stop_list_.data(), sizeof(std::uint64_t), stop_list_.size(), file) ==
+             stop_list_.size();
+      written = header.stop_list_offset + stop_list_.size() * sizeof(std::uint64_t);
+    }
+    header.file_size = written;
+
+    ok = ok && std::fseek(file, 0, SEEK_SET) == 0 &&
+         std::fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && !directory.empty()) {
+      ok = std::fwrite(directory.data(), sizeof(FPStoreEntry), directory.size(), file) ==
+           directory.size();
+    }
+    if (std::fclose(file) != 0 || !ok) return fail("writing fingerprint store", path_);
+
+    total_fingerprints_ = header.total_fingerprints;
+    file_size_ = header.file_size;
+    return true;
+  }
+
+  void remove_temporary_files()
+  {
+    if (sections_ != nullptr) {
+      std::fclose(sections_);
+      sections_ = nullptr;
+      std::remove(sections_path_.c_str());
+    }
+    for (const Run & run : runs_) {
+      std::remove(run.path.c_str());
+    }
+    runs_.clear();
+  }
+
+public:
+  // bytes of hashes sorted in memory before they are spilled as a run
+  static constexpr std::size_t default_run_bytes = 64 << 20;
+  // runs merged at once, each one needs an open file and a read buffer
+  static constexpr std::size_t default_fan_in = 64;
+
+  /**
+   * @param config Stop-list threshold (maxHashOccurrences) and hashLayout of the store
+   * @param path Store to write, the temporary files get the same name with a suffix
+   */
+  FPStoreBuilder(
+    const Config & config, const char * path, std::size_t run_bytes = default_run_bytes,
+    std::size_t fan_in = default_fan_in, std::uint32_t alignment = fp_store_default_alignment)
+  : path_(path),
+    sections_path_(path_ + ".sections.tmp"),
+    max_occurrences_(config.maxHashOccurrences),
+    hash_layout_(static_cast<std::uint16_t>(config.hashLayout)),
+    alignment_(alignment),
+    fan_in_(std::max<std::size_t>(2, fan_in))
+  {
+    if (alignment_ < alignof(std::uint64_t) || (alignment_ & (alignment_ - 1)) != 0) {
+      alignment_ = fp_store_default_alignment;
+    }
+    if (max_occurrences_ > 0) {
+      run_.reserve(std::max<std::size_t>(1, run_bytes / sizeof(std::uint64_t)));
+    }
+    sections_ = std::fopen(sections_path_.c_str(), "w+b");
+    if (sections_ == nullptr) fail("creating", sections_path_);
+  }
+
+  ~FPStoreBuilder() { remove_temporary_files(); }
+
+  FPStoreBuilder(const FPStoreBuilder &) = delete;
+  FPStoreBuilder & operator=(const FPStoreBuilder &) = delete;
+
+  /**
+     * @brief Spill the sorted fingerprint array of a song, it can be freed afterwards
+     * @param audio_id Unique identifier for this audio
+     * @param fingerprints Sorted packed fingerprints (hash << 16 | t1)
+     * @param duration_ms Audio duration in milliseconds, 0 if unknown
+     * @return false if the fingerprints are not sorted or could not be written
+     */
+  bool add_song(
+    std::uint32_t audio_id, std::span<const std::uint64_t> fingerprints,
+    std::uint32_t duration_ms = 0)
+  {
+    if (failed_) return false;
+    if (!std::is_sorted(fingerprints.begin(), fingerprints.end())) {
+      std::fprintf(stderr, "Fingerprints of audio ID %u are not sorted\n", audio_id);
+      return false;
+    }
+    if (
+      !fingerprints.empty() &&
+      std::fwrite(fingerprints.data(), sizeof(std::uint64_t), fingerprints.size(), sections_) !=
+        fingerprints.size()) {
+      return fail("writing", sections_path_);
+    }
+    songs_.push_back({audio_id, duration_ms, sections_count_, fingerprints.size()});
+    sections_count_ += fingerprints.size();
+    spilled_bytes_ += fingerprints.size_bytes();
+
+    if (max_occurrences_ > 0) {
+      for (const std::uint64_t packed : fingerprints) {
+        if (run_.size() == run_.capacity() && !spill_run()) return false;
+        run_.push_back(packed >> 16);
+      }
+    }
+    return true;
+  }
+
+  /**
+     * @brief Count the hashes, build the stop-list and write the store
+     * @param buffer_bytes Read and write buffer per file
+     * @return true on success, the temporary files are gone either way
+     */
+  bool finish(std::size_t buffer_bytes = 1 << 20)
+  {
+    const std::size_t buffer_values =
+      std::max<std::size_t>(1, buffer_bytes / sizeof(std::uint64_t));
+    bool ok = !failed_ && spill_run() && std::fflush(sections_) == 0;
+    run_ = std::vector<std::uint64_t>();
+
+    if (ok && max_occurrences_ > 0) ok = count_hashes(buffer_values);
+    if (ok) {
+      std::stable_sort(
+        songs_.begin(), songs_.end(),
+        [](const SpilledSong & a, const SpilledSong & b) { return a.audio_id < b.audio_id; });
+      ok = write_store(buffer_values);
+    }
+    remove_temporary_files();
+    return ok;
+  }
+
+  std::size_t get_song_count() const { return songs_.size(); }
+
+  /**
+     * @brief Bytes written to temporary files so far: sections, runs and merged runs
+     */
+  std::uint64_t get_spilled_bytes() const { return spilled_bytes_; }
+
+  std::size_t get_run_count() const { return runs_written_; }
+
+  /**
+     * @brief The stop-list written by finish()
+     */
+  std::span<const std::uint64_t> get_stop_list() const { return stop_list_; }
+
+  /**
+     * @brief Fingerprints in the store after pruning, known after finish()
+     */
+  std::uint64_t get_total_fingerprints() const { return total_fingerprints_; }
+
+  std::uint64_t get_file_size() const { return file_size_; }
+};
+
+}  // namespace olaf
+
+#endif  // OLAF_FP_STORE_BUILDER_HPP
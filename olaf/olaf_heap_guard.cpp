@@ -0,0 +1,63 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file olaf_heap_guard.cpp
+ * @brief Global operator new that traps inside an olaf::HeapGuard
+ *
+ * Debug builds only: link this file and define OLAF_HEAP_GUARD. The nothrow
+ * forms of the runtime call these; over-aligned allocations are not checked.
+ */
+
+#if defined(OLAF_HEAP_GUARD)
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "olaf_memory.hpp"
+
+namespace
+{
+
+void * guarded_malloc(std::size_t size)
+{
+  if (olaf::heap_guard_depth() > 0) {
+    std::fprintf(stderr, "Heap allocation of %zu bytes inside a HeapGuard\n", size);
+    std::abort();
+  }
+  void * pointer = std::malloc(size == 0 ? 1 : size);
+  if (pointer == nullptr) {
+    std::abort();
+  }
+  return pointer;
+}
+
+}  // namespace
+
+void * operator new(std::size_t size) { return guarded_malloc(size); }
+
+void * operator new[](std::size_t size) { return guarded_malloc(size); }
+
+void operator delete(void * pointer) noexcept { std::free(pointer); }
+
+void operator delete[](void * pointer) noexcept { std::free(pointer); }
+
+void operator delete(void * pointer, std::size_t) noexcept { std::free(pointer); }
+
+void operator delete[](void * pointer, std::size_t) noexcept { std::free(pointer); }
+
+#endif
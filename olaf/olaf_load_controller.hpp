@@ -0,0 +1,235 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_LOAD_CONTROLLER_HPP
+#define OLAF_LOAD_CONTROLLER_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "olaf_config.hpp"
+#include "olaf_ep_extractor.hpp"
+#include "olaf_fp_extractor.hpp"
+
+namespace olaf
+{
+
+/**
+ * @struct LoadTelemetry
+ * @brief The extraction limits chosen by the LoadController and the load they are based on
+ */
+struct LoadTelemetry
+{
+  int level = 0;
+  float min_event_point_magnitude = 0;
+  int max_event_points = 0;
+  std::size_t max_fingerprints = 0;
+
+  float budget_us = 0;
+  float average_us = 0;
+  float worst_us = 0;
+  std::uint32_t blocks = 0;
+  std::uint32_t over_budget = 0;
+
+  void print() const
+  {
+    std::fprintf(
+      stderr,
+      "Load level %d: min magnitude %.4f, max event points %d, max fingerprints %zu, "
+      "block %.0f us avg / %.0f us worst of %.0f us, %u of %u blocks over budget\n",
+      level, min_event_point_magnitude, max_event_points, max_fingerprints, average_us, worst_us,
+      budget_us, over_budget, blocks);
+  }
+};
+
+/**
+ * @brief A free running clock in microseconds that wraps around, e.g. from the system timer
+ */
+using LoadClock = std::uint32_t (*)();
+
+/**
+ * @class LoadController
+ * @brief Keeps the per block processing time under a budget by adapting the extraction limits
+ *
+ * Dense passages produce many event points, and combining them into fingerprints
+ * and matching those is what makes a block expensive. After every block the
+ * measured processing time is passed to update(). When several of the last
+ * blocks exceeded the budget, or the running average gets close to it, the
+ * controller raises the level. Each level multiplies minEventPointMagnitude by
+ * magnitude_step and scales the event point and fingerprint caps by cap_step.
+ * A single slow block, e.g. one preempted by another thread, changes nothing.
+ * After a change the level holds for settle_blocks, so the effect of the new
+ * limits is measured before the next step. The level only drops again after
+ * the average has stayed low for a while, so it does not oscillate. Level 0
+ * are the Config values; the controller never goes beyond them.
+ */
+class LoadController
+{
+public:
+  // running average weight of a new block
+  static constexpr float average_weight = 1.0f / 16.0f;
+  // raise the level when the average exceeds this part of the budget
+  static constexpr float high_load = 0.75f;
+  // lower the level when the average stays under this part of the budget
+  static constexpr float low_load = 0.4f;
+  // blocks the load has to stay low before lowering the level, 0.5 s at 128/16000
+  static constexpr std::uint32_t relax_blocks = 64;
+  // blocks a new level holds before it is raised again
+  static constexpr std::uint32_t settle_blocks = 16;
+  // raise the level when this many of the last settle_blocks blocks were over budget
+  static constexpr int over_budget_blocks = 3;
+  static constexpr int max_level = 8;
+  static constexpr float magnitude_step = 1.5f;
+  static constexpr float cap_step = 0.8f;
+
+private:
+  const Config & config_;
+  LoadTelemetry telemetry_;
+  std::uint32_t low_load_blocks_ = 0;
+  // blocks since the last change, the average needs time to follow
+  std::uint32_t settled_blocks_ = 0;
+  // one bit per block since the last change, set when it was over budget, newest lowest
+  std::uint32_t over_budget_history_ = 0;
+
+  void set_level(int level)
+  {
+    level = std::clamp(level, 0, max_level);
+    telemetry_.level = level;
+
+    const float cap_scale = std::pow(cap_step, static_cast<float>(level));
+    telemetry_.min_event_point_magnitude =
+      config_.minEventPointMagnitude * std::pow(magnitude_step, static_cast<float>(level));
+    telemetry_.max_event_points =
+      std::max(1, static_cast<int>(std::lround(config_.maxEventPoints * cap_scale)));
+    telemetry_.max_fingerprints = std::max<std::size_t>(
+      1, static_cast<std::size_t>(std::lround(config_.maxFingerprints * cap_scale)));
+
+    low_load_blocks_ = 0;
+    settled_blocks_ = 0;
+    over_budget_history_ = 0;
+  }
+
+public:
+  /**
+   * @brief The time between two analysis blocks, audioStepSize / audioSampleRate
+   */
+  static float step_period_us(const Config & config)
+  {
+    return 1e6f * config.audioStepSize / config.audioSampleRate;
+  }
+
+  /**
+   * @brief Create a controller
+   * @param config The configuration, level 0 uses its limits
+   * @param budget_us Processing time available per block, 0 uses the step period
+   * (8 ms at 128 samples and 16 kHz). Leave room for the rest of the system.
+   */
+  explicit LoadController(const Config & config, float budget_us = 0) : config_(config)
+  {
+    telemetry_.budget_us = budget_us > 0 ? budget_us : step_period_us(config);
+    set_level(0);
+  }
+
+  /**
+   * @brief Account for one processed block
+   * @param block_us Time spent on the block: FFT, extraction and matching
+   * @return true when the limits changed and should be applied
+   */
+  bool update(float block_us)
+  {
+    LoadTelemetry & t = telemetry_;
+    t.blocks++;
+    // from 0, so a slow first block, e.g. with cold caches, does not dominate the average
+    t.average_us += (block_us - t.average_us) * average_weight;
+    t.worst_us = std::max(t.worst_us, block_us);
+    settled_blocks_++;
+
+    const bool over = block_us > t.budget_us;
+    if (over) {
+      t.over_budget++;
+    }
+    constexpr std::uint32_t window_mask = (1u << settle_blocks) - 1;
+    over_budget_history_ = (over_budget_history_ << 1 | (over ? 1u : 0u)) & window_mask;
+
+    // repeated blocks over budget once the last change had time to show, a high average once
+    // the average had time to follow
+    if (
+      t.level < max_level &&
+      ((settled_blocks_ >= settle_blocks &&
+        std::popcount(over_budget_history_) >= over_budget_blocks) ||
+       (settled_blocks_ >= 2 * settle_blocks && t.average_us > high_load * t.budget_us))) {
+      set_level(t.level + 1);
+      return true;
+    }
+
+    if (t.level > 0 && t.average_us < low_load * t.budget_us) {
+      if (++low_load_blocks_ >= relax_blocks) {
+        set_level(t.level - 1);
+        return true;
+      }
+    } else {
+      low_load_blocks_ = 0;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Apply the current limits to the extractors
+   */
+  template <typename Magnitude>
+  void apply(BasicEPExtractor<Magnitude> & ep_extractor, FPExtractor & fp_extractor) const
+  {
+    ep_extractor.set_min_event_point_magnitude(telemetry_.min_event_point_magnitude);
+    ep_extractor.set_max_event_points(telemetry_.max_event_points);
+    fp_extractor.set_max_fingerprints(telemetry_.max_fingerprints);
+  }
+
+  /**
+   * @brief Restart from the Config limits, e.g. when audio resumes after silence
+   */
+  void reset()
+  {
+    const float budget_us = telemetry_.budget_us;
+    telemetry_ = LoadTelemetry{};
+    telemetry_.budget_us = budget_us;
+    set_level(0);
+  }
+
+  /**
+   * @brief Change the processing time available per block, 0 uses the step period
+   */
+  void set_budget(float budget_us)
+  {
+    telemetry_.budget_us = budget_us > 0 ? budget_us : step_period_us(config_);
+  }
+
+  /**
+   * @brief Forget the worst block time, e.g. after it has been reported
+   */
+  void reset_worst() { telemetry_.worst_us = 0; }
+
+  int get_level() const { return telemetry_.level; }
+
+  const LoadTelemetry & get_telemetry() const { return telemetry_; }
+};
+
+}  // namespace olaf
+
+#endif  // OLAF_LOAD_CONTROLLER_HPP
@@ -0,0 +1,321 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_MATCH_VOTES_HPP
+#define OLAF_MATCH_VOTES_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+
+namespace olaf
+{
+
+/**
+ * @struct MatchResult
+ * @brief Represents a single match result
+ */
+struct MatchResult
+{
+  int reference_fingerprint_t1 = 0;
+  int query_fingerprint_t1 = 0;
+  int first_reference_fingerprint_t1 = 0;
+  int last_reference_fingerprint_t1 = 0;
+  int match_count = 0;
+  std::uint32_t match_identifier = 0;
+  std::uint64_t result_hash_table_key = 0;
+};
+
+/**
+ * @class MapVotes
+ * @brief Match candidates in a hash map keyed by (time offset bin << 32) | audio id
+ *
+ * Any number of audio files and offsets, one hash lookup per vote.
+ */
+class MapVotes
+{
+private:
+  std::pmr::unordered_map<std::uint64_t, MatchResult> matches_;
+
+public:
+  /**
+   * @param pool Resource for the map nodes, the matcher passes a pool so removed
+   * candidates are reused
+   */
+  MapVotes(
+    const Config &, const DB &, std::pmr::memory_resource *, std::pmr::memory_resource * pool)
+  : matches_(pool)
+  {
+  }
+
+  MatchResult * find(std::uint64_t key)
+  {
+    auto it = matches_.find(key);
+    return it != matches_.end() ? &it->second : nullptr;
+  }
+
+  const MatchResult * find(std::uint64_t key) const
+  {
+    auto it = matches_.find(key);
+    return it != matches_.end() ? &it->second : nullptr;
+  }
+
+  /**
+   * @brief Add a candidate whose key is not present yet
+   */
+  MatchResult & insert(const MatchResult & match)
+  {
+    return matches_[match.result_hash_table_key] = match;
+  }
+
+  template <typename Function>
+  void for_each(Function && function) const
+  {
+    for (const auto & pair : matches_) {
+      function(pair.second);
+    }
+  }
+
+  /**
+   * @brief Remove candidates without a vote in the last max_age blocks
+   * @return Whether any candidate was removed
+   */
+  bool expire(int current_query_time, int max_age)
+  {
+    bool removed = false;
+    auto it = matches_.begin();
+    while (it != matches_.end()) {
+      const int age = current_query_time - it->second.query_fingerprint_t1;
+      if (age > max_age) {
+        it = matches_.erase(it);
+        removed = true;
+      } else {
+        ++it;
+      }
+    }
+    return removed;
+  }
+
+  void clear() { matches_.clear(); }
+
+  /**
+   * @brief Whether insert() dropped a candidate since the last call, never for a map
+   */
+  bool take_evicted() { return false; }
+
+  std::size_t size() const { return matches_.size(); }
+};
+
+/**
+ * @class HistogramVotes
+ * @brief Match candidates in a dense histogram over time offset bins per audio file
+ *
+ * Meant for setlists of up to about 64 songs: every audio file find() searches
+ * when the matcher is created gets a ring of bins wide enough for all offsets
+ * seen within a window of query time. A bin holds the 16 bit index of its
+ * candidate in one contiguous array, so a vote is a binary search over the
+ * audio ids, a masked load and an update of a candidate that is likely in
+ * cache. The window is keepMatchesFor, or default_window seconds without
+ * expiry; a candidate older than the window is dropped when a new offset
+ * lands in its bin. Audio files registered or activated later, and
+ * candidates beyond max_candidates, are counted in a MapVotes.
+ */
+class HistogramVotes
+{
+private:
+  struct Song
+  {
+    std::uint32_t audio_id;
+    std::uint32_t first_bin;
+    std::uint32_t mask;
+  };
+
+  // sorted by audio id
+  std::pmr::vector<Song> songs_;
+  // index + 1 of the candidate of every bin, 0 for an empty bin
+  std::pmr::vector<std::uint16_t> bins_;
+  // the candidates and the bin each one is in
+  std::pmr::vector<MatchResult> candidates_;
+  std::pmr::vector<std::uint32_t> candidate_bins_;
+  MapVotes overflow_;
+  bool evicted_ = false;
+  // insert() follows a find() for the same audio id
+  const Song * last_song_ = nullptr;
+
+  const Song * song_of(std::uint32_t audio_id)
+  {
+    if (last_song_ != nullptr && last_song_->audio_id == audio_id) return last_song_;
+    auto it = std::lower_bound(
+      songs_.begin(), songs_.end(), audio_id,
+      [](const Song & song, std::uint32_t id) { return song.audio_id < id; });
+    if (it == songs_.end() || it->audio_id != audio_id) return nullptr;
+    last_song_ = &*it;
+    return last_song_;
+  }
+
+  static std::uint32_t bin_of(const Song & song, std::uint64_t key)
+  {
+    // the ring size is a power of two, negative offsets wrap around as well
+    return song.first_bin + (static_cast<std::uint32_t>(key >> 32) & song.mask);
+  }
+
+  void remove_candidate(std::size_t index)
+  {
+    bins_[candidate_bins_[index]] = 0;
+    if (index + 1 != candidates_.size()) {
+      candidates_[index] = candidates_.back();
+      candidate_bins_[index] = candidate_bins_.back();
+      bins_[candidate_bins_[index]] = static_cast<std::uint16_t>(index + 1);
+    }
+    candidates_.pop_back();
+    candidate_bins_.pop_back();
+  }
+
+public:
+  // window in seconds when config.keepMatchesFor is 0
+  static constexpr float default_window = 60.0f;
+  // candidates a 16 bit bin can refer to
+  static constexpr std::size_t max_candidates = 0xFFFF;
+
+  HistogramVotes(
+    const Config & config, const DB & db, std::pmr::memory_resource * resource,
+    std::pmr::memory_resource * pool)
+  : songs_(resource),
+    bins_(resource),
+    candidates_(resource),
+    candidate_bins_(resource),
+    overflow_(config, db, resource, pool)
+  {
+    const float window = config.keepMatchesFor > 0 ? config.keepMatchesFor : default_window;
+    // a candidate lives until its last vote is window old, seen at the end of a fingerprint
+    const int window_blocks =
+      static_cast<int>(window * config.audioSampleRate / config.audioStepSize) +
+      config.maxTimeDistance;
+
+    std::uint32_t total_bins = 0;
+    for (std::size_t i = 0; i < db.get_active_audio_count(); ++i) {
+      const AudioReference & ref = db.get_active_audio(i);
+      std::uint32_t max_t1 = 0;
+      for (const std::uint64_t packed : ref.fingerprints) {
+        max_t1 = std::max(max_t1, static_cast<std::uint32_t>(packed & 0xFFFF));
+      }
+      // offsets are quantized to 4 blocks, one bin of margin on both ends
+      const std::uint32_t needed = (max_t1 + window_blocks) / 4 + 2;
+      std::uint32_t bins = 1;
+      while (bins < needed) bins <<= 1;
+      songs_.push_back({ref.audio_id, total_bins, bins - 1});
+      total_bins += bins;
+    }
+    std::sort(songs_.begin(), songs_.end(), [](const Song & a, const Song & b) {
+      return a.audio_id < b.audio_id;
+    });
+
+    bins_.resize(total_bins);
+    candidates_.reserve(std::min<std::size_t>(config.maxResults * 16, max_candidates));
+    candidate_bins_.reserve(candidates_.capacity());
+  }
+
+  MatchResult * find(std::uint64_t key)
+  {
+    const Song * song = song_of(static_cast<std::uint32_t>(key));
+    if (song == nullptr) return overflow_.find(key);
+    const std::uint16_t slot = bins_[bin_of(*song, key)];
+    if (slot != 0 && candidates_[slot - 1].result_hash_table_key == key) {
+      return &candidates_[slot - 1];
+    }
+    return overflow_.size() > 0 ? overflow_.find(key) : nullptr;
+  }
+
+  const MatchResult * find(std::uint64_t key) const
+  {
+    return const_cast<HistogramVotes *>(this)->find(key);
+  }
+
+  /**
+   * @brief Add a candidate whose key is not present yet, replacing an older one in its bin
+   */
+  MatchResult & insert(const MatchResult & match)
+  {
+    const Song * song = song_of(match.match_identifier);
+    if (song == nullptr) return overflow_.insert(match);
+
+    const std::uint32_t bin = bin_of(*song, match.result_hash_table_key);
+    if (bins_[bin] != 0) {
+      remove_candidate(bins_[bin] - 1);
+      evicted_ = true;
+    } else if (candidates_.size() == max_candidates) {
+      return overflow_.insert(match);
+    }
+    candidates_.push_back(match);
+    candidate_bins_.push_back(bin);
+    bins_[bin] = static_cast<std::uint16_t>(candidates_.size());
+    return candidates_.back();
+  }
+
+  template <typename Function>
+  void for_each(Function && function) const
+  {
+    for (const MatchResult & match : candidates_) {
+      function(match);
+    }
+    overflow_.for_each(function);
+  }
+
+  bool expire(int current_query_time, int max_age)
+  {
+    bool removed = false;
+    // backwards, so the candidate moved into a removed slot was already checked
+    for (std::size_t i = candidates_.size(); i-- > 0;) {
+      if (current_query_time - candidates_[i].query_fingerprint_t1 > max_age) {
+        remove_candidate(i);
+        removed = true;
+      }
+    }
+    return overflow_.expire(current_query_time, max_age) || removed;
+  }
+
+  void clear()
+  {
+    for (const std::uint32_t bin : candidate_bins_) {
+      bins_[bin] = 0;
+    }
+    candidates_.clear();
+    candidate_bins_.clear();
+    overflow_.clear();
+    evicted_ = false;
+  }
+
+  /**
+   * @brief Whether insert() dropped a candidate older than the window since the last call
+   */
+  bool take_evicted()
+  {
+    const bool evicted = evicted_;
+    evicted_ = false;
+    return evicted;
+  }
+
+  std::size_t size() const { return candidates_.size() + overflow_.size(); }
+};
+
+}  // namespace olaf
+
+#endif  // OLAF_MATCH_VOTES_HPP
@@ -23,6 +23,7 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdio>
+#include <limits>
 #include <vector>
 
 namespace olaf
@@ -96,9 +97,14 @@ constexpr std::size_t van_herk_filter_width = 103;
 constexpr std::size_t naive_implementation_stop_bin = 82;
 /**
  * @brief A naive max filter implementation for reference.
+ *
+ * The filters are templates so the fixed-point extractor can filter integer
+ * magnitudes with the same code.
  */
+template <typename T, typename Allocator>
 inline void max_filter_naive(
-  const std::vector<float> & array, std::size_t filter_width, std::vector<float> & maxvalues)
+  const std::vector<T, Allocator> & array, std::size_t filter_width,
+  std::vector<T, Allocator> & maxvalues)
 {
   const std::size_t array_size = array.size();
   const std::size_t half_filter_width = filter_width / 2;
@@ -106,23 +112,35 @@ inline void max_filter_naive(
     const std::size_t start_index = (i >= half_filter_width) ? (i - half_filter_width) : 0;
     const std::size_t stop_index = std::min(i + half_filter_width + 1, array_size);
 
-    maxvalues[i] = -100000.0f;
+    maxvalues[i] = std::numeric_limits<T>::lowest();
     for (std::size_t j = start_index; j < stop_index; ++j) {
       maxvalues[i] = std::max(maxvalues[i], array[j]);
     }
   }
 }
 
+/**
+ * @struct MaxFilterScratch
+ * @brief Running maxima of the Van Herk filter, owned by the caller so filters are reentrant
+ */
+template <typename T>
+struct MaxFilterScratch
+{
+  std::array<T, van_herk_filter_width> R = {};
+  std::array<T, van_herk_filter_width> S = {};
+};
+
 /**
  * @brief Van Herk-Gil-Werman max filter implementation.
  * Based on https://github.com/lemire/runningmaxmin (LGPL)
  */
+template <typename T, typename Allocator>
 inline void max_filter_van_herk_gil_werman(
-  const std::vector<float> & array, std::size_t offset, std::size_t array_size,
-  std::vector<float> & maxvalues, std::size_t output_offset)
+  const std::vector<T, Allocator> & array, std::size_t offset, std::size_t array_size,
+  std::vector<T, Allocator> & maxvalues, std::size_t output_offset, MaxFilterScratch<T> & scratch)
 {
-  static std::array<float, van_herk_filter_width> R = {0.0f};
-  static std::array<float, van_herk_filter_width> S = {0.0f};
+  std::array<T, van_herk_filter_width> & R = scratch.R;
+  std::array<T, van_herk_filter_width> & S = scratch.S;
 
   for (std::size_t j = 0; j < array_size - van_herk_filter_width + 1; j += van_herk_filter_width) {
     const std::size_t Rpos = std::min(j + van_herk_filter_width - 1, array_size - 1);
@@ -148,8 +166,10 @@ inline void max_filter_van_herk_gil_werman(
 /**
  * @brief Perceptually-weighted max filter optimized for 512-sized arrays.
  */
+template <typename T, typename Allocator>
 inline void max_filter(
-  const std::vector<float> & array, std::size_t filter_width, std::vector<float> & maxvalues)
+  const std::vector<T, Allocator> & array, std::size_t filter_width,
+  std::vector<T, Allocator> & maxvalues, MaxFilterScratch<T> & scratch)
 {
   // filter_width is ignored; perceptual indices are used instead
   (void)filter_width;
@@ -166,7 +186,7 @@ inline void max_filter(
 
     assert(stop_index - start_index < van_herk_filter_width);
 
-    float max_value = -1000000.0f;
+    T max_value = std::numeric_limits<T>::lowest();
     for (std::size_t j = start_index; j < stop_index; ++j) {
       max_value = std::max(max_value, array[j]);
     }
@@ -179,7 +199,8 @@ inline void max_filter(
   const std::size_t input_offset = naive_implementation_stop_bin;
   const std::size_t to_filter_size = array_size - naive_implementation_stop_bin;
 
-  max_filter_van_herk_gil_werman(array, input_offset, to_filter_size, maxvalues, output_offset);
+  max_filter_van_herk_gil_werman(
+    array, input_offset, to_filter_size, maxvalues, output_offset, scratch);
 }
 
 }  // namespace olaf
@@ -0,0 +1,133 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_MEMORY_HPP
+#define OLAF_MEMORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+
+/**
+ * @file olaf_memory.hpp
+ * @brief Where olaf objects allocate
+ *
+ * Every olaf class with containers takes a std::pmr::memory_resource, the
+ * default resource (the global heap) when none is given. Passing an Arena
+ * carves the whole pipeline out of one buffer: a static array on the MCU, one
+ * arena per stream on the host. Olaf allocates while it is constructed; the
+ * matcher keeps allocating match candidates, from a pool on top of its
+ * resource, so freed candidates are reused instead of growing the arena.
+ */
+
+namespace olaf
+{
+
+/**
+ * @class Arena
+ * @brief Monotonic memory resource over a caller owned buffer
+ *
+ * Deallocation does nothing, memory is only returned by release(). used()
+ * after a representative run is the size the buffer needs. Running out of
+ * the buffer is fatal: olaf does not handle failed allocations.
+ */
+class Arena : public std::pmr::memory_resource
+{
+private:
+  std::byte * buffer_;
+  std::size_t capacity_;
+  std::size_t used_ = 0;
+  std::size_t allocations_ = 0;
+
+  void * do_allocate(std::size_t bytes, std::size_t alignment) override
+  {
+    const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(buffer_);
+    const std::uintptr_t aligned = (base + used_ + alignment - 1) & ~(alignment - 1);
+    const std::size_t start = aligned - base;
+    if (start > capacity_ || bytes > capacity_ - start) {
+      std::fprintf(
+        stderr, "Arena of %zu bytes exhausted: %zu bytes requested, %zu in use\n", capacity_,
+        bytes, used_);
+      std::abort();
+    }
+    used_ = start + bytes;
+    allocations_++;
+    return buffer_ + start;
+  }
+
+  void do_deallocate(void *, std::size_t, std::size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override
+  {
+    return this == &other;
+  }
+
+public:
+  Arena(void * buffer, std::size_t capacity)
+  : buffer_(static_cast<std::byte *>(buffer)), capacity_(capacity)
+  {
+  }
+
+  Arena(const Arena &) = delete;
+  Arena & operator=(const Arena &) = delete;
+
+  /**
+   * @brief Forget all allocations, only when nothing allocated from the arena is alive
+   */
+  void release()
+  {
+    used_ = 0;
+    allocations_ = 0;
+  }
+
+  std::size_t used() const { return used_; }
+  std::size_t capacity() const { return capacity_; }
+  std::size_t get_allocations() const { return allocations_; }
+};
+
+/**
+ * @brief Number of HeapGuard objects alive on this thread
+ */
+inline int & heap_guard_depth()
+{
+  thread_local int depth = 0;
+  return depth;
+}
+
+/**
+ * @class HeapGuard
+ * @brief Marks code that must not use the global heap, e.g. the audio path after init
+ *
+ * Only checked when olaf_heap_guard.cpp is linked in (OLAF_HEAP_GUARD), which
+ * replaces the global operator new: a heap allocation on a thread with a live
+ * guard prints its size and aborts, so a debugger stops at the offending call.
+ * Allocations from an Arena do not touch the heap and are allowed.
+ */
+class HeapGuard
+{
+public:
+  HeapGuard() { heap_guard_depth()++; }
+  ~HeapGuard() { heap_guard_depth()--; }
+
+  HeapGuard(const HeapGuard &) = delete;
+  HeapGuard & operator=(const HeapGuard &) = delete;
+};
+
+}  // namespace olaf
+
+#endif  // OLAF_MEMORY_HPP
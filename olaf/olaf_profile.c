@@ -0,0 +1,130 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/**
+ * @file olaf_profile.c
+ * @brief Statistics of the stage timings declared in olaf_profile.h.
+ */
+
+#include "olaf_profile.h"
+
+#include <string.h>
+
+struct stage_histogram {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+  uint32_t buckets[OLAF_PROFILE_BUCKETS];
+};
+
+static struct stage_histogram histograms[OLAF_STAGE_COUNT];
+
+static const char * const stage_names[OLAF_STAGE_COUNT] = {
+  "window", "fft", "magnitude", "max_filter", "extract_ep",
+  "extract_fp", "db_find", "tally", "block",
+};
+
+/* octave from the highest set bit, the quarter from the next two bits */
+static unsigned bucket_of(uint32_t ticks)
+{
+  if (ticks < 4) {
+    return ticks;
+  }
+  const unsigned octave = 31u - (unsigned)__builtin_clz(ticks);
+  const unsigned quarter = (ticks >> (octave - 2)) & 3u;
+  return octave * OLAF_PROFILE_BUCKETS_PER_OCTAVE + quarter;
+}
+
+/* largest value that falls in a bucket */
+static uint32_t bucket_upper(unsigned bucket)
+{
+  if (bucket < 4) {
+    return bucket;
+  }
+  const unsigned octave = bucket / OLAF_PROFILE_BUCKETS_PER_OCTAVE;
+  const unsigned quarter = bucket % OLAF_PROFILE_BUCKETS_PER_OCTAVE;
+  const uint64_t upper = ((uint64_t)(4 + quarter + 1) << (octave - 2)) - 1;
+  return upper > UINT32_MAX ? UINT32_MAX : (uint32_t)upper;
+}
+
+void olaf_profile_init(void)
+{
+#if OLAF_PROFILE_CYCLES
+  volatile uint32_t * const demcr = (volatile uint32_t *)0xE000EDFCu;
+  volatile uint32_t * const dwt_ctrl = (volatile uint32_t *)0xE0001000u;
+  volatile uint32_t * const dwt_cyccnt = (volatile uint32_t *)0xE0001004u;
+
+  *demcr |= 1u << 24; /* TRCENA */
+  *dwt_cyccnt = 0;
+  *dwt_ctrl |= 1u;    /* CYCCNTENA */
+#endif
+  olaf_profile_reset();
+}
+
+void olaf_profile_reset(void)
+{
+  memset(histograms, 0, sizeof(histograms));
+}
+
+void olaf_profile_record(enum olaf_profile_stage stage, uint32_t ticks)
+{
+  struct stage_histogram * h = &histograms[stage];
+
+  if (h->count == 0 || ticks < h->min) {
+    h->min = ticks;
+  }
+  if (ticks > h->max) {
+    h->max = ticks;
+  }
+  h->count++;
+  h->total += ticks;
+  h->buckets[bucket_of(ticks)]++;
+}
+
+bool olaf_profile_get(enum olaf_profile_stage stage, struct olaf_profile_stats * stats)
+{
+  const struct stage_histogram * h = &histograms[stage];
+
+  memset(stats, 0, sizeof(*stats));
+  if (h->count == 0) {
+    return false;
+  }
+
+  stats->count = h->count;
+  stats->min = h->min;
+  stats->max = h->max;
+  stats->total = h->total;
+  stats->avg = (uint32_t)(h->total / h->count);
+
+  /* the bucket where 1% of the measurements are at or above */
+  const uint32_t above = h->count / 100;
+  uint32_t seen = 0;
+  for (unsigned bucket = OLAF_PROFILE_BUCKETS; bucket-- > 0;) {
+    seen += h->buckets[bucket];
+    if (seen > above) {
+      const uint32_t upper = bucket_upper(bucket);
+      stats->p99 = upper < h->max ? upper : h->max;
+      break;
+    }
+  }
+  return true;
+}
+
+const char * olaf_profile_stage_name(enum olaf_profile_stage stage)
+{
+  return stage < OLAF_STAGE_COUNT ? stage_names[stage] : "?";
+}
@@ -0,0 +1,126 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_PROFILE_H
+#define OLAF_PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @file olaf_profile.h
+ * @brief Per stage timing of the audio path.
+ *
+ * Every stage keeps the call count, min, max, total and a histogram with four
+ * buckets per octave, from which the 99th percentile is read. On Cortex-M the
+ * ticks are DWT CYCCNT cycles, elsewhere CLOCK_MONOTONIC nanoseconds.
+ *
+ * Only when OLAF_PROFILE is defined do the OLAF_PROFILE_* macros measure
+ * anything; otherwise they expand to nothing and the audio path is unchanged.
+ * The statistics are not synchronised: record from one analysis thread.
+ */
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__) || \
+  defined(__ARM_ARCH_8_1M_MAIN__)
+#define OLAF_PROFILE_CYCLES 1
+#define OLAF_PROFILE_TICK_UNIT "cyc"
+#else
+#define OLAF_PROFILE_CYCLES 0
+#define OLAF_PROFILE_TICK_UNIT "ns"
+#include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum olaf_profile_stage {
+  OLAF_STAGE_WINDOW,      /* PCM to windowed FFT input */
+  OLAF_STAGE_FFT,         /* real FFT */
+  OLAF_STAGE_MAGNITUDE,   /* spectrum to magnitudes */
+  OLAF_STAGE_MAX_FILTER,  /* max filter over frequency */
+  OLAF_STAGE_EXTRACT_EP,  /* extract_internal, max over time and peak picking */
+  OLAF_STAGE_EXTRACT_FP,  /* FPExtractor::extract */
+  OLAF_STAGE_DB_FIND,     /* DB::find or DB::find_near, per fingerprint */
+  OLAF_STAGE_TALLY,       /* tally_results of all hits of a fingerprint */
+  OLAF_STAGE_BLOCK,       /* a whole analysis step */
+  OLAF_STAGE_COUNT
+};
+
+/* 4 buckets per octave up to 2^32 ticks */
+#define OLAF_PROFILE_BUCKETS_PER_OCTAVE 4
+#define OLAF_PROFILE_BUCKETS (32 * OLAF_PROFILE_BUCKETS_PER_OCTAVE)
+
+struct olaf_profile_stats {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint32_t avg;
+  uint32_t p99;   /* upper bound of the bucket holding the 99th percentile */
+  uint64_t total; /* total / blocks is the share of a stage in one step */
+};
+
+/**
+ * @brief Start the cycle counter (Cortex-M) and clear all statistics
+ */
+void olaf_profile_init(void);
+
+/**
+ * @brief Clear all statistics, e.g. after they have been reported
+ */
+void olaf_profile_reset(void);
+
+/**
+ * @brief Add one measurement to a stage
+ */
+void olaf_profile_record(enum olaf_profile_stage stage, uint32_t ticks);
+
+/**
+ * @brief Read the statistics of a stage
+ * @return false when the stage has no measurements
+ */
+bool olaf_profile_get(enum olaf_profile_stage stage, struct olaf_profile_stats * stats);
+
+const char * olaf_profile_stage_name(enum olaf_profile_stage stage);
+
+/**
+ * @brief Current time in ticks, wraps around
+ */
+static inline uint32_t olaf_profile_now(void)
+{
+#if OLAF_PROFILE_CYCLES
+  return *(volatile const uint32_t *)0xE0001004u; /* DWT->CYCCNT */
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#if defined(OLAF_PROFILE)
+#define OLAF_PROFILE_BEGIN(stage) const uint32_t olaf_profile_start_##stage = olaf_profile_now()
+#define OLAF_PROFILE_END(stage) \
+  olaf_profile_record(stage, olaf_profile_now() - olaf_profile_start_##stage)
+#else
+#define OLAF_PROFILE_BEGIN(stage) ((void)0)
+#define OLAF_PROFILE_END(stage) ((void)0)
+#endif
+
+#endif  // OLAF_PROFILE_H
@@ -0,0 +1,153 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_SPECTRUM_STREAM_HPP
+#define OLAF_SPECTRUM_STREAM_HPP
+
+#include <cstdint>
+#include <memory_resource>
+
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+#include "olaf_ep_extractor.hpp"
+#include "olaf_fp_extractor.hpp"
+#include "olaf_fp_matcher.hpp"
+#include "olaf_load_controller.hpp"
+
+namespace olaf
+{
+
+/**
+ * @class BasicSpectrumStream
+ * @brief Fingerprinting state of one audio stream after the FFT: extractors and matcher
+ *
+ * For callers that window and transform the audio themselves, e.g. the
+ * firmware's audio pipeline with its float FFT: every spectrum is one block
+ * of audioBlockSize samples, audioStepSize samples after the previous one.
+ * Magnitude is that of the extractor, float for arm_rfft_fast_f32 spectra,
+ * std::uint64_t for FixedPointRFFT<std::int32_t>. FingerprintStream puts its
+ * window and Q31 FFT in front of one.
+ */
+template <typename Magnitude>
+class BasicSpectrumStream
+{
+private:
+  BasicEPExtractor<Magnitude> ep_extractor_;
+  FPExtractor fp_extractor_;
+  FPMatcher matcher_;
+  LoadController load_controller_;
+  LoadClock load_clock_ = nullptr;
+  int audio_block_index_ = 0;
+
+public:
+  /**
+   * @param fraction_bits For integer magnitudes, see FixedPointRFFT::fraction_bits()
+   * @param resource Where all state of the stream is allocated, e.g. an Arena
+   */
+  BasicSpectrumStream(
+    const Config & config, const DB & db, MatchResultCallback callback, int fraction_bits = 0,
+    std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+  : ep_extractor_(config, fraction_bits, resource),
+    fp_extractor_(config, resource),
+    matcher_(config, db, std::move(callback), resource),
+    load_controller_(config)
+  {
+  }
+
+  /**
+   * @brief Start timing a block, before the window and FFT when the caller does them
+   * @return The start to pass to process()
+   */
+  std::uint32_t start_block() const { return load_clock_ != nullptr ? load_clock_() : 0; }
+
+  /**
+   * @brief Fingerprint and match the spectrum of the next block
+   * @param spectrum Interleaved re/im as the extractor expects it, see BasicEPExtractor::extract()
+   * @param start_us What start_block() returned for this block
+   */
+  template <typename Spectrum>
+  void process(const Spectrum * spectrum, std::uint32_t start_us)
+  {
+    ep_extractor_.extract(spectrum, audio_block_index_);
+    fp_extractor_.extract(ep_extractor_.event_points(), audio_block_index_);
+    matcher_.match(fp_extractor_.get_fingerprints());
+    audio_block_index_++;
+
+    if (
+      load_clock_ != nullptr &&
+      load_controller_.update(static_cast<float>(load_clock_() - start_us))) {
+      load_controller_.apply(ep_extractor_, fp_extractor_);
+    }
+  }
+
+  /**
+   * @brief Fingerprint and match the spectrum of the next block, timing only olaf's part
+   */
+  template <typename Spectrum>
+  void process(const Spectrum * spectrum)
+  {
+    process(spectrum, start_block());
+  }
+
+  /**
+   * @brief Adapt the extraction limits to the time the blocks take, see LoadController
+   * @param clock Times every block, nullptr stops load control
+   * @param budget_us Processing time available per block, 0 uses the step period
+   *
+   * Starts from the Config limits, and restores them when load control stops.
+   */
+  void set_load_control(LoadClock clock, float budget_us = 0)
+  {
+    load_clock_ = clock;
+    load_controller_.reset();
+    load_controller_.set_budget(budget_us);
+    load_controller_.apply(ep_extractor_, fp_extractor_);
+  }
+
+  /**
+   * @brief Forget the extraction and match state, e.g. when the stream restarts
+   *
+   * The load level is kept, it depends on the processor rather than the audio.
+   */
+  void reset()
+  {
+    audio_block_index_ = 0;
+    ep_extractor_.reset();
+    fp_extractor_.reset();
+    matcher_.reset();
+  }
+
+  FPMatcher & matcher() { return matcher_; }
+  const FPMatcher & matcher() const { return matcher_; }
+
+  const LoadTelemetry & get_load_telemetry() const { return load_controller_.get_telemetry(); }
+
+  int get_audio_block_index() const { return audio_block_index_; }
+};
+
+/**
+ * @brief Spectrum stream for float spectra, e.g. of arm_rfft_fast_f32
+ */
+using SpectrumStream = BasicSpectrumStream<float>;
+
+/**
+ * @brief Spectrum stream for spectra of FixedPointRFFT<std::int32_t>
+ */
+using SpectrumStreamQ31 = BasicSpectrumStream<std::uint64_t>;
+
+}  // namespace olaf
+
+#endif  // OLAF_SPECTRUM_STREAM_HPP
@@ -0,0 +1,155 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_STOP_LIST_HPP
+#define OLAF_STOP_LIST_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "olaf_config.hpp"
+
+namespace olaf
+{
+
+/**
+ * @struct StopListStats
+ * @brief Effect of a stop-list on the size of an index
+ */
+struct StopListStats
+{
+  std::size_t unique_hashes = 0;
+  std::size_t stopped_hashes = 0;
+  std::size_t fingerprints_before = 0;
+  std::size_t fingerprints_after = 0;
+
+  void print() const
+  {
+    const double kept =
+      fingerprints_before ? 100.0 * fingerprints_after / fingerprints_before : 100.0;
+    std::printf("Stop-list Statistics:\n");
+    std::printf("  Unique hashes: %zu\n", unique_hashes);
+    std::printf("  Stopped hashes: %zu\n", stopped_hashes);
+    std::printf(
+      "  Fingerprints: %zu -> %zu (%.2f%% kept, %zu bytes saved)\n", fingerprints_before,
+      fingerprints_after, kept, (fingerprints_before - fingerprints_after) * sizeof(std::uint64_t));
+  }
+};
+
+/**
+ * @class StopListBuilder
+ * @brief Index time detection of hashes that are too common to be informative
+ *
+ * Sustained tones and silence artefacts produce the same hash over and over. Those
+ * hashes cost a lot at query time (DB::find returns maxDBCollisions results) while
+ * adding little evidence. The builder counts how often every hash occurs in the whole
+ * catalog and lists the ones above a threshold, so they can be pruned from the
+ * fingerprint arrays or handed to DB::set_stop_list.
+ */
+class StopListBuilder
+{
+private:
+  std::unordered_map<std::uint64_t, std::uint32_t> counts_;
+  std::size_t total_fingerprints_ = 0;
+
+public:
+  /**
+     * @brief Count the hashes of one song
+     * @param fingerprints Packed fingerprints (hash << 16 | t1)
+     */
+  void add_song(std::span<const std::uint64_t> fingerprints)
+  {
+    for (const std::uint64_t packed : fingerprints) {
+      ++counts_[packed >> 16];
+    }
+    total_fingerprints_ += fingerprints.size();
+  }
+
+  std::size_t get_unique_hashes() const { return counts_.size(); }
+
+  std::size_t get_total_fingerprints() const { return total_fingerprints_; }
+
+  /**
+     * @brief List the hashes that occur more than max_occurrences times
+     * @return Sorted hashes, empty when max_occurrences is 0
+     */
+  std::vector<std::uint64_t> build(std::size_t max_occurrences) const
+  {
+    std::vector<std::uint64_t> stop_list;
+    if (max_occurrences == 0) return stop_list;
+
+    for (const auto & pair : counts_) {
+      if (pair.second > max_occurrences) {
+        stop_list.push_back(pair.first);
+      }
+    }
+    std::sort(stop_list.begin(), stop_list.end());
+    return stop_list;
+  }
+
+  std::vector<std::uint64_t> build(const Config & config) const
+  {
+    return build(config.maxHashOccurrences);
+  }
+
+  /**
+     * @brief Copy a sorted fingerprint array without the stopped hashes
+     * @param fingerprints Sorted packed fingerprints of one song
+     * @param stop_list Sorted stop-list as returned by build()
+     * @param pruned Output, stays sorted
+     * @return Number of removed fingerprints
+     */
+  static std::size_t prune(
+    std::span<const std::uint64_t> fingerprints, std::span<const std::uint64_t> stop_list,
+    std::vector<std::uint64_t> & pruned)
+  {
+    pruned.clear();
+    pruned.reserve(fingerprints.size());
+
+    // Both arrays are sorted by hash, walk them in lock step
+    auto stop_it = stop_list.begin();
+    for (const std::uint64_t packed : fingerprints) {
+      const std::uint64_t hash = packed >> 16;
+      while (stop_it != stop_list.end() && *stop_it < hash) ++stop_it;
+      if (stop_it != stop_list.end() && *stop_it == hash) continue;
+      pruned.push_back(packed);
+    }
+    return fingerprints.size() - pruned.size();
+  }
+
+  StopListStats get_stats(std::span<const std::uint64_t> stop_list) const
+  {
+    StopListStats stats;
+    stats.unique_hashes = counts_.size();
+    stats.stopped_hashes = stop_list.size();
+    stats.fingerprints_before = total_fingerprints_;
+    stats.fingerprints_after = total_fingerprints_;
+    for (const std::uint64_t hash : stop_list) {
+      auto it = counts_.find(hash);
+      if (it != counts_.end()) stats.fingerprints_after -= it->second;
+    }
+    return stats;
+  }
+};
+
+}  // namespace olaf
+
+#endif  // OLAF_STOP_LIST_HPP
@@ -0,0 +1,216 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_STREAM_POOL_HPP
+#define OLAF_STREAM_POOL_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "olaf_config.hpp"
+#include "olaf_db.hpp"
+#include "olaf_fingerprint_stream.hpp"
+#include "olaf_memory.hpp"
+
+namespace olaf
+{
+
+/**
+ * @class StreamPool
+ * @brief Fingerprints many audio streams against one shared, read only DB on a thread pool
+ *
+ * push() queues audio for a stream and schedules the stream when it is not
+ * scheduled yet. A worker takes all audio queued for the stream and
+ * processes it, so every stream is handled by one worker at a time and in
+ * order, while different streams run in parallel. The DB must not change
+ * while the pool runs.
+ *
+ * With arenas every stream allocates from its own Arena rather than from a
+ * per thread one, as a stream moves between workers.
+ */
+class StreamPool
+{
+private:
+  struct Slot
+  {
+    std::unique_ptr<std::byte[]> arena_buffer;
+    std::unique_ptr<Arena> arena;
+    std::unique_ptr<FingerprintStream> stream;
+    std::vector<std::int16_t> queued;
+    std::vector<std::int16_t> processing;
+    bool scheduled = false;
+  };
+
+  const Config & config_;
+  const DB & db_;
+  std::size_t arena_bytes_;
+  std::deque<Slot> slots_;
+  std::deque<std::size_t> ready_;
+  std::size_t busy_ = 0;
+  bool stopping_ = false;
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable idle_;
+  std::vector<std::thread> workers_;
+
+  void work()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      work_available_.wait(lock, [this] { return stopping_ || !ready_.empty(); });
+      if (ready_.empty()) {
+        return;
+      }
+
+      const std::size_t index = ready_.front();
+      ready_.pop_front();
+      Slot & slot = slots_[index];
+      slot.processing.swap(slot.queued);
+      busy_++;
+
+      lock.unlock();
+      if (slot.arena) {
+        HeapGuard guard;
+        slot.stream->process(slot.processing.data(), slot.processing.size());
+      } else {
+        slot.stream->process(slot.processing.data(), slot.processing.size());
+      }
+      slot.processing.clear();
+      lock.lock();
+
+      busy_--;
+      if (slot.queued.empty()) {
+        slot.scheduled = false;
+      } else {
+        ready_.push_back(index);
+        work_available_.notify_one();
+      }
+      if (busy_ == 0 && ready_.empty()) {
+        idle_.notify_all();
+      }
+    }
+  }
+
+public:
+  /**
+   * @param config Configuration of every stream
+   * @param db Database shared by all streams
+   * @param threads Number of workers, 0 uses one per hardware thread
+   * @param arena_bytes Size of the Arena of every stream, 0 allocates from the heap. Processing
+   * then runs inside a HeapGuard, so match callbacks must not allocate either.
+   */
+  StreamPool(
+    const Config & config, const DB & db, std::size_t threads = 0, std::size_t arena_bytes = 0)
+  : config_(config), db_(db), arena_bytes_(arena_bytes)
+  {
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+      workers_.emplace_back(&StreamPool::work, this);
+    }
+  }
+
+  StreamPool(const StreamPool &) = delete;
+  StreamPool & operator=(const StreamPool &) = delete;
+
+  ~StreamPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    work_available_.notify_all();
+    for (auto & worker : workers_) {
+      worker.join();
+    }
+  }
+
+  /**
+   * @brief Add a stream
+   * @param callback Called from a worker thread for the matches of this stream
+   * @return Index of the stream for push()
+   */
+  std::size_t add_stream(MatchResultCallback callback)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot & slot = slots_.emplace_back();
+    std::pmr::memory_resource * resource = std::pmr::get_default_resource();
+    if (arena_bytes_ > 0) {
+      slot.arena_buffer = std::make_unique<std::byte[]>(arena_bytes_);
+      slot.arena = std::make_unique<Arena>(slot.arena_buffer.get(), arena_bytes_);
+      resource = slot.arena.get();
+    }
+    slot.stream =
+      std::make_unique<FingerprintStream>(config_, db_, std::move(callback), resource);
+    slot.queued.reserve(config_.audioBlockSize);
+    return slots_.size() - 1;
+  }
+
+  /**
+   * @brief Queue audio of a stream for processing
+   */
+  void push(std::size_t stream, const std::int16_t * samples, std::size_t count)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot & slot = slots_[stream];
+    slot.queued.insert(slot.queued.end(), samples, samples + count);
+    if (!slot.scheduled) {
+      slot.scheduled = true;
+      ready_.push_back(stream);
+      work_available_.notify_one();
+    }
+  }
+
+  /**
+   * @brief Block until all queued audio is processed
+   */
+  void wait_idle()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return busy_ == 0 && ready_.empty(); });
+  }
+
+  /**
+   * @brief Access a stream, only safe while the pool is idle
+   */
+  FingerprintStream & get_stream(std::size_t stream) { return *slots_[stream].stream; }
+
+  /**
+   * @brief Bytes of its arena a stream uses, 0 without arenas; only safe while the pool is idle
+   */
+  std::size_t get_arena_used(std::size_t stream) const
+  {
+    return slots_[stream].arena ? slots_[stream].arena->used() : 0;
+  }
+
+  std::size_t get_stream_count() const { return slots_.size(); }
+
+  std::size_t get_thread_count() const { return workers_.size(); }
+};
+
+}  // namespace olaf
+
+#endif  // OLAF_STREAM_POOL_HPP
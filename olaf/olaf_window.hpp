@@ -0,0 +1,242 @@
+// Olaf: Overly Lightweight Acoustic Fingerprinting
+// Copyright (C) 2019-2025  Joren Six
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Affero General Public License for more details.
+
+// You should have received a copy of the GNU Affero General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef OLAF_WINDOW_HPP
+#define OLAF_WINDOW_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(OLAF_USE_CMSIS_DSP)
+#include <arm_math.h>
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace olaf
+{
+
+/**
+ * @brief Window functions that can be generated at compile time
+ */
+enum class WindowType { hamming, hann };
+
+namespace detail
+{
+
+/**
+ * @brief Cosine usable in constant expressions, accurate to double precision
+ */
+constexpr double constexpr_cos(double x)
+{
+  constexpr double pi = 3.14159265358979323846;
+  constexpr double two_pi = 2.0 * pi;
+
+  x -= two_pi * static_cast<double>(static_cast<long long>(x / two_pi));
+  if (x > pi) x -= two_pi;
+  if (x < -pi) x += two_pi;
+
+  double term = 1.0;
+  double sum = 1.0;
+  for (int i = 1; i < 30; ++i) {
+    term *= -x * x / static_cast<double>((2 * i - 1) * (2 * i));
+    sum += term;
+  }
+  return sum;
+}
+
+}  // namespace detail
+
+/**
+ * @brief Generate a symmetric window, identical to Numpy's signal.windows.hamming(N)
+ * or signal.windows.hann(N)
+ */
+template <std::size_t N>
+constexpr std::array<float, N> make_window(WindowType type)
+{
+  static_assert(N > 1, "A window needs at least two samples");
+  constexpr double two_pi = 2.0 * 3.14159265358979323846;
+
+  std::array<float, N> window = {};
+  for (std::size_t n = 0; n < N; ++n) {
+    const double c = detail::constexpr_cos(two_pi * static_cast<double>(n) / (N - 1));
+    window[n] = static_cast<float>(type == WindowType::hamming ? 0.54 - 0.46 * c : 0.5 - 0.5 * c);
+  }
+  return window;
+}
+
+/**
+ * @brief Hamming window of N samples, generated at compile time and stored once
+ */
+template <std::size_t N>
+inline constexpr std::array<float, N> hamming_window = make_window<N>(WindowType::hamming);
+
+/**
+ * @brief Hann window of N samples, generated at compile time and stored once
+ */
+template <std::size_t N>
+inline constexpr std::array<float, N> hann_window = make_window<N>(WindowType::hann);
+
+/**
+ * @brief Return the Hamming window for an audio block size known only at run time
+ *
+ * Only the sizes used here are instantiated, see hamming_window for any other size.
+ * @return The window or nullptr when the size is not supported
+ */
+inline const float * fft_window(int audio_block_size)
+{
+  switch (audio_block_size) {
+    case 256:
+      return hamming_window<256>.data();
+    case 512:
+      return hamming_window<512>.data();
+    case 1024:
+      return hamming_window<1024>.data();
+    case 2048:
+      return hamming_window<2048>.data();
+    default:
+      std::fprintf(stderr, "Window of size %d not supported.\n", audio_block_size);
+      return nullptr;
+  }
+}
+
+/**
+ * @brief Convert 16 bit PCM, apply a window and write the FFT input in one pass
+ * @param pcm Input samples
+ * @param window Window of n samples
+ * @param out FFT input, may not alias pcm
+ * @param n Number of samples
+ */
+inline void apply_window(
+  const std::int16_t * pcm, const float * window, float * out, std::size_t n)
+{
+  constexpr float scale = 1.0f / 32768.0f;
+  std::size_t i = 0;
+
+#if defined(__AVX2__)
+  const __m256 vscale = _mm256_set1_ps(scale);
+  for (; i + 8 <= n; i += 8) {
+    const __m128i s16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pcm + i));
+    const __m256 s = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(s16));
+    const __m256 w = _mm256_mul_ps(_mm256_loadu_ps(window + i), vscale);
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(s, w));
+  }
+#elif defined(__SSE2__)
+  const __m128 vscale = _mm_set1_ps(scale);
+  for (; i + 8 <= n; i += 8) {
+    const __m128i s16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pcm + i));
+    // Sign extend by placing each sample in the upper half and shifting back
+    const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
+    const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16);
+    const __m128 w_lo = _mm_mul_ps(_mm_loadu_ps(window + i), vscale);
+    const __m128 w_hi = _mm_mul_ps(_mm_loadu_ps(window + i + 4), vscale);
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), w_lo));
+    _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), w_hi));
+  }
+#elif defined(__ARM_NEON)
+  const float32x4_t vscale = vdupq_n_f32(scale);
+  for (; i + 8 <= n; i += 8) {
+    const int16x8_t s16 = vld1q_s16(pcm + i);
+    const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s16)));
+    const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s16)));
+    vst1q_f32(out + i, vmulq_f32(lo, vmulq_f32(vld1q_f32(window + i), vscale)));
+    vst1q_f32(out + i + 4, vmulq_f32(hi, vmulq_f32(vld1q_f32(window + i + 4), vscale)));
+  }
+#endif
+
+  for (; i < n; ++i) {
+    out[i] = static_cast<float>(pcm[i]) * scale * window[i];
+  }
+}
+
+/**
+ * @brief Convert 32 bit PCM, apply a window and write the FFT input in one pass
+ */
+inline void apply_window(
+  const std::int32_t * pcm, const float * window, float * out, std::size_t n)
+{
+  constexpr float scale = 1.0f / 2147483648.0f;
+  std::size_t i = 0;
+
+#if defined(__AVX2__)
+  const __m256 vscale = _mm256_set1_ps(scale);
+  for (; i + 8 <= n; i += 8) {
+    const __m256i s32 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pcm + i));
+    const __m256 w = _mm256_mul_ps(_mm256_loadu_ps(window + i), vscale);
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(s32), w));
+  }
+#elif defined(__SSE2__)
+  const __m128 vscale = _mm_set1_ps(scale);
+  for (; i + 4 <= n; i += 4) {
+    const __m128i s32 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pcm + i));
+    const __m128 w = _mm_mul_ps(_mm_loadu_ps(window + i), vscale);
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(s32), w));
+  }
+#elif defined(__ARM_NEON)
+  const float32x4_t vscale = vdupq_n_f32(scale);
+  for (; i + 4 <= n; i += 4) {
+    const float32x4_t s = vcvtq_f32_s32(vld1q_s32(pcm + i));
+    vst1q_f32(out + i, vmulq_f32(s, vmulq_f32(vld1q_f32(window + i), vscale)));
+  }
+#endif
+
+  for (; i < n; ++i) {
+    out[i] = static_cast<float>(pcm[i]) * scale * window[i];
+  }
+}
+
+/**
+ * @brief Apply a window to float samples, writing the FFT input
+ *
+ * With CMSIS-DSP this is arm_mult_f32, otherwise a vectorized multiply.
+ */
+inline void apply_window(const float * samples, const float * window, float * out, std::size_t n)
+{
+#if defined(OLAF_USE_CMSIS_DSP)
+  arm_mult_f32(samples, window, out, static_cast<std::uint32_t>(n));
+#else
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(
+      out + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), _mm256_loadu_ps(window + i)));
+  }
+#elif defined(__SSE2__)
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(window + i)));
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(out + i, vmulq_f32(vld1q_f32(samples + i), vld1q_f32(window + i)));
+  }
+#endif
+  for (; i < n; ++i) {
+    out[i] = samples[i] * window[i];
+  }
+#endif
+}
+
+}  // namespace olaf
+
+#endif  // OLAF_WINDOW_HPP
@@ -0,0 +1,109 @@
+/*
+ * Audio Decimator - 取り込みレートからolafのレート (16kHz) へのダウンサンプリング
+ */
+
+#include "audio_decimator.h"
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#define DECIMATOR_PI 3.14159265358979f
+
+static int16_t saturate_q15(int32_t value)
+{
+  if (value > INT16_MAX) {
+    return INT16_MAX;
+  }
+  if (value < INT16_MIN) {
+    return INT16_MIN;
+  }
+  return (int16_t)value;
+}
+
+/*
+ * ハミング窓付きsincのローパス (-6dB点は出力ナイキストの90%)
+ * 対称なのでCMSISが要求する時間反転順と同じ。DCゲイン1に正規化してQ15へ。
+ */
+static void design_filter(int16_t * coeffs, int factor)
+{
+  const int length = factor * AUDIO_DECIMATOR_TAPS_PER_PHASE;
+  const float cutoff = 0.9f * 0.5f / (float)factor;
+  const float center = (float)(length - 1) / 2.0f;
+  float taps[AUDIO_DECIMATOR_MAX_TAPS];
+  float sum = 0.0f;
+
+  for (int i = 0; i < length; i++) {
+    float x = (float)i - center;
+    float sinc = (x == 0.0f) ? 2.0f * cutoff
+                             : sinf(2.0f * DECIMATOR_PI * cutoff * x) / (DECIMATOR_PI * x);
+    float window = 0.54f - 0.46f * cosf(2.0f * DECIMATOR_PI * (float)i / (float)(length - 1));
+    taps[i] = sinc * window;
+    sum += taps[i];
+  }
+
+  for (int i = 0; i < length; i++) {
+    float scaled = taps[i] / sum * 32768.0f;
+    coeffs[i] = saturate_q15((int32_t)lrintf(scaled));
+  }
+}
+
+int audio_decimator_init(struct audio_decimator * dec, int factor, int16_t * state,
+                         size_t block_size)
+{
+  if (factor < 2 || factor > AUDIO_DECIMATOR_MAX_FACTOR || block_size % factor != 0) {
+    return -EINVAL;
+  }
+
+  dec->factor = factor;
+  dec->block_size = block_size;
+  dec->state = state;
+  design_filter(dec->coeffs, factor);
+
+#if defined(CONFIG_CMSIS_DSP_FILTERING)
+  if (arm_fir_decimate_init_q15(&dec->fir, factor * AUDIO_DECIMATOR_TAPS_PER_PHASE, factor,
+                                dec->coeffs, dec->state, block_size) != ARM_MATH_SUCCESS) {
+    return -EINVAL;
+  }
+#else
+  audio_decimator_reset(dec);
+#endif
+  return 0;
+}
+
+void audio_decimator_process(struct audio_decimator * dec, const int16_t * in, int16_t * out)
+{
+#if defined(CONFIG_CMSIS_DSP_FILTERING)
+  /*
+   * M33はDSP拡張 (SMLAD) があるので32bit累算の高速版を使う。
+   * 係数の絶対値和は約1.1なので2.30形式の累算はあふれない
+   */
+  arm_fir_decimate_fast_q15(&dec->fir, in, out, dec->block_size);
+#else
+  /*
+   * 高速版と同じ計算: 履歴の後ろに新しいブロックを置き、出力ごとに
+   * フィルタ長の連続した区間と係数の積和 (ホストではコンパイラがSIMD化する)
+   */
+  const size_t length = (size_t)dec->factor * AUDIO_DECIMATOR_TAPS_PER_PHASE;
+  const size_t outputs = dec->block_size / dec->factor;
+  const int16_t * coeffs = dec->coeffs;
+  int16_t * state = dec->state;
+
+  memcpy(state + length - 1, in, dec->block_size * sizeof(int16_t));
+  for (size_t i = 0; i < outputs; i++) {
+    const int16_t * x = state + i * dec->factor + dec->factor - 1;
+    int32_t acc = 0;
+    for (size_t k = 0; k < length; k++) {
+      acc += (int32_t)coeffs[k] * x[k];
+    }
+    out[i] = saturate_q15(acc >> 15);
+  }
+  memmove(state, state + dec->block_size, (length - 1) * sizeof(int16_t));
+#endif
+}
+
+void audio_decimator_reset(struct audio_decimator * dec)
+{
+  size_t length = dec->factor * AUDIO_DECIMATOR_TAPS_PER_PHASE + dec->block_size - 1;
+  memset(dec->state, 0, length * sizeof(int16_t));
+}
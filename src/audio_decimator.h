@@ -0,0 +1,82 @@
+/*
+ * Audio Decimator - 取り込みレートからolafのレート (16kHz) へのダウンサンプリング
+ *
+ * 窓付きsincのローパスFIR + 間引き。係数は初期化時にQ15で設計し、
+ * 状態バッファは呼び出し側が静的に確保するので、処理中のメモリ確保はない。
+ * CONFIG_CMSIS_DSP_FILTERING があれば arm_fir_decimate_fast_q15、なければ同じ計算
+ * (Q15係数, 32bit累算) のCループを使う。
+ *
+ * Zephyrに依存しない (ホストのテスト host/check_decimator.cpp と
+ * ホストツールのリサンプルでも使う)。
+ */
+
+#ifndef AUDIO_DECIMATOR_H
+#define AUDIO_DECIMATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(CONFIG_CMSIS_DSP_FILTERING)
+#include <arm_math.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 位相あたりのタップ数 (フィルタ長 = 間引き率 * これ) */
+#define AUDIO_DECIMATOR_TAPS_PER_PHASE 16
+
+/* 対応する最大の間引き率 (48kHz -> 16kHz) */
+#define AUDIO_DECIMATOR_MAX_FACTOR 3
+
+#define AUDIO_DECIMATOR_MAX_TAPS (AUDIO_DECIMATOR_TAPS_PER_PHASE * AUDIO_DECIMATOR_MAX_FACTOR)
+
+struct audio_decimator
+{
+#if defined(CONFIG_CMSIS_DSP_FILTERING)
+  arm_fir_decimate_instance_q15 fir;
+#endif
+  int factor;
+  size_t block_size; /* 1回に処理する入力サンプル数 */
+  int16_t coeffs[AUDIO_DECIMATOR_MAX_TAPS];
+  int16_t * state;   /* フィルタ長 - 1 サンプルの履歴 + block_size サンプル */
+};
+
+/* 入力ブロック長 block_size 用の状態バッファの長さ */
+#define AUDIO_DECIMATOR_STATE_LENGTH(block_size) (AUDIO_DECIMATOR_MAX_TAPS + (block_size) - 1)
+
+/* 入力ブロック長 block_size 用の状態バッファを静的に確保 */
+#define AUDIO_DECIMATOR_STATE_DEFINE(name, block_size) \
+  static _Alignas(4) int16_t name[AUDIO_DECIMATOR_STATE_LENGTH(block_size)]
+
+/**
+ * @brief 間引きフィルタを初期化
+ * @param dec 対象
+ * @param factor 間引き率 (2..AUDIO_DECIMATOR_MAX_FACTOR)
+ * @param state AUDIO_DECIMATOR_STATE_LENGTH(block_size) サンプルのバッファ
+ * @param block_size 入力ブロック長 (factorの倍数)
+ * @return 0: 成功, -EINVAL: 引数エラー
+ */
+int audio_decimator_init(struct audio_decimator * dec, int factor, int16_t * state,
+                         size_t block_size);
+
+/**
+ * @brief 1ブロックを間引く
+ * y[i] = sum_k coeffs[k] * x[i * factor + factor - 1 - k] (Q15, 飽和)
+ * @param dec 対象
+ * @param in block_size サンプル (取り込みレート)
+ * @param out block_size / factor サンプル (olafのレート)
+ */
+void audio_decimator_process(struct audio_decimator * dec, const int16_t * in, int16_t * out);
+
+/**
+ * @brief フィルタ状態を破棄 (取り込み再開時)
+ */
+void audio_decimator_reset(struct audio_decimator * dec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AUDIO_DECIMATOR_H */
@@ -0,0 +1,58 @@
+/*
+ * Audio Gate - 時間領域のエネルギーによる無音判定
+ */
+
+#include "audio_gate.h"
+
+#include <arm_math.h>
+#include <math.h>
+
+/* dBFS (RMS) -> 16bit PCMの平均二乗振幅 */
+static uint64_t dbfs_to_level(int dbfs)
+{
+  float rms = 32768.0f * powf(10.0f, (float)dbfs / 20.0f);
+  return (uint64_t)(rms * rms);
+}
+
+void audio_gate_init(struct audio_gate * gate, int open_dbfs, int close_dbfs, uint32_t hold_blocks)
+{
+  gate->open_level = dbfs_to_level(open_dbfs);
+  gate->close_level = dbfs_to_level(close_dbfs < open_dbfs ? close_dbfs : open_dbfs);
+  gate->hold_blocks = hold_blocks;
+  audio_gate_reset(gate);
+}
+
+void audio_gate_reset(struct audio_gate * gate)
+{
+  gate->quiet_blocks = 0;
+  gate->open = false;
+}
+
+bool audio_gate_update(struct audio_gate * gate, const int16_t * samples, size_t count)
+{
+  /* 二乗和 (SIMD命令で1サンプルあたり約1サイクル) */
+  q63_t sum_squares;
+  arm_power_q15(samples, count, &sum_squares);
+  uint64_t level = (uint64_t)sum_squares / count;
+
+  if (!gate->open) {
+    if (level >= gate->open_level) {
+      gate->open = true;
+      gate->quiet_blocks = 0;
+      return true;
+    }
+    return false;
+  }
+
+  if (level >= gate->close_level) {
+    gate->quiet_blocks = 0;
+    return false;
+  }
+
+  if (++gate->quiet_blocks < gate->hold_blocks) {
+    return false;
+  }
+
+  gate->open = false;
+  return true;
+}
@@ -0,0 +1,53 @@
+/*
+ * Audio Gate - 時間領域のエネルギーによる無音判定
+ *
+ * 解析ステップごとの平均二乗振幅を閾値と比較し、FFT以降の処理を行うか決める。
+ * 開く閾値と閉じる閾値を分け (ヒステリシス)、閉じる閾値を下回っても
+ * hold_blocks ブロックの間は開いたままにすることで、音の切れ目でばたつかない。
+ */
+
+#ifndef AUDIO_GATE_H
+#define AUDIO_GATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct audio_gate
+{
+  uint64_t open_level;   /* この平均二乗振幅以上で開く */
+  uint64_t close_level;  /* この平均二乗振幅未満が続くと閉じる */
+  uint32_t hold_blocks;  /* 閉じるまでに必要な連続ブロック数 */
+  uint32_t quiet_blocks; /* close_level未満の連続ブロック数 */
+  bool open;
+};
+
+/**
+ * @brief ゲートを初期化 (閉じた状態)
+ * @param gate 対象
+ * @param open_dbfs 開く閾値 (RMSのdBFS)
+ * @param close_dbfs 閉じる閾値 (RMSのdBFS, open_dbfs以下)
+ * @param hold_blocks 閉じるまでのブロック数
+ */
+void audio_gate_init(struct audio_gate * gate, int open_dbfs, int close_dbfs, uint32_t hold_blocks);
+
+/**
+ * @brief 1ブロック分のサンプルで状態を更新
+ * @param gate 対象
+ * @param samples 新しいサンプル
+ * @param count サンプル数
+ * @return true: 開閉状態が変化した
+ */
+bool audio_gate_update(struct audio_gate * gate, const int16_t * samples, size_t count);
+
+/**
+ * @brief ゲートを閉じた状態に戻す
+ */
+void audio_gate_reset(struct audio_gate * gate);
+
+/**
+ * @brief ゲートが開いているか (FFT以降を実行すべきか)
+ */
+static inline bool audio_gate_is_open(const struct audio_gate * gate) { return gate->open; }
+
+#endif /* AUDIO_GATE_H */
@@ -0,0 +1,115 @@
+/*
+ * Audio Match - マイク音声を参照曲と照合する
+ */
+
+#include "audio_match.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "audio_pipeline.h"
+#include "olaf_fp_ref_mem.h"
+
+LOG_MODULE_REGISTER(audio_match, LOG_LEVEL_INF);
+
+static const struct olaf_reference references[] = {
+  {AUDIO_MATCH_REFERENCE_ID, olaf_db_mem_fps, ARRAY_SIZE(olaf_db_mem_fps)},
+};
+
+/* olafのストリーム, 参照の索引, 照合候補をすべてここに置く */
+static uint8_t stream_buffer[CONFIG_APP_AUDIO_MATCH_BUFFER_SIZE] __aligned(8);
+
+static struct olaf_stream * stream;
+static audio_match_callback_t match_callback;
+/* ログに出した照合中の音声ID, 0: なし */
+static uint32_t reported_id;
+/* ログに出した負荷レベル */
+static int reported_load_level;
+
+/* olafの負荷制御が1ブロックの処理時間を測る時計 (マイクロ秒, 折り返しあり) */
+static uint32_t clock_us(void)
+{
+#if defined(CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER)
+  return (uint32_t)k_cyc_to_us_floor64(k_cycle_get_64());
+#else
+  return (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+#endif
+}
+
+/* 解析スレッド: パイプラインが窓掛けとFFTを済ませた1ステップ分のスペクトルを照合 */
+static void on_spectrum(const float * spectrum, int block_index)
+{
+  ARG_UNUSED(block_index);
+  struct olaf_match_state match;
+  struct olaf_load_state load;
+
+  olaf_stream_push_spectrum(stream, spectrum);
+  olaf_stream_poll(stream, &match);
+
+  /* 処理が間に合わない間はイベントポイントとフィンガープリントを減らしている */
+  olaf_stream_poll_load(stream, &load);
+  if (load.level != reported_load_level) {
+    reported_load_level = load.level;
+    LOG_INF("Load level %d: max %d event points, %u fingerprints, %d/%d us per block",
+            load.level, load.max_event_points, (unsigned int)load.max_fingerprints,
+            (int)load.average_us, (int)load.budget_us);
+  }
+
+  uint32_t id = match.matched ? match.audio_id : 0;
+  if (id != reported_id) {
+    reported_id = id;
+    if (id != 0) {
+      LOG_INF("Matched audio %u at %d ms (%d votes), buffer %u bytes in use", id,
+              (int)(match.reference_time * 1000.0f), match.match_count,
+              (unsigned int)olaf_stream_memory_used(stream));
+    } else {
+      LOG_INF("Match lost");
+    }
+  }
+
+  if (match_callback) {
+    match_callback(&match);
+  }
+}
+
+/* 無音の間は音声が途切れるので、照合は最初からやり直す */
+static void on_gate(bool open, int block_index)
+{
+  ARG_UNUSED(block_index);
+
+  if (!open) {
+    olaf_stream_reset(stream);
+    reported_id = 0;
+  }
+}
+
+int audio_match_init(void)
+{
+  if (olaf_config_sample_rate(OLAF_CONFIG_MEM_TRACKING) != AUDIO_SAMPLE_RATE ||
+      olaf_config_block_size(OLAF_CONFIG_MEM_TRACKING) != AUDIO_FFT_SIZE ||
+      olaf_config_step_size(OLAF_CONFIG_MEM_TRACKING) != AUDIO_STEP_SIZE) {
+    LOG_ERR("olaf profile differs from %d Hz, FFT %d, step %d", AUDIO_SAMPLE_RATE,
+            AUDIO_FFT_SIZE, AUDIO_STEP_SIZE);
+    return -EINVAL;
+  }
+
+  /* 早く決めて、その後は照合位置の周りだけ引く */
+  stream = olaf_stream_create(OLAF_CONFIG_MEM_TRACKING, references, ARRAY_SIZE(references),
+                              stream_buffer, sizeof(stream_buffer));
+  if (stream == NULL) {
+    LOG_ERR("olaf stream create failed");
+    return -ENOMEM;
+  }
+  /* 予算は1ステップの時間 (窓掛けとFFTはパイプライン側で測らない) */
+  olaf_stream_set_load_control(stream, clock_us, 0);
+
+  audio_pipeline_set_spectrum_callback(on_spectrum);
+  audio_pipeline_set_gate_callback(on_gate);
+
+  LOG_INF("Audio match initialized: %u fingerprints, buffer %u/%u bytes",
+          (unsigned int)ARRAY_SIZE(olaf_db_mem_fps),
+          (unsigned int)olaf_stream_memory_used(stream), (unsigned int)sizeof(stream_buffer));
+  return 0;
+}
+
+void audio_match_set_callback(audio_match_callback_t cb) { match_callback = cb; }
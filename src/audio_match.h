@@ -0,0 +1,36 @@
+/*
+ * Audio Match - マイク音声を参照曲と照合する
+ *
+ * 解析スレッドから届くスペクトルをolafのCインターフェース (olaf_c.h) に渡し、
+ * ステップごとに照合状態を読み出す。olafの状態はすべて静的バッファ上にあり、
+ * 初期化後はヒープを使わない。
+ */
+
+#ifndef AUDIO_MATCH_H
+#define AUDIO_MATCH_H
+
+#include "olaf_c.h"
+
+/* olaf_fp_ref_mem.hの参照曲 (1曲) の音声ID */
+#define AUDIO_MATCH_REFERENCE_ID 1
+
+/**
+ * @brief 照合状態コールバック
+ * @param match 現在の照合状態 (解析ステップごと, 解析スレッドから呼ばれる)
+ */
+typedef void (*audio_match_callback_t)(const struct olaf_match_state * match);
+
+/**
+ * @brief 照合を初期化し、Audio Pipelineのコールバックを登録
+ * audio_pipeline_init() の後に呼ぶ
+ * @return 0: 成功, 負値: エラー
+ */
+int audio_match_init(void);
+
+/**
+ * @brief 照合状態コールバックを設定
+ * @param cb コールバック関数
+ */
+void audio_match_set_callback(audio_match_callback_t cb);
+
+#endif /* AUDIO_MATCH_H */
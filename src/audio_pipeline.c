@@ -0,0 +1,414 @@
+/*
+ * Audio Pipeline - マイク入力からFFTまでの音声解析
+ *
+ * DMICのDMAブロック (AUDIO_STEP_SIZEサンプル) をミラーリングされたリング
+ * (sliding_window) に書き込んで即座に返却し、直近AUDIO_FFT_SIZEサンプルの
+ * 連続領域から窓掛けしながら直接FFT入力を作る。ステップごとの
+ * memmoveやフレームの組み立てコピーは行わない。
+ */
+
+#include "audio_pipeline.h"
+
+#include <arm_math.h>
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "audio_decimator.h"
+#include "audio_gate.h"
+#include "audio_ring.h"
+#include "audio_source.h"
+#include "olaf_profile.h"
+#include "olaf_window.h"
+#include "sliding_window.h"
+
+LOG_MODULE_REGISTER(audio_pipeline, LOG_LEVEL_INF);
+
+BUILD_ASSERT(AUDIO_FFT_SIZE % AUDIO_STEP_SIZE == 0, "FFT size must be a multiple of step size");
+BUILD_ASSERT(AUDIO_FFT_SIZE % 4 == 0, "FFT size must be a multiple of 4");
+BUILD_ASSERT(AUDIO_CAPTURE_RATE % AUDIO_SAMPLE_RATE == 0,
+             "Capture rate must be a multiple of the analysis rate");
+BUILD_ASSERT(AUDIO_DECIMATION <= AUDIO_DECIMATOR_MAX_FACTOR, "Capture rate too high");
+
+/* 取り込みブロック (取り込みレートで1ステップ分) */
+#define CAPTURE_BLOCK_SAMPLES (AUDIO_STEP_SIZE * AUDIO_DECIMATION)
+#define BLOCK_BYTES (CAPTURE_BLOCK_SAMPLES * sizeof(int16_t))
+
+/* 読み込みタイムアウト */
+#define READ_TIMEOUT_MS 1000
+
+#ifdef CONFIG_APP_AUDIO_GATE
+/* ゲートを閉じるまでのブロック数 */
+#define GATE_HOLD_BLOCKS \
+  ((CONFIG_APP_AUDIO_GATE_HOLD_MS * AUDIO_SAMPLE_RATE) / (1000 * AUDIO_STEP_SIZE))
+#endif
+
+/* 16bit PCM -> [-1, 1) */
+#define PCM16_SCALE (1.0f / 32768.0f)
+
+/* DMA転送中のブロック (受信後すぐにリングへコピーして返却する) */
+K_MEM_SLAB_DEFINE_STATIC(audio_slab, BLOCK_BYTES, CONFIG_APP_AUDIO_DMA_BLOCKS, sizeof(uint32_t));
+
+#if AUDIO_DECIMATION > 1
+AUDIO_DECIMATOR_STATE_DEFINE(decimator_state, CAPTURE_BLOCK_SAMPLES);
+#endif
+
+/* 取り込みスレッド -> 解析スレッド */
+AUDIO_RING_STORAGE_DEFINE(ring_storage, CONFIG_APP_AUDIO_RING_BLOCKS, AUDIO_STEP_SIZE);
+
+SLIDING_WINDOW_STORAGE_DEFINE(window_storage, AUDIO_FFT_SIZE);
+
+K_THREAD_STACK_DEFINE(capture_stack, CONFIG_APP_AUDIO_CAPTURE_STACK_SIZE);
+K_THREAD_STACK_DEFINE(audio_stack, CONFIG_APP_AUDIO_STACK_SIZE);
+
+/* リングにブロックが入ったことを解析スレッドへ通知 */
+K_SEM_DEFINE(ring_sem, 0, CONFIG_APP_AUDIO_RING_BLOCKS);
+
+/* パイプライン状態 */
+struct audio_pipeline_state
+{
+  bool initialized;
+  volatile bool running;
+
+  /* 取り込み済みでまだ解析していないブロック */
+  struct audio_ring ring;
+#if AUDIO_DECIMATION > 1
+  struct audio_decimator decimator;
+#endif
+
+  /* 直近AUDIO_FFT_SIZEサンプル */
+  struct sliding_window window;
+
+  int block_index;
+  /* 解析スレッドが把握しているオーバーラン数 */
+  uint32_t overruns_seen;
+  audio_spectrum_callback_t callback;
+
+  /* 無音中はFFT以降を止める */
+  struct audio_gate gate;
+  uint32_t blocks_gated;
+  audio_gate_callback_t gate_callback;
+
+  arm_rfft_fast_instance_f32 fft;
+#ifdef CONFIG_APP_AUDIO_PROFILE
+  int64_t profile_report_at;
+#endif
+  struct k_thread capture_thread;
+  struct k_thread thread;
+};
+
+static struct audio_pipeline_state state = {};
+
+/* FFT入出力 (arm_rfft_fast_f32は入力を作業領域として上書きする) */
+static float fft_in[AUDIO_FFT_SIZE] __aligned(8);
+static float fft_out[AUDIO_FFT_SIZE] __aligned(8);
+
+/*
+ * 連続した解析窓から窓掛けしつつFFT入力を作成
+ * 変換・スケール・窓掛けを1パスで行う (M33はfloat SIMDを持たないため4展開のスカラー)
+ */
+static void build_fft_input(void)
+{
+  const int16_t * samples = sliding_window_get(&state.window);
+  const float * window = hamming_window_1024;
+  float * out = fft_in;
+
+  for (int i = 0; i < AUDIO_FFT_SIZE; i += 4) {
+    out[i] = (float)samples[i] * (PCM16_SCALE * window[i]);
+    out[i + 1] = (float)samples[i + 1] * (PCM16_SCALE * window[i + 1]);
+    out[i + 2] = (float)samples[i + 2] * (PCM16_SCALE * window[i + 2]);
+    out[i + 3] = (float)samples[i + 3] * (PCM16_SCALE * window[i + 3]);
+  }
+}
+
+/* 1ステップ分の解析 */
+static void process_frame(void)
+{
+  OLAF_PROFILE_BEGIN(OLAF_STAGE_BLOCK);
+  OLAF_PROFILE_BEGIN(OLAF_STAGE_WINDOW);
+  build_fft_input();
+  OLAF_PROFILE_END(OLAF_STAGE_WINDOW);
+
+  OLAF_PROFILE_BEGIN(OLAF_STAGE_FFT);
+  arm_rfft_fast_f32(&state.fft, fft_in, fft_out, 0);
+  OLAF_PROFILE_END(OLAF_STAGE_FFT);
+
+  if (state.callback) {
+    state.callback(fft_out, state.block_index);
+  }
+  state.block_index++;
+  OLAF_PROFILE_END(OLAF_STAGE_BLOCK);
+}
+
+#ifdef CONFIG_APP_AUDIO_PROFILE
+/* 段ごとの処理時間を定期的にログへ出してリセット */
+static void report_profile(void)
+{
+  int64_t now = k_uptime_get();
+  if (now < state.profile_report_at) {
+    return;
+  }
+  state.profile_report_at = now + CONFIG_APP_AUDIO_PROFILE_REPORT_MS;
+
+  struct olaf_profile_stats block;
+  if (!olaf_profile_get(OLAF_STAGE_BLOCK, &block)) {
+    return;
+  }
+
+  for (int stage = 0; stage < OLAF_STAGE_COUNT; stage++) {
+    struct olaf_profile_stats stats;
+    if (!olaf_profile_get((enum olaf_profile_stage)stage, &stats)) {
+      continue;
+    }
+    /* ステップあたりの平均 (1ステップに複数回呼ばれる段もある) */
+    uint32_t per_block = (uint32_t)(stats.total / block.count);
+    LOG_INF("%-10s n %u min %u avg %u max %u p99 %u, %u " OLAF_PROFILE_TICK_UNIT "/step",
+            olaf_profile_stage_name((enum olaf_profile_stage)stage), stats.count, stats.min,
+            stats.avg, stats.max, stats.p99, per_block);
+  }
+  olaf_profile_reset();
+}
+#endif
+
+/*
+ * 取り込みスレッド
+ * ドライバのブロックを (必要なら16kHzへ間引いて) リングへコピーしてすぐ返却するだけで、
+ * 解析を待たない。解析が遅れてリングが満杯になったブロックは破棄される。
+ */
+static void capture_thread(void * p1, void * p2, void * p3)
+{
+  ARG_UNUSED(p1);
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  while (state.running) {
+    int16_t * block;
+    int ret = audio_source_read(&block, READ_TIMEOUT_MS);
+    if (ret < 0) {
+      if (state.running) {
+        LOG_WRN("Audio read failed: %d", ret);
+      }
+      continue;
+    }
+
+#if AUDIO_DECIMATION > 1
+    int16_t decimated[AUDIO_STEP_SIZE];
+    audio_decimator_process(&state.decimator, block, decimated);
+    audio_source_release(block);
+    ret = audio_ring_push(&state.ring, decimated);
+#else
+    ret = audio_ring_push(&state.ring, block);
+    audio_source_release(block);
+#endif
+
+    if (ret == 0) {
+      k_sem_give(&ring_sem);
+    }
+  }
+}
+
+/* 破棄されたブロックがあればログに残し、ブロック番号を実時間に合わせる */
+static void check_overruns(void)
+{
+  struct audio_ring_stats stats;
+  audio_ring_get_stats(&state.ring, &stats);
+
+  uint32_t dropped = stats.overruns - state.overruns_seen;
+  if (dropped == 0) {
+    return;
+  }
+
+  state.overruns_seen = stats.overruns;
+  state.block_index += dropped;
+  LOG_WRN("Audio overrun: %u blocks dropped (total %u, high water %u/%u)", dropped,
+          stats.overruns, stats.high_water, stats.capacity);
+}
+
+/*
+ * 新しいステップのエネルギーでゲートを更新
+ * @return true: FFT以降を実行する
+ */
+static bool update_gate(const int16_t * step)
+{
+#ifdef CONFIG_APP_AUDIO_GATE
+  if (audio_gate_update(&state.gate, step, AUDIO_STEP_SIZE)) {
+    bool open = audio_gate_is_open(&state.gate);
+    LOG_DBG("Audio gate %s at block %d", open ? "open" : "closed", state.block_index);
+
+    /* olaf側はここで抽出を再開/停止し、閉じたときに照合状態を破棄する */
+    if (state.gate_callback) {
+      state.gate_callback(open, state.block_index);
+    }
+  }
+  return audio_gate_is_open(&state.gate);
+#else
+  ARG_UNUSED(step);
+  return true;
+#endif
+}
+
+/* 解析スレッド */
+static void audio_thread(void * p1, void * p2, void * p3)
+{
+  ARG_UNUSED(p1);
+  ARG_UNUSED(p2);
+  ARG_UNUSED(p3);
+
+  while (state.running) {
+    if (k_sem_take(&ring_sem, K_MSEC(READ_TIMEOUT_MS)) != 0) {
+      continue;
+    }
+
+    const int16_t * block = audio_ring_peek(&state.ring);
+    if (block == NULL) {
+      continue;
+    }
+
+    sliding_window_write(&state.window, block, AUDIO_STEP_SIZE);
+    audio_ring_consume(&state.ring);
+
+    check_overruns();
+
+    /* 窓が埋まるまではFFTしない */
+    if (!sliding_window_is_full(&state.window)) {
+      continue;
+    }
+
+    if (update_gate(sliding_window_get(&state.window) + AUDIO_FFT_SIZE - AUDIO_STEP_SIZE)) {
+      process_frame();
+#ifdef CONFIG_APP_AUDIO_PROFILE
+      report_profile();
+#endif
+    } else {
+      /* 時間は進める */
+      state.blocks_gated++;
+      state.block_index++;
+    }
+  }
+}
+
+int audio_pipeline_init(void)
+{
+  memset(&state, 0, sizeof(state));
+  audio_ring_init(&state.ring, ring_storage, CONFIG_APP_AUDIO_RING_BLOCKS, AUDIO_STEP_SIZE);
+  sliding_window_init(&state.window, window_storage, AUDIO_FFT_SIZE);
+#ifdef CONFIG_APP_AUDIO_GATE
+  audio_gate_init(&state.gate, CONFIG_APP_AUDIO_GATE_OPEN_DBFS, CONFIG_APP_AUDIO_GATE_CLOSE_DBFS,
+                  GATE_HOLD_BLOCKS);
+#endif
+
+  if (arm_rfft_fast_init_f32(&state.fft, AUDIO_FFT_SIZE) != ARM_MATH_SUCCESS) {
+    LOG_ERR("FFT init failed");
+    return -EINVAL;
+  }
+
+#if AUDIO_DECIMATION > 1
+  if (audio_decimator_init(&state.decimator, AUDIO_DECIMATION, decimator_state,
+                           CAPTURE_BLOCK_SAMPLES) < 0) {
+    LOG_ERR("Decimator init failed");
+    return -EINVAL;
+  }
+#endif
+
+#ifdef CONFIG_APP_AUDIO_PROFILE
+  olaf_profile_init();
+  state.profile_report_at = k_uptime_get() + CONFIG_APP_AUDIO_PROFILE_REPORT_MS;
+#endif
+
+  int ret = audio_source_init(&audio_slab, AUDIO_CAPTURE_RATE, BLOCK_BYTES);
+  if (ret < 0) {
+    LOG_ERR("Audio source init failed: %d", ret);
+    return ret;
+  }
+
+  state.initialized = true;
+  LOG_INF("Audio pipeline initialized: capture %d Hz, fft %d, step %d", AUDIO_CAPTURE_RATE,
+          AUDIO_FFT_SIZE, AUDIO_STEP_SIZE);
+  return 0;
+}
+
+void audio_pipeline_set_spectrum_callback(audio_spectrum_callback_t cb) { state.callback = cb; }
+
+void audio_pipeline_set_gate_callback(audio_gate_callback_t cb) { state.gate_callback = cb; }
+
+int audio_pipeline_start(void)
+{
+  if (!state.initialized) {
+    return -EINVAL;
+  }
+  if (state.running) {
+    return 0;
+  }
+  if (state.callback == NULL) {
+    /* 結果を使う処理がなければマイクもDMAも動かさない */
+    LOG_INF("No spectrum callback set, audio capture not started");
+    return 0;
+  }
+
+  int ret = audio_source_start();
+  if (ret < 0) {
+    LOG_ERR("Audio source start failed: %d", ret);
+    return ret;
+  }
+
+  state.running = true;
+  state.block_index = 0;
+  state.overruns_seen = 0;
+  state.blocks_gated = 0;
+  audio_gate_reset(&state.gate);
+  audio_ring_reset(&state.ring);
+#if AUDIO_DECIMATION > 1
+  audio_decimator_reset(&state.decimator);
+#endif
+  k_sem_reset(&ring_sem);
+  sliding_window_reset(&state.window);
+
+  k_thread_create(
+    &state.thread, audio_stack, K_THREAD_STACK_SIZEOF(audio_stack), audio_thread, NULL, NULL,
+    NULL, CONFIG_APP_AUDIO_THREAD_PRIORITY, 0, K_NO_WAIT);
+  k_thread_name_set(&state.thread, "audio");
+
+  k_thread_create(
+    &state.capture_thread, capture_stack, K_THREAD_STACK_SIZEOF(capture_stack), capture_thread,
+    NULL, NULL, NULL, CONFIG_APP_AUDIO_CAPTURE_THREAD_PRIORITY, 0, K_NO_WAIT);
+  k_thread_name_set(&state.capture_thread, "audio_capture");
+
+  LOG_INF("Audio pipeline started");
+  return 0;
+}
+
+void audio_pipeline_stop(void)
+{
+  if (!state.running) {
+    return;
+  }
+
+  state.running = false;
+  audio_source_stop();
+  k_thread_join(&state.capture_thread, K_FOREVER);
+
+  /* 待機中の解析スレッドを起こす */
+  k_sem_give(&ring_sem);
+  k_thread_join(&state.thread, K_FOREVER);
+
+  struct audio_ring_stats stats;
+  audio_ring_get_stats(&state.ring, &stats);
+  LOG_INF("Audio pipeline stopped: %u overruns, high water %u/%u", stats.overruns,
+          stats.high_water, stats.capacity);
+}
+
+bool audio_pipeline_is_running(void) { return state.running; }
+
+void audio_pipeline_get_stats(struct audio_pipeline_stats * stats)
+{
+  struct audio_ring_stats ring;
+  audio_ring_get_stats(&state.ring, &ring);
+
+  stats->blocks_analyzed = state.block_index;
+  stats->blocks_gated = state.blocks_gated;
+  stats->overruns = ring.overruns;
+  stats->ring_fill = ring.fill;
+  stats->ring_high_water = ring.high_water;
+  stats->ring_capacity = ring.capacity;
+}
@@ -0,0 +1,91 @@
+/*
+ * Audio Pipeline - マイク入力からFFTまでの音声解析
+ */
+
+#ifndef AUDIO_PIPELINE_H
+#define AUDIO_PIPELINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* olaf Config (audioSampleRate / audioBlockSize / audioStepSize) と一致させる */
+#define AUDIO_SAMPLE_RATE 16000
+#define AUDIO_FFT_SIZE 1024
+#define AUDIO_STEP_SIZE CONFIG_APP_AUDIO_STEP_SIZE
+
+/* マイクの取り込みレート, AUDIO_SAMPLE_RATEへ間引いてから解析する */
+#define AUDIO_CAPTURE_RATE CONFIG_APP_AUDIO_CAPTURE_RATE
+#define AUDIO_DECIMATION (AUDIO_CAPTURE_RATE / AUDIO_SAMPLE_RATE)
+
+/**
+ * @brief スペクトル受信コールバック
+ * EPExtractor::extract() にそのまま渡せる形式 (CMSIS rfft_fast の出力)
+ * @param spectrum FFT出力 (AUDIO_FFT_SIZE個のfloat, 次の呼び出しまで有効)
+ * @param block_index 解析ブロック番号 (AUDIO_STEP_SIZEごとに1増加)
+ */
+typedef void (*audio_spectrum_callback_t)(const float * spectrum, int block_index);
+
+/**
+ * @brief 無音ゲート開閉コールバック
+ * 閉じている間はスペクトルが届かない。閉じたら照合状態 (FPMatcher::reset) と
+ * 抽出状態を破棄し、開いたら抽出を最初からやり直す。
+ * @param open true: 音あり (解析再開), false: 無音 (解析停止)
+ * @param block_index 開閉したブロック番号
+ */
+typedef void (*audio_gate_callback_t)(bool open, int block_index);
+
+/* 取り込みと解析の統計 */
+struct audio_pipeline_stats
+{
+  uint32_t blocks_analyzed;  /* 開始からのブロック数 (破棄分を含む) */
+  uint32_t blocks_gated;     /* 無音でFFTを省いたブロック数 */
+  uint32_t overruns;         /* 解析が追いつかず破棄したブロック数 */
+  uint32_t ring_fill;        /* 解析待ちのブロック数 */
+  uint32_t ring_high_water;  /* 解析待ちブロック数の最大値 */
+  uint32_t ring_capacity;    /* リング容量 (ブロック) */
+};
+
+/**
+ * @brief Audio Pipelineを初期化
+ * @return 0: 成功, 負値: エラー
+ */
+int audio_pipeline_init(void);
+
+/**
+ * @brief スペクトル受信コールバックを設定
+ * @param cb コールバック関数 (解析スレッドから呼ばれる, 遅くても取り込みは止まらない)
+ */
+void audio_pipeline_set_spectrum_callback(audio_spectrum_callback_t cb);
+
+/**
+ * @brief 無音ゲート開閉コールバックを設定
+ * @param cb コールバック関数 (解析スレッドから呼ばれる)
+ */
+void audio_pipeline_set_gate_callback(audio_gate_callback_t cb);
+
+/**
+ * @brief 音声取り込みと解析を開始
+ * スペクトルか解析ステップのコールバックが設定されていなければ取り込みを始めない
+ * (0を返し, audio_pipeline_is_running() はfalseのまま)。コールバックは開始前に設定する。
+ * @return 0: 成功, 負値: エラー
+ */
+int audio_pipeline_start(void);
+
+/**
+ * @brief 音声取り込みと解析を停止
+ */
+void audio_pipeline_stop(void);
+
+/**
+ * @brief 解析が実行中かどうか
+ * @return true: 実行中, false: 停止中
+ */
+bool audio_pipeline_is_running(void);
+
+/**
+ * @brief 取り込みと解析の統計を取得
+ * @param stats 出力先
+ */
+void audio_pipeline_get_stats(struct audio_pipeline_stats * stats);
+
+#endif /* AUDIO_PIPELINE_H */
@@ -0,0 +1,75 @@
+/*
+ * Audio Ring - 取り込みスレッドと解析スレッド間のロックフリーSPSCリング
+ */
+
+#include "audio_ring.h"
+
+#include <errno.h>
+#include <string.h>
+
+void audio_ring_init(struct audio_ring * ring, int16_t * storage, uint32_t blocks, size_t block_size)
+{
+  ring->buf = storage;
+  ring->blocks = blocks;
+  ring->block_size = block_size;
+  audio_ring_reset(ring);
+}
+
+void audio_ring_reset(struct audio_ring * ring)
+{
+  atomic_set(&ring->head, 0);
+  atomic_set(&ring->tail, 0);
+  atomic_set(&ring->overruns, 0);
+  atomic_set(&ring->high_water, 0);
+}
+
+int audio_ring_push(struct audio_ring * ring, const int16_t * samples)
+{
+  uint32_t head = (uint32_t)atomic_get(&ring->head);
+  uint32_t tail = (uint32_t)atomic_get(&ring->tail);
+
+  if (head - tail >= ring->blocks) {
+    atomic_inc(&ring->overruns);
+    return -ENOBUFS;
+  }
+
+  int16_t * slot = &ring->buf[(head & (ring->blocks - 1)) * ring->block_size];
+  memcpy(slot, samples, ring->block_size * sizeof(int16_t));
+
+  /* データを書き終えてから公開する (atomic_setは順序を保証する) */
+  atomic_set(&ring->head, (atomic_val_t)(head + 1));
+
+  uint32_t fill = head + 1 - tail;
+  if (fill > (uint32_t)atomic_get(&ring->high_water)) {
+    atomic_set(&ring->high_water, (atomic_val_t)fill);
+  }
+  return 0;
+}
+
+const int16_t * audio_ring_peek(const struct audio_ring * ring)
+{
+  uint32_t tail = (uint32_t)atomic_get(&ring->tail);
+  uint32_t head = (uint32_t)atomic_get(&ring->head);
+
+  if (head == tail) {
+    return NULL;
+  }
+  return &ring->buf[(tail & (ring->blocks - 1)) * ring->block_size];
+}
+
+void audio_ring_consume(struct audio_ring * ring)
+{
+  /* 読み終えてから書き込み側にスロットを返す */
+  atomic_inc(&ring->tail);
+}
+
+void audio_ring_get_stats(const struct audio_ring * ring, struct audio_ring_stats * stats)
+{
+  uint32_t tail = (uint32_t)atomic_get(&ring->tail);
+  uint32_t head = (uint32_t)atomic_get(&ring->head);
+
+  stats->fill = head - tail;
+  stats->high_water = (uint32_t)atomic_get(&ring->high_water);
+  stats->capacity = ring->blocks;
+  stats->overruns = (uint32_t)atomic_get(&ring->overruns);
+}
@@ -0,0 +1,83 @@
+/*
+ * Audio Ring - 取り込みスレッドと解析スレッド間のロックフリーSPSCリング
+ *
+ * 書き込み側 (producer) と読み出し側 (consumer) がそれぞれ1つに限られる前提で、
+ * head は書き込み側のみ、tail は読み出し側のみが更新する。
+ * どちらも単調増加するカウンタで、リング内のブロック数は head - tail。
+ * 満杯時の書き込みは待たずに破棄し、オーバーランとして数える。
+ */
+
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/toolchain.h>
+
+struct audio_ring
+{
+  int16_t * buf;        /* blocks * block_size サンプル */
+  size_t block_size;    /* 1ブロックのサンプル数 */
+  uint32_t blocks;      /* ブロック数 (2のべき乗) */
+  atomic_t head;        /* 書き込み済みブロック数 (書き込み側のみ更新) */
+  atomic_t tail;        /* 読み出し済みブロック数 (読み出し側のみ更新) */
+  atomic_t overruns;    /* 満杯で破棄したブロック数 */
+  atomic_t high_water;  /* リング内ブロック数の最大値 */
+};
+
+/* リングの状態 */
+struct audio_ring_stats
+{
+  uint32_t fill;        /* 現在のブロック数 */
+  uint32_t high_water;  /* 最大ブロック数 */
+  uint32_t capacity;    /* 容量 (ブロック) */
+  uint32_t overruns;    /* 破棄したブロック数 */
+};
+
+/* blocks * block_size サンプルのストレージを静的に確保 */
+#define AUDIO_RING_STORAGE_DEFINE(name, blocks, block_size)                                  \
+  BUILD_ASSERT(((blocks) & ((blocks) - 1)) == 0, "Ring blocks must be a power of two");     \
+  static int16_t name[(blocks) * (block_size)] __aligned(8)
+
+/**
+ * @brief リングを初期化
+ * @param ring 対象
+ * @param storage blocks * block_size サンプルのバッファ
+ * @param blocks ブロック数 (2のべき乗)
+ * @param block_size 1ブロックのサンプル数
+ */
+void audio_ring_init(struct audio_ring * ring, int16_t * storage, uint32_t blocks, size_t block_size);
+
+/**
+ * @brief 1ブロックを書き込む (書き込み側, ブロックしない)
+ * @param ring 対象
+ * @param samples block_size サンプル
+ * @return 0: 成功, -ENOBUFS: 満杯のため破棄
+ */
+int audio_ring_push(struct audio_ring * ring, const int16_t * samples);
+
+/**
+ * @brief 最古のブロックを参照 (読み出し側)
+ * @param ring 対象
+ * @return ブロック先頭, 空ならNULL. audio_ring_consume()まで有効
+ */
+const int16_t * audio_ring_peek(const struct audio_ring * ring);
+
+/**
+ * @brief 最古のブロックを解放 (読み出し側)
+ */
+void audio_ring_consume(struct audio_ring * ring);
+
+/**
+ * @brief 状態を取得 (どのスレッドからでも可)
+ */
+void audio_ring_get_stats(const struct audio_ring * ring, struct audio_ring_stats * stats);
+
+/**
+ * @brief 内容と統計を破棄 (書き込み側・読み出し側とも停止中に呼ぶ)
+ */
+void audio_ring_reset(struct audio_ring * ring);
+
+#endif /* AUDIO_RING_H */
@@ -0,0 +1,48 @@
+/*
+ * Audio Source - 音声入力ソース (DMIC / ファイル)
+ */
+
+#ifndef AUDIO_SOURCE_H
+#define AUDIO_SOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+/**
+ * @brief 音声入力ソースを初期化
+ * 受信ブロックはslabから確保され、audio_source_release()で返却する
+ * @param slab ブロック確保用のメモリスラブ
+ * @param sample_rate サンプリングレート (Hz)
+ * @param block_size 1ブロックのバイト数 (16bit PCM, モノラル)
+ * @return 0: 成功, 負値: エラー
+ */
+int audio_source_init(struct k_mem_slab * slab, uint32_t sample_rate, size_t block_size);
+
+/**
+ * @brief 音声入力を開始
+ * @return 0: 成功, 負値: エラー
+ */
+int audio_source_start(void);
+
+/**
+ * @brief 音声入力を停止
+ * @return 0: 成功, 負値: エラー
+ */
+int audio_source_stop(void);
+
+/**
+ * @brief 次の音声ブロックを取得 (コピーなし)
+ * @param block 受信ブロックへのポインタ (16bit PCM)
+ * @param timeout_ms タイムアウト (ms)
+ * @return 0: 成功, 負値: エラー
+ */
+int audio_source_read(int16_t ** block, int32_t timeout_ms);
+
+/**
+ * @brief 処理済みの音声ブロックを返却
+ * @param block audio_source_read()で取得したブロック
+ */
+void audio_source_release(int16_t * block);
+
+#endif /* AUDIO_SOURCE_H */
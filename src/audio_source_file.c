@@ -0,0 +1,79 @@
+/*
+ * Audio Source (File) - ファイルからの音声入力 (native_sim用DMIC代替)
+ *
+ * ホストの16bit PCM / WAVファイルを実時間のペースでブロック単位に供給する
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "audio_source.h"
+#include "audio_source_file_bottom.h"
+
+LOG_MODULE_REGISTER(audio_source, LOG_LEVEL_INF);
+
+static struct k_mem_slab * block_slab;
+static size_t block_samples;
+static uint32_t block_period_us;
+static int64_t next_block_time_us;
+static bool started;
+
+int audio_source_init(struct k_mem_slab * slab, uint32_t sample_rate, size_t block_size)
+{
+  int ret = audio_file_bottom_open(CONFIG_APP_AUDIO_SOURCE_FILE_PATH);
+  if (ret < 0) {
+    LOG_ERR("Audio file open failed");
+    return -ENOENT;
+  }
+
+  block_slab = slab;
+  block_samples = block_size / sizeof(int16_t);
+  block_period_us = (uint32_t)((uint64_t)block_samples * USEC_PER_SEC / sample_rate);
+
+  LOG_INF("File audio source: %u Hz, block %u samples", sample_rate, (unsigned int)block_samples);
+  return 0;
+}
+
+int audio_source_start(void)
+{
+  next_block_time_us = k_ticks_to_us_floor64(k_uptime_ticks());
+  started = true;
+  return 0;
+}
+
+int audio_source_stop(void)
+{
+  started = false;
+  return 0;
+}
+
+int audio_source_read(int16_t ** block, int32_t timeout_ms)
+{
+  void * buffer;
+
+  if (!started) {
+    return -EIO;
+  }
+
+  /* DMIC同様、ブロックは実時間に合わせて届く */
+  next_block_time_us += block_period_us;
+  int64_t wait_us = next_block_time_us - k_ticks_to_us_floor64(k_uptime_ticks());
+  if (wait_us > 0) {
+    k_sleep(K_USEC(wait_us));
+  }
+
+  int ret = k_mem_slab_alloc(block_slab, &buffer, K_MSEC(timeout_ms));
+  if (ret < 0) {
+    return ret;
+  }
+
+  if (audio_file_bottom_read(buffer, (int)block_samples) != (int)block_samples) {
+    k_mem_slab_free(block_slab, buffer);
+    return -EIO;
+  }
+
+  *block = buffer;
+  return 0;
+}
+
+void audio_source_release(int16_t * block) { k_mem_slab_free(block_slab, block); }
@@ -0,0 +1,93 @@
+/*
+ * Audio Source (File) - ホスト側ファイル読み込み (native_sim用)
+ *
+ * native_simulatorのランナー側でビルドされ、ホストのlibcを使用する
+ */
+
+#include "audio_source_file_bottom.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static FILE * audio_file;
+static long data_offset;
+
+/* WAVファイルなら "data" チャンクの先頭まで読み飛ばす */
+static long find_data_offset(FILE * file)
+{
+  char id[4];
+  uint32_t size;
+
+  if (fread(id, 1, 4, file) != 4 || memcmp(id, "RIFF", 4) != 0) {
+    return 0; /* ヘッダなしPCM */
+  }
+  if (fseek(file, 12, SEEK_SET) != 0) {
+    return -1;
+  }
+
+  while (fread(id, 1, 4, file) == 4 && fread(&size, 4, 1, file) == 1) {
+    if (memcmp(id, "data", 4) == 0) {
+      return ftell(file);
+    }
+    if (fseek(file, (long)size + (size & 1), SEEK_CUR) != 0) {
+      break;
+    }
+  }
+  return -1;
+}
+
+int audio_file_bottom_open(const char * path)
+{
+  const char * env_path = getenv("PENLIGHT_AUDIO_FILE");
+  if (env_path != NULL && env_path[0] != '\0') {
+    path = env_path;
+  }
+
+  audio_file = fopen(path, "rb");
+  if (audio_file == NULL) {
+    fprintf(stderr, "audio_source_file: cannot open %s\n", path);
+    return -1;
+  }
+
+  data_offset = find_data_offset(audio_file);
+  if (data_offset < 0 || fseek(audio_file, data_offset, SEEK_SET) != 0) {
+    fprintf(stderr, "audio_source_file: no audio data in %s\n", path);
+    fclose(audio_file);
+    audio_file = NULL;
+    return -1;
+  }
+
+  return 0;
+}
+
+int audio_file_bottom_read(int16_t * samples, int count)
+{
+  int total = 0;
+
+  if (audio_file == NULL) {
+    return -1;
+  }
+
+  while (total < count) {
+    size_t n = fread(samples + total, sizeof(int16_t), (size_t)(count - total), audio_file);
+    total += (int)n;
+    if (total < count) {
+      /* 終端: 先頭に戻ってループ再生 */
+      if (n == 0 && ftell(audio_file) == data_offset) {
+        break; /* 空ファイル */
+      }
+      fseek(audio_file, data_offset, SEEK_SET);
+    }
+  }
+
+  return total;
+}
+
+void audio_file_bottom_close(void)
+{
+  if (audio_file != NULL) {
+    fclose(audio_file);
+    audio_file = NULL;
+  }
+}
@@ -0,0 +1,34 @@
+/*
+ * Audio Source (File) - ホスト側ファイル読み込み (native_sim用)
+ *
+ * このヘッダはZephyr側とホスト側の両方からインクルードされるため
+ * 標準Cの型のみを使用する
+ */
+
+#ifndef AUDIO_SOURCE_FILE_BOTTOM_H
+#define AUDIO_SOURCE_FILE_BOTTOM_H
+
+#include <stdint.h>
+
+/**
+ * @brief 16bit PCMファイルを開く (WAVヘッダは読み飛ばす)
+ * 環境変数 PENLIGHT_AUDIO_FILE が設定されていればそちらを優先
+ * @param path ファイルパス
+ * @return 0: 成功, 負値: エラー
+ */
+int audio_file_bottom_open(const char * path);
+
+/**
+ * @brief サンプルを読み込む (終端に達したら先頭から繰り返す)
+ * @param samples 出力先
+ * @param count 読み込むサンプル数
+ * @return 読み込んだサンプル数, 負値: エラー
+ */
+int audio_file_bottom_read(int16_t * samples, int count);
+
+/**
+ * @brief ファイルを閉じる
+ */
+void audio_file_bottom_close(void);
+
+#endif /* AUDIO_SOURCE_FILE_BOTTOM_H */
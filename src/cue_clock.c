@@ -0,0 +1,67 @@
+/*
+ * Cue Clock - 照合した参照時刻に追従するローカル時計
+ */
+
+#include "cue_clock.h"
+
+#define PPM 1000000
+
+/* 位相は誤差の1/8ずつ寄せる (ステップごとの量子化誤差を均す) */
+#define PHASE_GAIN_DIV 8
+/* 速度は推定値の1/8ずつ寄せる */
+#define RATE_GAIN_DIV 8
+/* 速度を推定し始めるまでのロック時間 */
+#define RATE_MIN_SPAN_US (2 * 1000000LL)
+/* 速度のずれの上限 (±2%) */
+#define RATE_LIMIT_PPM 20000
+
+void cue_clock_lock(struct cue_clock * clock, int64_t t, int64_t ref_us, bool keep_rate)
+{
+  if (!keep_rate) {
+    clock->rate_ppm = 0;
+  }
+  clock->anchor_us = clock->lock_us = t;
+  clock->anchor_ref_us = clock->lock_ref_us = ref_us;
+}
+
+int64_t cue_clock_predict(const struct cue_clock * clock, int64_t t)
+{
+  int64_t elapsed = t - clock->anchor_us;
+  return clock->anchor_ref_us + elapsed + elapsed * clock->rate_ppm / PPM;
+}
+
+void cue_clock_correct(struct cue_clock * clock, int64_t t, int64_t ref_us)
+{
+  int64_t predicted = cue_clock_predict(clock, t);
+  clock->anchor_ref_us = predicted + (ref_us - predicted) / PHASE_GAIN_DIV;
+  clock->anchor_us = t;
+
+  int64_t span = t - clock->lock_us;
+  if (span >= RATE_MIN_SPAN_US) {
+    int64_t measured_ppm = (ref_us - clock->lock_ref_us - span) * PPM / span;
+    int64_t rate = clock->rate_ppm + (measured_ppm - clock->rate_ppm) / RATE_GAIN_DIV;
+    if (rate > RATE_LIMIT_PPM) {
+      rate = RATE_LIMIT_PPM;
+    } else if (rate < -RATE_LIMIT_PPM) {
+      rate = -RATE_LIMIT_PPM;
+    }
+    clock->rate_ppm = (int32_t)rate;
+  }
+}
+
+bool cue_clock_update(struct cue_clock * clock, int64_t t, int64_t ref_us, int64_t resync_us)
+{
+  int64_t error_us = ref_us - cue_clock_predict(clock, t);
+  if (error_us > resync_us || error_us < -resync_us) {
+    cue_clock_lock(clock, t, ref_us, true);
+    return true;
+  }
+  cue_clock_correct(clock, t, ref_us);
+  return false;
+}
+
+int64_t cue_clock_wait_us(const struct cue_clock * clock, int64_t t, int64_t ref_us)
+{
+  int64_t ahead_us = ref_us - cue_clock_predict(clock, t);
+  return ahead_us * PPM / (PPM + clock->rate_ppm);
+}
@@ -0,0 +1,74 @@
+/*
+ * Cue Clock - 照合した参照時刻に追従するローカル時計
+ *
+ * ref(t) = anchor_ref + (t - anchor) * (1 + rate_ppm / 1e6)
+ * 照合結果の参照時刻はブロック単位に量子化されているので、誤差の一部ずつ
+ * 位相を寄せ、ロック開始からの傾きで再生速度のずれ (水晶の誤差やテンポ) を
+ * 推定する。時刻はすべてマイクロ秒の整数。
+ *
+ * Zephyrに依存しない (ホストのテスト host/check_cue_clock.cpp でも使う)。
+ * 排他は呼び出し側で行う。
+ */
+
+#ifndef CUE_CLOCK_H
+#define CUE_CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct cue_clock
+{
+  /* 最後に合わせた点 */
+  int64_t anchor_us;
+  int64_t anchor_ref_us;
+  /* 参照時刻の進み方のずれ */
+  int32_t rate_ppm;
+  /* ロック開始点, 速度推定の基準 */
+  int64_t lock_us;
+  int64_t lock_ref_us;
+};
+
+/**
+ * @brief 時計を測定値に取り直す
+ * @param clock 対象
+ * @param t ローカル時刻
+ * @param ref_us 照合した参照時刻
+ * @param keep_rate true: 推定済みの速度を引き継ぐ (同じ曲の頭出しなど)
+ */
+void cue_clock_lock(struct cue_clock * clock, int64_t t, int64_t ref_us, bool keep_rate);
+
+/**
+ * @brief ローカル時刻tでの参照時刻
+ */
+int64_t cue_clock_predict(const struct cue_clock * clock, int64_t t);
+
+/**
+ * @brief 予測との差の一部だけ位相を寄せ, ロック開始からの傾きで速度を更新
+ * @param clock 対象
+ * @param t ローカル時刻
+ * @param ref_us 照合した参照時刻
+ */
+void cue_clock_correct(struct cue_clock * clock, int64_t t, int64_t ref_us);
+
+/**
+ * @brief 照合結果で時計を合わせる
+ * 予測との差がresync_usを超えたら取り直し、そうでなければ補正する
+ * @return true: 取り直した
+ */
+bool cue_clock_update(struct cue_clock * clock, int64_t t, int64_t ref_us, int64_t resync_us);
+
+/**
+ * @brief 参照時刻がref_usになるまでのローカル時間
+ * @return マイクロ秒, 過ぎていれば0以下
+ */
+int64_t cue_clock_wait_us(const struct cue_clock * clock, int64_t t, int64_t ref_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CUE_CLOCK_H */
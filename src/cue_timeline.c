@@ -0,0 +1,223 @@
+/*
+ * Cue Timeline - 照合した曲の再生位置に合わせてエフェクトを切り替える
+ *
+ * ローカル時計は cue_clock.c: 照合結果の参照時刻に位相と速度を寄せ、大きく
+ * 外れたら (頭出しなど) 取り直す。
+ *
+ * 次のキューはカーソルで持ち、時刻が進むたびに前へ送るだけなので償却O(1)。
+ * 取り直したときだけ二分探索する。ワークは次のキューの時刻ちょうどに
+ * 予約し、照合で時計が補正されるたびに予約し直す。
+ */
+
+#include "cue_timeline.h"
+
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "cue_clock.h"
+
+LOG_MODULE_REGISTER(cue_timeline, LOG_LEVEL_INF);
+
+/* 取り込みから解析スレッドに届くまでの遅れ, 参照時刻に足す */
+#define LATENCY_US ((int64_t)CONFIG_APP_CUE_LATENCY_MS * 1000)
+/* 予測との差がこれを超えたら時計を取り直す */
+#define RESYNC_US ((int64_t)CONFIG_APP_CUE_RESYNC_MS * 1000)
+/* 照合がこれだけ途切れたら同期を終える */
+#define HOLD_US ((int64_t)CONFIG_APP_CUE_HOLD_MS * 1000)
+
+struct cue_timeline_state
+{
+  const struct cue_track * tracks;
+  size_t track_count;
+
+  /* 同期中の曲, NULL: なし */
+  const struct cue_track * track;
+  /* 次に実行するキュー */
+  size_t next;
+  /* 時計を取り直した, nextを探し直す */
+  bool seek;
+
+  /* ローカル時計 */
+  struct cue_clock clock;
+  /* 最後に照合できた時刻 */
+  int64_t last_match_us;
+
+  cue_fire_callback_t fire_callback;
+  cue_release_callback_t release_callback;
+
+  struct k_spinlock lock;
+  struct k_work_delayable work;
+};
+
+static struct cue_timeline_state state = {};
+
+static int64_t now_us(void) { return k_ticks_to_us_floor64(k_uptime_ticks()); }
+
+static int64_t cue_time_us(const struct cue * cue) { return (int64_t)cue->time_ms * 1000; }
+
+static const struct cue_track * find_track(uint32_t audio_id)
+{
+  if (state.track != NULL && state.track->audio_id == audio_id) {
+    return state.track;
+  }
+  for (size_t i = 0; i < state.track_count; i++) {
+    if (state.tracks[i].audio_id == audio_id) {
+      return &state.tracks[i];
+    }
+  }
+  return NULL;
+}
+
+/* 時刻がref_usより後の最初のキュー */
+static size_t upper_bound(const struct cue_track * track, int64_t ref_us)
+{
+  size_t lo = 0;
+  size_t hi = track->count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (cue_time_us(&track->cues[mid]) <= ref_us) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/*
+ * ref_usまでに時刻が来たキューを消化し、実行すべき最後の1つを返す
+ * 同時に複数来たときは途中の効果は上書きされるだけなので飛ばす
+ */
+static const struct cue * advance(int64_t ref_us)
+{
+  const struct cue_track * track = state.track;
+  const struct cue * due = NULL;
+
+  if (state.seek) {
+    /* 取り直した位置で有効なエフェクトから始める */
+    state.next = upper_bound(track, ref_us);
+    state.seek = false;
+    return state.next > 0 ? &track->cues[state.next - 1] : NULL;
+  }
+
+  while (state.next < track->count && cue_time_us(&track->cues[state.next]) <= ref_us) {
+    due = &track->cues[state.next++];
+  }
+  return due;
+}
+
+/* 次にワークを動かすまでの時間: 次のキューか同期終了の早い方 */
+static k_timeout_t next_timeout(int64_t t)
+{
+  if (state.seek) {
+    return K_NO_WAIT;
+  }
+
+  int64_t wait_us = state.last_match_us + HOLD_US - t;
+  if (state.next < state.track->count) {
+    int64_t cue_wait_us =
+      cue_clock_wait_us(&state.clock, t, cue_time_us(&state.track->cues[state.next]));
+    wait_us = MIN(wait_us, cue_wait_us);
+  }
+  return wait_us > 0 ? K_USEC(wait_us) : K_NO_WAIT;
+}
+
+/* キュー実行ワークハンドラ */
+static void cue_work_handler(struct k_work * work)
+{
+  ARG_UNUSED(work);
+  const struct cue * fire = NULL;
+  bool release = false;
+  k_timeout_t timeout = K_FOREVER;
+
+  k_spinlock_key_t key = k_spin_lock(&state.lock);
+  if (state.track == NULL) {
+    k_spin_unlock(&state.lock, key);
+    return;
+  }
+
+  int64_t t = now_us();
+  if (t - state.last_match_us >= HOLD_US) {
+    LOG_INF("Match lost for %d ms, releasing audio %u", CONFIG_APP_CUE_HOLD_MS,
+            state.track->audio_id);
+    state.track = NULL;
+    release = true;
+  } else {
+    fire = advance(cue_clock_predict(&state.clock, t));
+    timeout = next_timeout(t);
+  }
+  k_spin_unlock(&state.lock, key);
+
+  if (fire != NULL && state.fire_callback) {
+    state.fire_callback(&fire->effect);
+  }
+  if (release) {
+    if (state.release_callback) {
+      state.release_callback();
+    }
+    return;
+  }
+  k_work_reschedule(&state.work, timeout);
+}
+
+int cue_timeline_init(const struct cue_track * tracks, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    for (size_t c = 1; c < tracks[i].count; c++) {
+      if (tracks[i].cues[c].time_ms < tracks[i].cues[c - 1].time_ms) {
+        LOG_ERR("Cues of audio %u are not in time order", tracks[i].audio_id);
+        return -EINVAL;
+      }
+    }
+  }
+
+  memset(&state, 0, sizeof(state));
+  state.tracks = tracks;
+  state.track_count = count;
+  k_work_init_delayable(&state.work, cue_work_handler);
+
+  LOG_INF("Cue Timeline initialized: %u tracks", (unsigned int)count);
+  return 0;
+}
+
+void cue_timeline_set_fire_callback(cue_fire_callback_t cb) { state.fire_callback = cb; }
+
+void cue_timeline_set_release_callback(cue_release_callback_t cb) { state.release_callback = cb; }
+
+void cue_timeline_on_match(const struct olaf_match_state * match)
+{
+  if (!match->matched) {
+    /* 途切れている間はローカル時計で進める */
+    return;
+  }
+
+  int64_t t = now_us();
+  int64_t ref_us = (int64_t)(match->reference_time * 1e6f) + LATENCY_US;
+
+  k_spinlock_key_t key = k_spin_lock(&state.lock);
+  const struct cue_track * track = find_track(match->audio_id);
+  if (track == NULL) {
+    k_spin_unlock(&state.lock, key);
+    return;
+  }
+
+  if (track != state.track) {
+    /* 別の曲: 速度の推定は引き継がない */
+    cue_clock_lock(&state.clock, t, ref_us, false);
+    state.track = track;
+    state.seek = true;
+    LOG_INF("Synced to audio %u at %d ms", track->audio_id, (int)(ref_us / 1000));
+  } else if (cue_clock_update(&state.clock, t, ref_us, RESYNC_US)) {
+    state.seek = true;
+    LOG_INF("Resynced at %d ms", (int)(ref_us / 1000));
+  }
+  state.last_match_us = t;
+  k_timeout_t timeout = next_timeout(t);
+  k_spin_unlock(&state.lock, key);
+
+  k_work_reschedule(&state.work, timeout);
+}
+
+bool cue_timeline_is_active(void) { return state.track != NULL; }
@@ -0,0 +1,80 @@
+/*
+ * Cue Timeline - 照合した曲の再生位置に合わせてエフェクトを切り替える
+ *
+ * 曲 (olafの音声ID) ごとに、曲の先頭からの時刻順に並んだエフェクト変更
+ * (キュー) の表を持つ。照合結果の参照時刻でローカル時計を合わせ、照合の
+ * 合間や途切れている間はローカル時計で進めて、時刻が来たキューを実行する。
+ */
+
+#ifndef CUE_TIMELINE_H
+#define CUE_TIMELINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "effect_types.h"
+#include "olaf_c.h"
+
+/* 1つのエフェクト変更 */
+struct cue
+{
+  uint32_t time_ms;          /* 曲の先頭からの時刻 */
+  struct preset_data effect; /* この時刻から実行するエフェクト */
+};
+
+/* 1曲分のキュー表 */
+struct cue_track
+{
+  uint32_t audio_id;       /* olafの音声ID */
+  const struct cue * cues; /* time_msの昇順 */
+  size_t count;            /* キュー数 */
+};
+
+/**
+ * @brief キュー実行コールバック
+ * システムワークキューから呼ばれる
+ * @param effect 実行するエフェクト
+ */
+typedef void (*cue_fire_callback_t)(const struct preset_data * effect);
+
+/**
+ * @brief 同期終了コールバック
+ * 照合がCONFIG_APP_CUE_HOLD_MSの間途切れたら、システムワークキューから呼ばれる
+ */
+typedef void (*cue_release_callback_t)(void);
+
+/**
+ * @brief Cue Timelineを初期化
+ * @param tracks キュー表 (静的に確保されたもの, コピーしない)
+ * @param count キュー表の数
+ * @return 0: 成功, -EINVAL: キューが時刻順でない
+ */
+int cue_timeline_init(const struct cue_track * tracks, size_t count);
+
+/**
+ * @brief キュー実行コールバックを設定
+ * @param cb コールバック関数
+ */
+void cue_timeline_set_fire_callback(cue_fire_callback_t cb);
+
+/**
+ * @brief 同期終了コールバックを設定
+ * @param cb コールバック関数
+ */
+void cue_timeline_set_release_callback(cue_release_callback_t cb);
+
+/**
+ * @brief 照合状態でローカル時計を合わせる
+ * audio_match_set_callback() にそのまま渡せる (解析スレッドから呼ばれる)
+ * @param match 現在の照合状態
+ */
+void cue_timeline_on_match(const struct olaf_match_state * match);
+
+/**
+ * @brief 曲に同期中かどうか
+ * @return true: キュー表のある曲に同期中
+ */
+bool cue_timeline_is_active(void);
+
+#endif /* CUE_TIMELINE_H */
@@ -0,0 +1,32 @@
+/*
+ * Cue Tracks - 曲ごとのキュー表
+ *
+ * 音声IDはaudio_matchの参照と一致させる。キューは曲の先頭からの時刻順に並べる。
+ */
+
+#include "cue_tracks.h"
+
+#include <zephyr/sys/util.h>
+
+#include "audio_match.h"
+
+#define SOLID(r, g, b, w) {.mode = EFFECT_MODE_SOLID, .data.solid = {r, g, b, w}}
+#define BLINK(r, g, b, w, period) {.mode = EFFECT_MODE_BLINK, .data.blink = {r, g, b, w, period}}
+#define RAINBOW(speed, brightness) \
+  {.mode = EFFECT_MODE_RAINBOW, .data.rainbow = {speed, brightness}}
+
+/* 参照曲 (olaf_fp_ref_mem.h) のキュー, 曲に合わせて書き換える */
+static const struct cue reference_cues[] = {
+  {0, SOLID(0, 0, 0, 64)},
+  {4000, SOLID(255, 0, 0, 0)},
+  {8000, SOLID(0, 0, 255, 0)},
+  {12000, BLINK(255, 255, 255, 0, 5)},
+  {16000, RAINBOW(100, 255)},
+  {24000, SOLID(255, 128, 0, 0)},
+};
+
+const struct cue_track cue_tracks[] = {
+  {AUDIO_MATCH_REFERENCE_ID, reference_cues, ARRAY_SIZE(reference_cues)},
+};
+
+const size_t cue_track_count = ARRAY_SIZE(cue_tracks);
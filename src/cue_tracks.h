@@ -0,0 +1,16 @@
+/*
+ * Cue Tracks - 曲ごとのキュー表
+ */
+
+#ifndef CUE_TRACKS_H
+#define CUE_TRACKS_H
+
+#include <stddef.h>
+
+#include "cue_timeline.h"
+
+/* 照合できる曲のキュー表 (cue_timeline_init() に渡す) */
+extern const struct cue_track cue_tracks[];
+extern const size_t cue_track_count;
+
+#endif /* CUE_TRACKS_H */
@@ -7,8 +7,12 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 
+#include "audio_match.h"
+#include "audio_pipeline.h"
 #include "ble_service.h"
 #include "button.h"
+#include "cue_timeline.h"
+#include "cue_tracks.h"
 #include "effect_engine.h"
 #include "led_controller.h"
 #include "power_manager.h"
@@ -38,6 +42,24 @@ static void start_current_preset(void)
   }
 }
 
+#ifdef CONFIG_APP_CUE_TIMELINE
+/* 曲のキューを実行 (通常モードのときだけ, プレビュー中は上書きしない) */
+static void on_cue(const struct preset_data * effect)
+{
+  if (current_state == APP_STATE_NORMAL && !preview_is_active()) {
+    effect_engine_set(effect);
+  }
+}
+
+/* 曲の同期が切れたら選択中のプリセットに戻す */
+static void on_cue_release(void)
+{
+  if (current_state == APP_STATE_NORMAL && !preview_is_active()) {
+    start_current_preset();
+  }
+}
+#endif
+
 /* プレビュー終了コールバック */
 static void on_preview_exit(void)
 {
@@ -85,6 +107,9 @@ static void on_button_event(enum button_id btn, enum button_event evt)
           LOG_INF("Entering sleep mode");
           current_state = APP_STATE_SLEEP;
           effect_engine_stop();
+#ifdef CONFIG_APP_AUDIO_PIPELINE
+          audio_pipeline_stop();
+#endif
           ble_stop_advertising();
           power_enter_sleep();
           /* Note: power_enter_sleep()から戻らない */
@@ -162,6 +187,30 @@ static int app_init(void)
     return ret;
   }
 
+#ifdef CONFIG_APP_AUDIO_PIPELINE
+  /* Audio Pipeline初期化 (マイクなしでも動作可能) */
+  ret = audio_pipeline_init();
+  if (ret < 0) {
+    LOG_ERR("Audio pipeline init failed: %d", ret);
+  }
+#ifdef CONFIG_APP_AUDIO_MATCH
+  ret = audio_match_init();
+  if (ret < 0) {
+    LOG_ERR("Audio match init failed: %d", ret);
+  }
+#ifdef CONFIG_APP_CUE_TIMELINE
+  ret = cue_timeline_init(cue_tracks, cue_track_count);
+  if (ret < 0) {
+    LOG_ERR("Cue timeline init failed: %d", ret);
+  } else {
+    cue_timeline_set_fire_callback(on_cue);
+    cue_timeline_set_release_callback(on_cue_release);
+    audio_match_set_callback(cue_timeline_on_match);
+  }
+#endif
+#endif
+#endif
+
   LOG_INF("Penlight initialized");
   return 0;
 }
@@ -189,6 +238,14 @@ int main(void)
   /* バッテリー監視開始 */
   power_start_battery_monitor();
 
+#ifdef CONFIG_APP_AUDIO_PIPELINE
+  /* 音声解析開始 */
+  ret = audio_pipeline_start();
+  if (ret < 0) {
+    LOG_ERR("Audio pipeline start failed: %d", ret);
+  }
+#endif
+
   /* 初期プリセットでエフェクト開始 */
   current_state = APP_STATE_NORMAL;
   start_current_preset();
@@ -0,0 +1,45 @@
+/*
+ * Sliding Window - ミラーリングされたリングバッファによる解析窓
+ */
+
+#include "sliding_window.h"
+
+#include <string.h>
+
+void sliding_window_init(struct sliding_window * sw, int16_t * storage, size_t size)
+{
+  sw->buf = storage;
+  sw->size = size;
+  sliding_window_reset(sw);
+}
+
+void sliding_window_reset(struct sliding_window * sw)
+{
+  memset(sw->buf, 0, 2 * sw->size * sizeof(int16_t));
+  sw->pos = 0;
+  sw->filled = 0;
+}
+
+void sliding_window_write(struct sliding_window * sw, const int16_t * samples, size_t count)
+{
+  while (count > 0) {
+    /* リング終端で分割 */
+    size_t chunk = sw->size - sw->pos;
+    if (chunk > count) {
+      chunk = count;
+    }
+
+    /* リング本体とミラーの両方に書き込む */
+    memcpy(&sw->buf[sw->pos], samples, chunk * sizeof(int16_t));
+    memcpy(&sw->buf[sw->pos + sw->size], samples, chunk * sizeof(int16_t));
+
+    sw->pos = (sw->pos + chunk) % sw->size;
+    samples += chunk;
+    count -= chunk;
+
+    sw->filled += chunk;
+    if (sw->filled > sw->size) {
+      sw->filled = sw->size;
+    }
+  }
+}
@@ -0,0 +1,67 @@
+/*
+ * Sliding Window - ミラーリングされたリングバッファによる解析窓
+ *
+ * 各サンプルをリングとそのミラー (リング長だけ後ろ) の2箇所に書き込むことで、
+ * 直近window_sizeサンプルが常に連続したメモリとして参照できる。
+ * 窓の取り出しはポインタ計算のみでコピーは発生しない。
+ */
+
+#ifndef SLIDING_WINDOW_H
+#define SLIDING_WINDOW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/toolchain.h>
+
+struct sliding_window
+{
+  int16_t * buf;      /* 2 * size サンプル */
+  size_t size;        /* 窓長 (サンプル) */
+  size_t pos;         /* 次の書き込み位置 = 最古サンプルの位置 */
+  size_t filled;      /* 書き込み済みサンプル数 (size で飽和) */
+};
+
+/* 窓長 size 用のストレージを静的に確保 */
+#define SLIDING_WINDOW_STORAGE_DEFINE(name, size) static int16_t name[2 * (size)] __aligned(8)
+
+/**
+ * @brief スライディングウィンドウを初期化
+ * @param sw 対象
+ * @param storage 2 * size サンプルのバッファ
+ * @param size 窓長 (サンプル)
+ */
+void sliding_window_init(struct sliding_window * sw, int16_t * storage, size_t size);
+
+/**
+ * @brief サンプルを追加 (最古のサンプルから上書き)
+ * @param sw 対象
+ * @param samples 追加するサンプル
+ * @param count サンプル数 (size以下)
+ */
+void sliding_window_write(struct sliding_window * sw, const int16_t * samples, size_t count);
+
+/**
+ * @brief 直近 size サンプルの先頭 (古い順に連続)
+ * @param sw 対象
+ * @return 窓の先頭ポインタ, 次のsliding_window_write()まで有効
+ */
+static inline const int16_t * sliding_window_get(const struct sliding_window * sw)
+{
+  return &sw->buf[sw->pos];
+}
+
+/**
+ * @brief 窓全体が書き込み済みかどうか
+ */
+static inline bool sliding_window_is_full(const struct sliding_window * sw)
+{
+  return sw->filled == sw->size;
+}
+
+/**
+ * @brief 書き込み済みサンプルを破棄
+ */
+void sliding_window_reset(struct sliding_window * sw);
+
+#endif /* SLIDING_WINDOW_H */